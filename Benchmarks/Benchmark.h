@@ -0,0 +1,256 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+
+/// Summary:
+///     Keeps the compiler from discarding a value that a benchmark computes but never uses.
+template<typename T>
+inline void do_not_optimize(const T& value)
+{
+#if defined(__GNUC__)
+    asm volatile("" : : "r"(&value) : "memory");
+#else
+    static const void* volatile sink;
+    sink = &value;
+#endif
+}
+
+// Runs the measured operation the given number of times
+typedef std::function<void(uint64_t iterations)> benchmark_body_t;
+
+// Prepares a benchmark and returns its body. The setup and the teardown of the captured state are not measured.
+typedef std::function<benchmark_body_t()> benchmark_factory_t;
+
+struct BenchmarkResult
+{
+    std::string Name;
+    uint64_t Iterations;            // Operations per repetition
+    size_t Repetitions;
+    double NanosecondsPerOp;        // Median over the repetitions
+    double MinNanosecondsPerOp;
+    double MaxNanosecondsPerOp;
+};
+
+/// Summary:
+///     A minimal benchmark runner.
+///     Each benchmark is calibrated until one repetition runs for at least the minimum time, then repeated
+///     and reported as the median time per operation. The results can be written as JSON so runs of
+///     different builds can be compared with a script.
+class BenchmarkRegistry
+{
+    struct Entry
+    {
+        std::string Name;
+        benchmark_factory_t Factory;
+    };
+
+    std::vector<Entry> entries;
+
+    BenchmarkRegistry() {}
+
+    // no copies allowed
+    BenchmarkRegistry(const BenchmarkRegistry&);
+    BenchmarkRegistry& operator = (const BenchmarkRegistry&);
+
+    typedef std::chrono::steady_clock clock_t;
+
+    static double ElapsedNanoseconds(const benchmark_body_t& body, uint64_t iterations)
+    {
+        auto start = clock_t::now();
+        body(iterations);
+        auto elapsed = clock_t::now() - start;
+        return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+
+    static std::string JsonEscape(const std::string& text)
+    {
+        std::string escaped;
+        for (auto c : text)
+        {
+            if ('"' == c || '\\' == c)
+                escaped.append(1, '\\').append(1, c);
+            else if (static_cast<unsigned char>(c) < 0x20)
+                escaped.append(" ");
+            else
+                escaped.append(1, c);
+        }
+        return escaped;
+    }
+
+    static std::string CompilerVersion()
+    {
+#if defined(__clang__)
+        return std::string("clang ") + __clang_version__;
+#elif defined(__GNUC__)
+        return std::string("gcc ") + __VERSION__;
+#elif defined(_MSC_VER)
+        char version[32];
+        snprintf(version, sizeof(version), "msvc %d", _MSC_FULL_VER);
+        return version;
+#else
+        return "unknown";
+#endif
+    }
+
+public:
+    struct Options
+    {
+        Options() : MinTimeMilliseconds(50), Repetitions(5), ListOnly(false) {}
+
+        std::string Filter;         // Only benchmarks whose name contains this text are run
+        std::string JsonPath;       // Where to write the results, nothing is written if empty
+        double MinTimeMilliseconds; // Minimum duration of one repetition
+        size_t Repetitions;
+        bool ListOnly;
+    };
+
+    static BenchmarkRegistry& Instance()
+    {
+        static BenchmarkRegistry instance;
+        return instance;
+    }
+
+    void Add(const std::string& name, benchmark_factory_t factory)
+    {
+        Entry entry = { name, std::move(factory) };
+        entries.push_back(std::move(entry));
+    }
+
+    BenchmarkResult Run(const std::string& name, const benchmark_factory_t& factory, const Options& options) const
+    {
+        auto body = factory();
+        const double minTime = options.MinTimeMilliseconds * 1e6;
+
+        // Grow the iteration count until a single repetition is long enough to time reliably
+        uint64_t iterations = 1;
+        double elapsed = ElapsedNanoseconds(body, iterations);
+        while (elapsed < minTime && iterations < (1ull << 40))
+        {
+            double scale = (elapsed > 0.0) ? std::min<double>(minTime * 1.2 / elapsed, 10.0) : 10.0;
+            iterations = std::max<uint64_t>(iterations + 1, static_cast<uint64_t>(iterations * scale));
+            elapsed = ElapsedNanoseconds(body, iterations);
+        }
+
+        std::vector<double> samples;
+        for (size_t i = 0; i < std::max<size_t>(options.Repetitions, 1); ++i)
+            samples.push_back(ElapsedNanoseconds(body, iterations) / iterations);
+        std::sort(samples.begin(), samples.end());
+
+        BenchmarkResult result;
+        result.Name = name;
+        result.Iterations = iterations;
+        result.Repetitions = samples.size();
+        result.NanosecondsPerOp = (samples.size() % 2) ? samples[samples.size() / 2] : (samples[samples.size() / 2 - 1] + samples[samples.size() / 2]) / 2.0;
+        result.MinNanosecondsPerOp = samples.front();
+        result.MaxNanosecondsPerOp = samples.back();
+        return result;
+    }
+
+    std::vector<BenchmarkResult> RunAll(const Options& options) const
+    {
+        std::vector<BenchmarkResult> results;
+        for (auto& entry : entries)
+        {
+            if (!options.Filter.empty() && std::string::npos == entry.Name.find(options.Filter))
+                continue;
+            if (options.ListOnly)
+            {
+                printf("%s\n", entry.Name.c_str());
+                continue;
+            }
+            auto result = Run(entry.Name, entry.Factory, options);
+            printf("%-56s %14.1f ns/op  (min %.1f, max %.1f, %llu iterations)\n", result.Name.c_str(), result.NanosecondsPerOp,
+                result.MinNanosecondsPerOp, result.MaxNanosecondsPerOp, static_cast<unsigned long long>(result.Iterations));
+            fflush(stdout);
+            results.push_back(result);
+        }
+        return results;
+    }
+
+    static bool WriteJson(const std::string& path, const std::vector<BenchmarkResult>& results, const Options& options)
+    {
+        FILE* file = fopen(path.c_str(), "w");
+        if (nullptr == file)
+            return false;
+
+        char timestamp[32] = "";
+        time_t now = time(nullptr);
+        strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+        fprintf(file, "{\n  \"context\": {\n");
+        fprintf(file, "    \"date\": \"%s\",\n", timestamp);
+        fprintf(file, "    \"compiler\": \"%s\",\n", JsonEscape(CompilerVersion()).c_str());
+#if defined(BENCHMARK_BUILD_FLAGS)
+        fprintf(file, "    \"build_flags\": \"%s\",\n", JsonEscape(BENCHMARK_BUILD_FLAGS).c_str());
+#endif
+        fprintf(file, "    \"min_time_ms\": %g,\n", options.MinTimeMilliseconds);
+        fprintf(file, "    \"repetitions\": %u\n  },\n", static_cast<unsigned>(options.Repetitions));
+        fprintf(file, "  \"benchmarks\": [\n");
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            auto& result = results[i];
+            fprintf(file, "    {\"name\": \"%s\", \"iterations\": %llu, \"repetitions\": %u, \"ns_per_op\": %.3f, \"min_ns_per_op\": %.3f, \"max_ns_per_op\": %.3f}%s\n",
+                JsonEscape(result.Name).c_str(), static_cast<unsigned long long>(result.Iterations), static_cast<unsigned>(result.Repetitions),
+                result.NanosecondsPerOp, result.MinNanosecondsPerOp, result.MaxNanosecondsPerOp, (i + 1 < results.size()) ? "," : "");
+        }
+        fprintf(file, "  ]\n}\n");
+        return 0 == fclose(file);
+    }
+
+    /// Summary:
+    ///     Parses the command line, runs the selected benchmarks and writes the results.
+    ///     Arguments: [--filter <text>] [--json <file>] [--min-time <ms>] [--repetitions <n>] [--list]
+    /// Returns:
+    ///     The process exit code
+    int Main(int argc, char* argv[]) const
+    {
+        Options options;
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg(argv[i]);
+            bool hasValue = i + 1 < argc;
+            if ("--filter" == arg && hasValue)
+                options.Filter = argv[++i];
+            else if ("--json" == arg && hasValue)
+                options.JsonPath = argv[++i];
+            else if ("--min-time" == arg && hasValue)
+                options.MinTimeMilliseconds = atof(argv[++i]);
+            else if ("--repetitions" == arg && hasValue)
+                options.Repetitions = static_cast<size_t>(atoi(argv[++i]));
+            else if ("--list" == arg)
+                options.ListOnly = true;
+            else
+            {
+                fprintf(stderr, "usage: %s [--filter <text>] [--json <file>] [--min-time <ms>] [--repetitions <n>] [--list]\n", argv[0]);
+                return 2;
+            }
+        }
+
+        auto results = RunAll(options);
+        if (!options.JsonPath.empty() && !WriteJson(options.JsonPath, results, options))
+        {
+            fprintf(stderr, "Unable to write %s\n", options.JsonPath.c_str());
+            return 1;
+        }
+        return 0;
+    }
+};
+
+/// Summary:
+///     Registers a benchmark at static initialization time.
+struct BenchmarkRegistration
+{
+    BenchmarkRegistration(const std::string& name, benchmark_factory_t factory)
+    {
+        BenchmarkRegistry::Instance().Add(name, std::move(factory));
+    }
+};
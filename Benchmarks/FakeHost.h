@@ -0,0 +1,624 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include "SpotPlugin.h"
+#include "PluginHost.h"
+
+/// Summary:
+///     An in-process stand-in for the SPOT host application.
+///     It answers host actions from an in-memory variable store and an event binding table so the
+///     HostInterop headers can be exercised without the application, e.g. by the benchmarks.
+///     Variables follow the same rules as the real host: text values are copied into the buffer of the
+///     plug-in and report their full length to GetSetVariableVersion::TextLength messages, handles
+///     are returned by ResolveVariable and bulk transfers report a status per entry.
+///     Live mode produces synthetic frames that are sent with HostEvent::LiveFrameReady by RaiseLiveFrame()
+///     and SetActiveImage() opens a synthetic image document that can be borrowed with AcquireImageView.
+///     SetActiveSequence() opens a sequence of such images whose frames are switched with ShowSequenceFrame.
+///     SaveVariable rewrites the whole file on every call and RecallVariable reads it, as the host does.
+///     The fake host is single threaded just like the host UI thread it replaces.
+class FakeHost
+{
+public:
+    typedef SpotPluginApi::msg_get_set_variable_t::VariableType data_type_t;
+
+    struct StoredVariable
+    {
+        StoredVariable() : DataType(SpotPluginApi::msg_get_set_variable_t::Unknown), NumericValue(0.0), BoolValue(false), ReadOnly(false) {}
+
+        data_type_t DataType;
+        double NumericValue;
+        bool BoolValue;
+        std::string TextValue;
+        bool ReadOnly;
+    };
+
+private:
+    struct Binding
+    {
+        SpotPluginApi::host_event_t HostEvent;
+        SpotPluginApi::event_handler_t EventHandler;
+        uintptr_t UserData;
+    };
+
+    std::vector<StoredVariable> variables;                  // A handle is the position in this array plus one
+    std::unordered_map<std::string, size_t> variableByName;
+    std::vector<Binding> bindings;
+    std::vector<SpotPluginApi::host_event_t> unknownEvents;   // Events this host refuses to bind
+    std::map<std::string, StoredVariable> savedVariables;   // Keyed by file path and variable name
+    uint64_t actionCount;
+    bool bulkSupported;
+
+    enum class LiveState { Ended, Running, Paused };
+    LiveState liveState;
+    SpotPluginApi::live_frame_t liveFrame;
+    std::vector<uint8_t> livePixels;
+    bool animateLiveFrames;
+    std::chrono::steady_clock::time_point liveStartTime;
+
+    bool hasActiveImage;
+    SpotPluginApi::msg_image_view_t activeImage;        // Describes the pixels of the active image document
+    std::vector<uint8_t> imagePixels;
+    std::vector<uintptr_t> imageViewTokens;             // Views that have not been released
+    uintptr_t writeViewToken;                           // The view acquired for writing or zero
+    uintptr_t lastImageViewToken;
+    uint32_t sequenceLength;                            // Frames of the active image, zero for a single image
+    std::chrono::microseconds sequenceFrameLatency;     // Time ShowSequenceFrame takes, like reading a frame from disk
+
+    FakeHost() : actionCount(0), bulkSupported(true), liveState(LiveState::Ended), animateLiveFrames(true),
+        hasActiveImage(false), writeViewToken(0), lastImageViewToken(0), sequenceLength(0), sequenceFrameLatency(0)
+    {
+        ConfigureLive(640, 480, 8, SpotPluginApi::ChannelLayout::Mono);
+    }
+
+    // no copies allowed
+    FakeHost(const FakeHost&);
+    FakeHost& operator = (const FakeHost&);
+
+    static std::string VariableKey(const char* name, const char* dialogName)
+    {
+        std::string key(name ? name : "");
+        if (dialogName)
+            key.append(1, '\n').append(dialogName);
+        return key;
+    }
+
+    StoredVariable& Define(const char* name, data_type_t dataType, bool readOnly)
+    {
+        auto inserted = variableByName.insert(std::make_pair(std::string(name), variables.size()));
+        if (inserted.second)
+            variables.push_back(StoredVariable());
+        auto& variable = variables[inserted.first->second];
+        variable = StoredVariable();
+        variable.DataType = dataType;
+        variable.ReadOnly = readOnly;
+        return variable;
+    }
+
+    StoredVariable* Find(const SpotPluginApi::msg_get_set_variable_entry_t& msg, uintptr_t handle)
+    {
+        if (msg.Version >= SpotPluginApi::GetSetVariableVersion::Handle && 0 != handle)
+            return (handle <= variables.size()) ? &variables[handle - 1] : nullptr;
+        if (nullptr == msg.VariableName)
+            return nullptr;
+        auto item = msg.DialogName ? variableByName.find(VariableKey(msg.VariableName, msg.DialogName)) : variableByName.find(msg.VariableName);
+        return (variableByName.end() == item) ? nullptr : &variables[item->second];
+    }
+
+    SpotPluginApi::variable_status_t GetVariable(SpotPluginApi::msg_get_set_variable_entry_t& msg, uintptr_t handle)
+    {
+        using namespace SpotPluginApi;
+        auto variable = Find(msg, handle);
+        if (nullptr == variable)
+            return VariableStatus::NotFound;
+        if (variable->DataType != msg.DataType)
+            return VariableStatus::TypeMismatch;
+
+        switch (msg.DataType)
+        {
+        case msg_get_set_variable_t::Numeric:
+            msg.NumericValue = variable->NumericValue;
+            return VariableStatus::Ok;
+        case msg_get_set_variable_t::Bool:
+            msg.BoolValue = variable->BoolValue ? 1 : 0;
+            return VariableStatus::Ok;
+        case msg_get_set_variable_t::Text:
+            {
+                const auto& value = variable->TextValue;
+                bool truncated = value.size() > msg.TextValue.Length;
+                if (nullptr != msg.TextValue.Text)
+                {
+                    auto copied = std::min<size_t>(value.size(), msg.TextValue.Length);
+                    memcpy(msg.TextValue.Text, value.data(), copied);
+                    msg.TextValue.Text[copied] = '\0';
+                    if (msg.Version < GetSetVariableVersion::TextLength)
+                        msg.TextValue.Length = copied;
+                }
+                if (msg.Version >= GetSetVariableVersion::TextLength)
+                    msg.TextValue.Length = value.size();
+                return truncated ? VariableStatus::Truncated : VariableStatus::Ok;
+            }
+        default:
+            return VariableStatus::TypeMismatch;
+        }
+    }
+
+    SpotPluginApi::variable_status_t SetVariable(const SpotPluginApi::msg_get_set_variable_entry_t& msg, uintptr_t handle)
+    {
+        using namespace SpotPluginApi;
+        auto variable = Find(msg, handle);
+        if (nullptr == variable)
+            return VariableStatus::NotFound;
+        if (variable->DataType != msg.DataType)
+            return VariableStatus::TypeMismatch;
+        if (variable->ReadOnly)
+            return VariableStatus::ReadOnly;
+
+        switch (msg.DataType)
+        {
+        case msg_get_set_variable_t::Numeric:
+            variable->NumericValue = msg.NumericValue;
+            return VariableStatus::Ok;
+        case msg_get_set_variable_t::Bool:
+            variable->BoolValue = 0 != msg.BoolValue;
+            return VariableStatus::Ok;
+        case msg_get_set_variable_t::Text:
+            variable->TextValue.assign(msg.TextValue.Text, msg.TextValue.Length);
+            return VariableStatus::Ok;
+        default:
+            return VariableStatus::TypeMismatch;
+        }
+    }
+
+    bool TransferVariables(bool isWrite, SpotPluginApi::msg_get_set_variable_list_t& list)
+    {
+        if (!bulkSupported)
+            return false;
+        bool hasHandles = list.Version >= SpotPluginApi::GetSetVariableListVersion::HandleList && nullptr != list.HandleList;
+        for (size_t i = 0; i < list.VariableListLength; ++i)
+        {
+            auto handle = hasHandles ? list.HandleList[i] : 0;
+            list.StatusList[i] = isWrite ? SetVariable(list.VariableList[i], handle) : GetVariable(list.VariableList[i], handle);
+        }
+        return true;
+    }
+
+    bool ResolveVariable(SpotPluginApi::msg_get_set_variable_t& msg)
+    {
+        auto variable = Find(msg, 0);
+        if (nullptr == variable)
+            return false;
+        msg.Handle = static_cast<uintptr_t>(variable - variables.data()) + 1;
+        return true;
+    }
+
+    bool BindEventHandler(const SpotPluginApi::msg_event_handler_binding_t& msg)
+    {
+        for (size_t i = 0; i < msg.EventSourceListLength; ++i)
+        {
+            if (unknownEvents.end() != std::find(unknownEvents.begin(), unknownEvents.end(), msg.HostEventSourceList[i]))
+                return false;
+        }
+        for (size_t i = 0; i < msg.EventSourceListLength; ++i)
+        {
+            Binding binding = { msg.HostEventSourceList[i], msg.EventHandler, msg.UserData };
+            UnbindEventHandler(binding.HostEvent, binding.UserData);
+            bindings.push_back(binding);
+        }
+        return true;
+    }
+
+    void UnbindEventHandler(SpotPluginApi::host_event_t hostEvent, uintptr_t userData)
+    {
+        bindings.erase(std::remove_if(bindings.begin(), bindings.end(), [=] (const Binding& item) { return item.HostEvent == hostEvent && item.UserData == userData; }), bindings.end());
+    }
+
+    void SetStoredValue(const char* name, double numericValue, bool boolValue)
+    {
+        auto item = variableByName.find(name);
+        if (variableByName.end() == item)
+            return;
+        variables[item->second].NumericValue = numericValue;
+        variables[item->second].BoolValue = boolValue;
+    }
+
+    bool SetLiveState(LiveState state)
+    {
+        if (LiveState::Ended == liveState && LiveState::Running == state)
+        {
+            liveFrame.FrameIndex = 0;
+            liveStartTime = std::chrono::steady_clock::now();
+            SetStoredValue("LiveImgCount", 0.0, false);
+        }
+        liveState = state;
+        SetStoredValue("LiveImgOpen", 0.0, LiveState::Ended != state);
+        SetStoredValue("LiveImgRunning", 0.0, LiveState::Running == state);
+        return true;
+    }
+
+    static uint32_t ChannelCount(SpotPluginApi::channel_layout_t layout)
+    {
+        using namespace SpotPluginApi;
+        switch (layout)
+        {
+        case ChannelLayout::RGB:
+        case ChannelLayout::BGR:
+            return 3;
+        case ChannelLayout::RGBA:
+        case ChannelLayout::BGRA:
+            return 4;
+        default:
+            return 1;
+        }
+    }
+
+    // Rows are padded to a multiple of 64 bytes so the stride differs from the row size
+    static intptr_t PaddedStride(uint32_t width, uint32_t bitDepth, SpotPluginApi::channel_layout_t layout)
+    {
+        size_t rowBytes = static_cast<size_t>(width) * ChannelCount(layout) * ((bitDepth <= 8) ? 1 : 2);
+        return static_cast<intptr_t>((rowBytes + 63) & ~static_cast<size_t>(63));
+    }
+
+    // Draws a diagonal ramp that starts at offset
+    static void DrawRamp(uint8_t* pixels, uint32_t width, uint32_t height, intptr_t stride, uint32_t bitDepth, SpotPluginApi::channel_layout_t layout, uint32_t offset)
+    {
+        uint32_t samplesPerRow = width * ChannelCount(layout);
+        uint32_t mask = (1u << bitDepth) - 1;
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            auto row = pixels + y * stride;
+            if (bitDepth <= 8)
+            {
+                for (uint32_t i = 0; i < samplesPerRow; ++i)
+                    row[i] = static_cast<uint8_t>((i + y + offset) & mask);
+            }
+            else
+            {
+                auto samples = reinterpret_cast<uint16_t*>(row);
+                for (uint32_t i = 0; i < samplesPerRow; ++i)
+                    samples[i] = static_cast<uint16_t>((i + y + offset) & mask);
+            }
+        }
+    }
+
+    // The ramp moves by one sample per frame
+    void DrawLiveFrame()
+    {
+        DrawRamp(livePixels.data(), liveFrame.Width, liveFrame.Height, liveFrame.Stride, liveFrame.BitDepth, liveFrame.ChannelLayout, static_cast<uint32_t>(liveFrame.FrameIndex));
+    }
+
+    bool AcquireImageView(SpotPluginApi::msg_image_view_t& msg)
+    {
+        using namespace SpotPluginApi;
+        if (!hasActiveImage || writeViewToken != 0)
+            return false;
+        if (ImageViewAccess::ReadWrite == msg.Access && !imageViewTokens.empty())
+            return false;
+        msg.Token = ++lastImageViewToken;
+        msg.Pixels = imagePixels.data();
+        msg.Width = activeImage.Width;
+        msg.Height = activeImage.Height;
+        msg.Stride = activeImage.Stride;
+        msg.BitDepth = activeImage.BitDepth;
+        msg.ChannelLayout = activeImage.ChannelLayout;
+        imageViewTokens.push_back(msg.Token);
+        if (ImageViewAccess::ReadWrite == msg.Access)
+            writeViewToken = msg.Token;
+        return true;
+    }
+
+    // Frames differ by the start of the ramp and by their sensor temperature
+    bool ShowSequenceFrame(uintptr_t index)
+    {
+        if (!hasActiveImage || index >= sequenceLength || !imageViewTokens.empty())
+            return false;
+        if (sequenceFrameLatency.count() > 0)
+            std::this_thread::sleep_for(sequenceFrameLatency);
+        DrawRamp(imagePixels.data(), activeImage.Width, activeImage.Height, activeImage.Stride, activeImage.BitDepth, activeImage.ChannelLayout, static_cast<uint32_t>(index));
+        SetStoredValue("ImgSeqIdx", static_cast<double>(index), false);
+        SetStoredValue("ImgSensorTemp", 20.0 + 0.125 * index, false);
+        return true;
+    }
+
+    bool ReleaseImageView(const SpotPluginApi::msg_image_view_t& msg)
+    {
+        auto item = std::find(imageViewTokens.begin(), imageViewTokens.end(), msg.Token);
+        if (imageViewTokens.end() == item)
+            return false;
+        imageViewTokens.erase(item);
+        if (writeViewToken == msg.Token)
+            writeViewToken = 0;
+        return true;
+    }
+
+    bool SaveVariable(const SpotPluginApi::msg_save_recall_variable_t& msg)
+    {
+        auto item = variableByName.find(VariableKey(msg.VariableName, msg.DialogName));
+        if (variableByName.end() == item || nullptr == msg.FilePath)
+            return false;
+        auto prefix = std::string(msg.FilePath).append(1, '\n');
+        savedVariables[prefix + item->first] = variables[item->second];
+        auto file = fopen(msg.FilePath, "wb");
+        if (nullptr == file)
+            return false;
+        for (auto saved = savedVariables.lower_bound(prefix); savedVariables.end() != saved && 0 == saved->first.compare(0, prefix.size(), prefix); ++saved)
+        {
+            auto& value = saved->second;
+            fprintf(file, "%s=%d,%.17g,%d,%s\n", saved->first.c_str() + prefix.size(), static_cast<int>(value.DataType), value.NumericValue, value.BoolValue ? 1 : 0, value.TextValue.c_str());
+        }
+        return 0 == fclose(file);
+    }
+
+    bool RecallVariable(const SpotPluginApi::msg_save_recall_variable_t& msg)
+    {
+        auto item = variableByName.find(VariableKey(msg.VariableName, msg.DialogName));
+        if (variableByName.end() == item || nullptr == msg.FilePath)
+            return false;
+        auto file = fopen(msg.FilePath, "rb");
+        if (nullptr == file)
+            return false;
+        char buffer[4096];
+        while (fread(buffer, 1, sizeof(buffer), file) == sizeof(buffer))
+        {
+        }
+        fclose(file);
+        auto saved = savedVariables.find(std::string(msg.FilePath).append(1, '\n').append(item->first));
+        if (savedVariables.end() == saved)
+            return false;
+        variables[item->second] = saved->second;
+        return true;
+    }
+
+public:
+    static FakeHost& Instance()
+    {
+        static FakeHost instance;
+        return instance;
+    }
+
+    // Routes all host actions of PluginHost::DoAction to this object
+    void Install()
+    {
+        PluginHost::ActionFunc = &FakeHost::ActionFunc;
+        PluginHost::pluginHandle = reinterpret_cast<uintptr_t>(this);
+    }
+
+    // Removes all variables, bindings and saved values and resets the counters
+    void Reset()
+    {
+        variables.clear();
+        variableByName.clear();
+        bindings.clear();
+        unknownEvents.clear();
+        savedVariables.clear();
+        actionCount = 0;
+        bulkSupported = true;
+        liveState = LiveState::Ended;
+        hasActiveImage = false;
+        imagePixels.clear();
+        imageViewTokens.clear();
+        writeViewToken = 0;
+        sequenceLength = 0;
+        sequenceFrameLatency = std::chrono::microseconds(0);
+    }
+
+    void DefineText(const char* name, const std::string& value, bool readOnly = false)
+    {
+        Define(name, SpotPluginApi::msg_get_set_variable_t::Text, readOnly).TextValue = value;
+    }
+
+    void DefineNumeric(const char* name, double value, bool readOnly = false)
+    {
+        Define(name, SpotPluginApi::msg_get_set_variable_t::Numeric, readOnly).NumericValue = value;
+    }
+
+    void DefineBool(const char* name, bool value, bool readOnly = false)
+    {
+        Define(name, SpotPluginApi::msg_get_set_variable_t::Bool, readOnly).BoolValue = value;
+    }
+
+    // Returns the stored variable or nullptr if no variable has the name
+    const StoredVariable* Variable(const char* name) const
+    {
+        auto item = variableByName.find(name);
+        return (variableByName.end() == item) ? nullptr : &variables[item->second];
+    }
+
+    size_t VariableCount() const { return variables.size(); }
+
+    // Makes GetVariables and SetVariables fail like an older host without bulk support
+    void SetBulkSupported(bool supported) { bulkSupported = supported; }
+
+    // Makes every BindEventHandler that lists the event fail like an older host that does not know it
+    void SetEventUnknown(SpotPluginApi::host_event_t hostEvent) { unknownEvents.push_back(hostEvent); }
+
+    /// Summary:
+    ///     Calls every event handler bound to hostEvent the way the host does on its UI thread.
+    /// Returns:
+    ///     The number of handlers called
+    size_t Raise(SpotPluginApi::host_event_t hostEvent, uintptr_t args = 0)
+    {
+        size_t called = 0;
+        // Handlers may bind or unbind while the event is raised, so the table is not iterated directly
+        for (size_t i = 0; i < bindings.size(); ++i)
+        {
+            auto binding = bindings[i];
+            if (binding.HostEvent != hostEvent)
+                continue;
+            binding.EventHandler(hostEvent, args, binding.UserData);
+            ++called;
+        }
+        return called;
+    }
+
+    size_t BindingCount(SpotPluginApi::host_event_t hostEvent) const
+    {
+        return std::count_if(bindings.begin(), bindings.end(), [=] (const Binding& item) { return item.HostEvent == hostEvent; });
+    }
+
+    /// Summary:
+    ///     Sets the format of the synthetic live frames. Rows are padded to a multiple of 64 bytes so the
+    ///     stride differs from the row size. With animate set the pixels are redrawn for every frame,
+    ///     otherwise they are drawn once here, which keeps the cost of RaiseLiveFrame to the event itself.
+    void ConfigureLive(uint32_t width, uint32_t height, uint32_t bitDepth, SpotPluginApi::channel_layout_t layout, bool animate = true)
+    {
+        using namespace SpotPluginApi;
+        liveFrame = live_frame_t();
+        liveFrame.Version = LiveFrameVersion::Initial;
+        liveFrame.Width = width;
+        liveFrame.Height = height;
+        liveFrame.Stride = PaddedStride(width, bitDepth, layout);
+        liveFrame.BitDepth = bitDepth;
+        liveFrame.ChannelLayout = layout;
+        livePixels.assign(liveFrame.Stride * height, 0);
+        liveFrame.Pixels = livePixels.data();
+        animateLiveFrames = animate;
+        DrawLiveFrame();
+    }
+
+    bool IsLiveRunning() const { return LiveState::Running == liveState; }
+
+    /// Summary:
+    ///     Acquires the next synthetic frame and raises HostEvent::LiveFrameReady with it, but only while live
+    ///     mode runs (HostActionRequest::StartLive). LiveImgCount is updated like the real host does.
+    /// Returns:
+    ///     The number of handlers called
+    size_t RaiseLiveFrame()
+    {
+        if (LiveState::Running != liveState)
+            return 0;
+        if (animateLiveFrames)
+            DrawLiveFrame();
+        liveFrame.Timestamp = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - liveStartTime).count());
+        auto called = Raise(SpotPluginApi::HostEvent::LiveFrameReady, reinterpret_cast<uintptr_t>(&liveFrame));
+        ++liveFrame.FrameIndex;
+        SetStoredValue("LiveImgCount", static_cast<double>(liveFrame.FrameIndex), false);
+        return called;
+    }
+
+    /// Summary:
+    ///     Opens a synthetic image document with a ramp pattern, gives it focus and raises HostEvent::ImageDocChanged.
+    ///     Like the real host the document can not change while a view of it is held.
+    /// Returns:
+    ///     false if a view of the current document has not been released
+    bool SetActiveImage(uint32_t width, uint32_t height, uint32_t bitDepth, SpotPluginApi::channel_layout_t layout)
+    {
+        if (!imageViewTokens.empty())
+            return false;
+        activeImage = SpotPluginApi::msg_image_view_t();
+        activeImage.Width = width;
+        activeImage.Height = height;
+        activeImage.Stride = PaddedStride(width, bitDepth, layout);
+        activeImage.BitDepth = bitDepth;
+        activeImage.ChannelLayout = layout;
+        imagePixels.assign(activeImage.Stride * height, 0);
+        DrawRamp(imagePixels.data(), width, height, activeImage.Stride, bitDepth, layout, 0);
+        hasActiveImage = true;
+        sequenceLength = 0;
+        SetStoredValue("ImgSeqLen", 0.0, false);
+        SetStoredValue("ImgSeqIdx", 0.0, false);
+        Raise(SpotPluginApi::HostEvent::ImageDocChanged);
+        return true;
+    }
+
+    /// Summary:
+    ///     Opens a synthetic image sequence of length frames like SetActiveImage and shows its first frame.
+    ///     HostActionRequest::ShowSequenceFrame switches frames and waits for frameLatency first.
+    bool SetActiveSequence(uint32_t length, uint32_t width, uint32_t height, uint32_t bitDepth, SpotPluginApi::channel_layout_t layout,
+        std::chrono::microseconds frameLatency = std::chrono::microseconds(0))
+    {
+        if (!SetActiveImage(width, height, bitDepth, layout))
+            return false;
+        sequenceLength = length;
+        sequenceFrameLatency = frameLatency;
+        SetStoredValue("ImgSeqLen", static_cast<double>(length), false);
+        return true;
+    }
+
+    // Closes the active image document. Returns false if a view of it has not been released.
+    bool CloseActiveImage()
+    {
+        if (!imageViewTokens.empty())
+            return false;
+        hasActiveImage = false;
+        imagePixels.clear();
+        sequenceLength = 0;
+        Raise(SpotPluginApi::HostEvent::ImageDocChanged);
+        return true;
+    }
+
+    // The pixels of the active image document, e.g. to check what a plug-in wrote
+    uint8_t* ActiveImagePixels() { return hasActiveImage ? imagePixels.data() : nullptr; }
+
+    // The number of image views acquired and not yet released
+    size_t ImageViewCount() const { return imageViewTokens.size(); }
+
+    // The number of host actions received since the last Reset
+    uint64_t ActionCount() const { return actionCount; }
+
+    bool HandleAction(SpotPluginApi::host_action_t action, uintptr_t info, void *data)
+    {
+        using namespace SpotPluginApi;
+        ++actionCount;
+        switch (action)
+        {
+        case HostActionRequest::BindEventHandler:
+            return BindEventHandler(*static_cast<msg_event_handler_binding_t*>(data));
+        case HostActionRequest::UnbindEventHandler:
+            {
+                auto& msg = *static_cast<msg_event_handler_binding_t*>(data);
+                for (size_t i = 0; i < msg.EventSourceListLength; ++i)
+                    UnbindEventHandler(msg.HostEventSourceList[i], msg.UserData);
+                return true;
+            }
+        case HostActionRequest::GetVariable:
+            {
+                // A single message only fails if the variable can not be read at all
+                auto& msg = *static_cast<msg_get_set_variable_t*>(data);
+                auto status = GetVariable(msg, msg.Handle);
+                return VariableStatus::Ok == status || VariableStatus::Truncated == status;
+            }
+        case HostActionRequest::GetVariables:
+            return TransferVariables(false, *static_cast<msg_get_set_variable_list_t*>(data));
+        case HostActionRequest::ResolveVariable:
+            return ResolveVariable(*static_cast<msg_get_set_variable_t*>(data));
+        case HostActionRequest::SetVariable:
+            {
+                const auto& msg = *static_cast<msg_get_set_variable_t*>(data);
+                return VariableStatus::Ok == SetVariable(msg, msg.Handle);
+            }
+        case HostActionRequest::SetVariables:
+            return TransferVariables(true, *static_cast<msg_get_set_variable_list_t*>(data));
+        case HostActionRequest::SaveVariable:
+            return SaveVariable(*static_cast<msg_save_recall_variable_t*>(data));
+        case HostActionRequest::RecallVariable:
+            return RecallVariable(*static_cast<msg_save_recall_variable_t*>(data));
+        case HostActionRequest::AcquireImageView:
+            return AcquireImageView(*static_cast<msg_image_view_t*>(data));
+        case HostActionRequest::ReleaseImageView:
+            return ReleaseImageView(*static_cast<msg_image_view_t*>(data));
+        case HostActionRequest::ShowSequenceFrame:
+            return ShowSequenceFrame(info);
+        case HostActionRequest::StartLive:
+            return SetLiveState(LiveState::Running);
+        case HostActionRequest::PauseLive:
+            return (LiveState::Ended != liveState) && SetLiveState(LiveState::Paused);
+        case HostActionRequest::EndLive:
+            return SetLiveState(LiveState::Ended);
+        default:
+            return false;
+        }
+    }
+
+    static bool SPOTPLUGINAPI ActionFunc(uintptr_t pluginHandle, SpotPluginApi::host_action_t action, uintptr_t info, void *data)
+    {
+        return reinterpret_cast<FakeHost*>(pluginHandle)->HandleAction(action, info, data);
+    }
+};
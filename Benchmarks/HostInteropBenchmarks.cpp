@@ -0,0 +1,791 @@
+// Microbenchmarks of the HostInterop headers against the in-process FakeHost.
+// Build and run with "make run" in this folder. See Makefile.
+
+#include <stdlib.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include <numeric>
+#include <iterator>
+#include "Benchmark.h"
+#include "FakeHost.h"
+#include "PluginHost.h"
+#include "HostVariables.h"
+#include "EventSourceTypes.h"
+#include "EventHub.h"
+#include "MulticastEventDelegate.h"
+#include "CallbackDispatcher.h"
+#include "ImageView.h"
+#include "ImageStatistics.h"
+#include "TaskScheduler.h"
+#include "SequenceProcessor.h"
+#include "VariableJournal.h"
+#include "VariableWatcher.h"
+#include "IdleScheduler.h"
+
+// The plug-in normally defines these in PluginHost.cpp, which needs the Windows precompiled header
+SpotPluginApi::host_action_func_t PluginHost::ActionFunc = NULL;
+uintptr_t PluginHost::pluginHandle = 0;
+std::atomic<PluginHost::IHostActionObserver*> PluginHost::ActionObserver(nullptr);
+
+using namespace HostInterop;
+
+namespace
+{
+    const char* const shortTextName = "BenchShortText";
+    const char* const longTextName = "BenchLongText";
+
+    // Starts every benchmark from a host that knows the standard variables and two text variables
+    FakeHost& PrepareHost()
+    {
+        auto& host = FakeHost::Instance();
+        host.Reset();
+        host.Install();
+        for (auto variable : StandardVariables::Instance())
+        {
+            switch (variable->Type())
+            {
+            case VariableType::Bool:
+                host.DefineBool(variable->Name().c_str(), false, variable->IsReadOnly());
+                break;
+            case VariableType::Text:
+                host.DefineText(variable->Name().c_str(), "", variable->IsReadOnly());
+                break;
+            default:
+                host.DefineNumeric(variable->Name().c_str(), 0.0, variable->IsReadOnly());
+                break;
+            }
+        }
+        host.DefineText(shortTextName, "C:\\Images\\0001.tif");
+        host.DefineText(longTextName, std::string(4096, 'x'));
+        return host;
+    }
+
+    ScopeFlags ScopeOf(size_t i)
+    {
+        // Spreads the variables over one or two of the eight scope bits
+        unsigned scope = 1u << (i % 8);
+        if (0 == i % 3)
+            scope |= 1u << ((i / 8) % 8);
+        return static_cast<ScopeFlags>(scope);
+    }
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // Text variables
+
+    benchmark_factory_t GetTextVariableBenchmark(const char* name)
+    {
+        return [=] () -> benchmark_body_t
+        {
+            PrepareHost();
+            return [=] (uint64_t iterations)
+            {
+                for (uint64_t i = 0; i < iterations; ++i)
+                {
+                    auto value = GetTextVariable(name);
+                    do_not_optimize(value);
+                }
+            };
+        };
+    }
+
+    benchmark_factory_t GetTextVariableIntoBenchmark(const char* name)
+    {
+        return [=] () -> benchmark_body_t
+        {
+            PrepareHost();
+            auto value = std::make_shared<std::string>();
+            return [=] (uint64_t iterations)
+            {
+                for (uint64_t i = 0; i < iterations; ++i)
+                {
+                    GetTextVariable(name, *value);
+                    do_not_optimize(*value);
+                }
+            };
+        };
+    }
+
+    benchmark_factory_t GetFixedTextVariableBenchmark(const char* name)
+    {
+        return [=] () -> benchmark_body_t
+        {
+            PrepareHost();
+            return [=] (uint64_t iterations)
+            {
+                for (uint64_t i = 0; i < iterations; ++i)
+                {
+                    auto value = GetTextVariable<256>(name);
+                    do_not_optimize(value);
+                }
+            };
+        };
+    }
+
+    benchmark_factory_t SetTextVariableBenchmark(const char* name, size_t length)
+    {
+        return [=] () -> benchmark_body_t
+        {
+            PrepareHost();
+            auto value = std::make_shared<std::string>(length, 'y');
+            return [=] (uint64_t iterations)
+            {
+                for (uint64_t i = 0; i < iterations; ++i)
+                    SetTextVariable(name, *value);
+            };
+        };
+    }
+
+    BenchmarkRegistration getShortText("HostVariables/GetTextVariable/short", GetTextVariableBenchmark(shortTextName));
+    BenchmarkRegistration getLongText("HostVariables/GetTextVariable/4096", GetTextVariableBenchmark(longTextName));
+    BenchmarkRegistration getShortTextInto("HostVariables/GetTextVariableInto/short", GetTextVariableIntoBenchmark(shortTextName));
+    BenchmarkRegistration getLongTextInto("HostVariables/GetTextVariableInto/4096", GetTextVariableIntoBenchmark(longTextName));
+    BenchmarkRegistration getFixedShortText("HostVariables/GetTextVariable<256>/short", GetFixedTextVariableBenchmark(shortTextName));
+    BenchmarkRegistration setShortText("HostVariables/SetTextVariable/short", SetTextVariableBenchmark(shortTextName, 18));
+    BenchmarkRegistration setLongText("HostVariables/SetTextVariable/4096", SetTextVariableBenchmark(longTextName, 4096));
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // VariableManager
+
+    // Builds the same manager as VariableManager::StandardVars(), which itself is constructed only once
+    BenchmarkRegistration standardVars("VariableManager/StandardVars/construct", [] () -> benchmark_body_t
+    {
+        PrepareHost();
+        return [] (uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                VariableManager manager(StandardVariables::Instance());
+                do_not_optimize(manager);
+            }
+        };
+    });
+
+    benchmark_factory_t MatchingAnyBenchmark(size_t extraVariables, ScopeFlags withScope)
+    {
+        return [=] () -> benchmark_body_t
+        {
+            PrepareHost();
+            std::shared_ptr<VariableManager> manager(new VariableManager());
+            for (auto variable : StandardVariables::Instance())
+                manager->Manage(*variable);
+            for (size_t i = 0; i < extraVariables; ++i)
+                manager->Manage(new NumericVariable(("BenchVar" + std::to_string(i)).c_str(), ScopeOf(i)));
+            return [=] (uint64_t iterations)
+            {
+                for (uint64_t i = 0; i < iterations; ++i)
+                {
+                    size_t count = 0;
+                    for (auto variable : manager->MatchingAny(withScope))
+                    {
+                        do_not_optimize(variable);
+                        ++count;
+                    }
+                    do_not_optimize(count);
+                }
+            };
+        };
+    }
+
+    BenchmarkRegistration matchingAnyStandard("VariableManager/MatchingAny/standard", MatchingAnyBenchmark(0, ScopeFlags::CameraSetting | ScopeFlags::UserSetting));
+    BenchmarkRegistration matchingAny10k("VariableManager/MatchingAny/10000", MatchingAnyBenchmark(10000, ScopeFlags::CameraSetting | ScopeFlags::UserSetting));
+    BenchmarkRegistration matchingAny10kNarrow("VariableManager/MatchingAny/10000/single_scope", MatchingAnyBenchmark(10000, ScopeFlags::Reporting));
+
+    // Saving and restoring the standard variables. The legacy path is one SaveVariable or RecallVariable
+    // host action per variable, and the fake host rewrites or reads the whole file on each of them.
+    std::string SnapshotPath(const char* name)
+    {
+        auto directory = getenv("TMPDIR");
+        return std::string(directory ? directory : "/tmp").append("/").append(name);
+    }
+
+    BenchmarkRegistration saveAllLegacy("VariableManager/SaveAll/per_variable", [] () -> benchmark_body_t
+    {
+        PrepareHost();
+        auto path = SnapshotPath("HostInteropBenchmarks.legacy");
+        return [=] (uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                for (auto variable : StandardVariables::Instance())
+                    SaveVariable(variable->Name().c_str(), path.c_str());
+            }
+        };
+    });
+
+    BenchmarkRegistration saveAllSnapshot("VariableManager/SaveAll/snapshot", [] () -> benchmark_body_t
+    {
+        PrepareHost();
+        auto path = SnapshotPath("HostInteropBenchmarks.snapshot");
+        return [=] (uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+                VariableManager::StandardVars().SaveAll(path);
+        };
+    });
+
+    BenchmarkRegistration restoreAllLegacy("VariableManager/RestoreAll/per_variable", [] () -> benchmark_body_t
+    {
+        PrepareHost();
+        auto path = SnapshotPath("HostInteropBenchmarks.legacy");
+        for (auto variable : StandardVariables::Instance())
+            SaveVariable(variable->Name().c_str(), path.c_str());
+        return [=] (uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+                VariableManager::StandardVars().RestoreAll(path);
+        };
+    });
+
+    BenchmarkRegistration restoreAllSnapshot("VariableManager/RestoreAll/snapshot", [] () -> benchmark_body_t
+    {
+        PrepareHost();
+        auto path = SnapshotPath("HostInteropBenchmarks.snapshot");
+        VariableManager::StandardVars().SaveAll(path);
+        return [=] (uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+                VariableManager::StandardVars().RestoreAll(path);
+        };
+    });
+
+    // A handler that sets two result variables eight times each, of which only the last values matter
+    struct HandlerResults
+    {
+        HandlerResults() : count("_argN1"), report("_argT1")
+        {
+            variables.Manage(count);
+            variables.Manage(report);
+        }
+
+        void Run()
+        {
+            for (int i = 0; i < 8; ++i)
+            {
+                count.Value(static_cast<double>(i));
+                report.Value(shortTextName);
+            }
+        }
+
+        NumericVariable count;
+        TextVariable report;
+        VariableManager variables;
+    };
+
+    BenchmarkRegistration writeThrough("VariableManager/Handler/write_through", [] () -> benchmark_body_t
+    {
+        PrepareHost();
+        std::shared_ptr<HandlerResults> handler(new HandlerResults());
+        return [=] (uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+                handler->Run();
+        };
+    });
+
+    BenchmarkRegistration writeBehind("VariableManager/Handler/write_behind", [] () -> benchmark_body_t
+    {
+        PrepareHost();
+        std::shared_ptr<HandlerResults> handler(new HandlerResults());
+        handler->variables.EnableWriteBehind();
+        return [=] (uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                handler->Run();
+                handler->variables.Flush();
+            }
+        };
+    });
+
+    // Journals a changed value per iteration, which is the cost added to every change of a variable.
+    // The journal file is small, so the cost of the background compactions is included.
+    BenchmarkRegistration journalRecord("VariableJournal/Record/numeric", [] () -> benchmark_body_t
+    {
+        PrepareHost();
+        std::shared_ptr<VariableJournal> journal(new VariableJournal());
+        journal->Open(SnapshotPath("HostInteropBenchmarks.journal"), 64 * 1024);
+        return [=] (uint64_t iterations)
+        {
+            VariableValue value;
+            value.Target = &StdVar<StdVarId::_argN1>();
+            value.Status = SpotPluginApi::VariableStatus::Ok;
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                value.NumericValue = static_cast<double>(i);
+                journal->Record(value);
+            }
+        };
+    });
+
+    // Reads the mutable standard variables and journals none, since nothing changes between captures
+    BenchmarkRegistration journalCapture("VariableJournal/Capture/unchanged", [] () -> benchmark_body_t
+    {
+        PrepareHost();
+        std::shared_ptr<VariableJournal> journal(new VariableJournal());
+        journal->Open(SnapshotPath("HostInteropBenchmarks.journal"), 64 * 1024);
+        journal->Capture(VariableManager::StandardVars());
+        return [=] (uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+                journal->Capture(VariableManager::StandardVars());
+        };
+    });
+
+    // One Idle event at 60 Hz with three host state variables that rarely change. Polling reads and compares
+    // them every time, the watcher reads them once they are due.
+    BenchmarkRegistration idlePollByHand("VariableWatcher/Idle/by_hand", [] () -> benchmark_body_t
+    {
+        PrepareHost();
+        return [] (uint64_t iterations)
+        {
+            double temperature = 0.0;
+            bool running = false;
+            int windows = 0;
+            uint64_t changes = 0;
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                auto currentTemperature = StdVar<StdVarId::CurSensorTemp>().Value();
+                auto currentRunning = StdVar<StdVarId::LiveImgRunning>().Value();
+                auto currentWindows = StdVar<StdVarId::NumImgDocWindows>().Value();
+                changes += (currentTemperature != temperature) + (currentRunning != running) + (currentWindows != windows);
+                temperature = currentTemperature;
+                running = currentRunning;
+                windows = currentWindows;
+            }
+            do_not_optimize(changes);
+        };
+    });
+
+    BenchmarkRegistration idlePollWatcher("VariableWatcher/Idle/watcher", [] () -> benchmark_body_t
+    {
+        PrepareHost();
+        std::shared_ptr<VariableWatcher> watcher(new VariableWatcher());
+        watcher->Watch(StdVar<StdVarId::CurSensorTemp>(), std::chrono::milliseconds(250), std::chrono::seconds(2));
+        watcher->Watch(StdVar<StdVarId::LiveImgRunning>());
+        watcher->Watch(StdVar<StdVarId::NumImgDocWindows>());
+        auto now = std::make_shared<VariableWatcher::clock_t::time_point>(VariableWatcher::clock_t::now());
+        return [=] (uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                *now += std::chrono::microseconds(16667);
+                watcher->Poll(*now);
+            }
+        };
+    });
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // IdleScheduler
+
+    // The cost of picking and timing one task slice. A zero time slice runs one slice per tick.
+    BenchmarkRegistration idleSchedulerSlice("IdleScheduler/RunSlice/8_tasks", [] () -> benchmark_body_t
+    {
+        std::shared_ptr<IdleScheduler> scheduler(new IdleScheduler(IdleScheduler::clock_t::duration::zero()));
+        auto counter = std::make_shared<uint64_t>(0);
+        for (int i = 0; i < 8; ++i)
+        {
+            uint64_t* target = counter.get();
+            scheduler->Post("Counter", [target] (const IdleBudget&) { ++*target; return true; }, (i % 2) ? IdlePriority::Normal : IdlePriority::Low);
+        }
+        return [=] (uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+                scheduler->RunSlice();
+            do_not_optimize(*counter);
+        };
+    });
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // Events
+
+    benchmark_factory_t FanOutBenchmark(size_t delegateCount)
+    {
+        return [=] () -> benchmark_body_t
+        {
+            auto counter = std::make_shared<uint64_t>(0);
+            auto multicast = std::make_shared<MulticastEventDelegate<int>>();
+            std::function<void(int)> handler = [counter] (int value) { *counter += value; };
+            for (size_t i = 0; i < delegateCount; ++i)
+                multicast->AddDelegate(make_event_delegate(handler));
+            return [=] (uint64_t iterations)
+            {
+                int arg = 1;
+                for (uint64_t i = 0; i < iterations; ++i)
+                    (*multicast)(arg);
+                do_not_optimize(*counter);
+            };
+        };
+    }
+
+    BenchmarkRegistration fanOut1("MulticastEventDelegate/FanOut/1", FanOutBenchmark(1));
+    BenchmarkRegistration fanOut10("MulticastEventDelegate/FanOut/10", FanOutBenchmark(10));
+    BenchmarkRegistration fanOut100("MulticastEventDelegate/FanOut/100", FanOutBenchmark(100));
+    BenchmarkRegistration fanOut1k("MulticastEventDelegate/FanOut/1000", FanOutBenchmark(1000));
+    BenchmarkRegistration fanOut10k("MulticastEventDelegate/FanOut/10000", FanOutBenchmark(10000));
+
+    // The same fan out with lambdas stored inline by Subscribe instead of shared EventDelegate objects
+    benchmark_factory_t InlineFanOutBenchmark(size_t delegateCount)
+    {
+        return [=] () -> benchmark_body_t
+        {
+            auto counter = std::make_shared<uint64_t>(0);
+            auto multicast = std::make_shared<MulticastEventDelegate<int>>();
+            auto total = counter.get();
+            for (size_t i = 0; i < delegateCount; ++i)
+                multicast->Subscribe([total] (int& value) { *total += value; });
+            return [=] (uint64_t iterations)
+            {
+                int arg = 1;
+                for (uint64_t i = 0; i < iterations; ++i)
+                    (*multicast)(arg);
+                do_not_optimize(*counter);
+            };
+        };
+    }
+
+    BenchmarkRegistration inlineFanOut1("MulticastEventDelegate/FanOut/inline/1", InlineFanOutBenchmark(1));
+    BenchmarkRegistration inlineFanOut100("MulticastEventDelegate/FanOut/inline/100", InlineFanOutBenchmark(100));
+    BenchmarkRegistration inlineFanOut1k("MulticastEventDelegate/FanOut/inline/1000", InlineFanOutBenchmark(1000));
+    BenchmarkRegistration inlineFanOut10k("MulticastEventDelegate/FanOut/inline/10000", InlineFanOutBenchmark(10000));
+
+    // A host event raised through the binding table into an EventSource with one delegate
+    BenchmarkRegistration raiseHostEvent("EventSource/RaiseHostEvent/1", [] () -> benchmark_body_t
+    {
+        PrepareHost();
+        const SpotPluginApi::host_event_t hostEvent = 1000;
+        auto counter = std::make_shared<uint64_t>(0);
+        auto source = std::make_shared<integer_event_t>(hostEvent);
+        std::function<void(int)> handler = [counter] (int value) { *counter += value; };
+        source->AddDelegate(make_event_delegate(handler));
+        return [=] (uint64_t iterations)
+        {
+            auto& host = FakeHost::Instance();
+            for (uint64_t i = 0; i < iterations; ++i)
+                host.Raise(hostEvent, 1);
+            do_not_optimize(*counter);
+            do_not_optimize(source);
+        };
+    });
+
+    // The same event routed to a channel by an EventHub, which binds one handler for all host events
+    BenchmarkRegistration raiseHubEvent("EventHub/RaiseHostEvent/1", [] () -> benchmark_body_t
+    {
+        PrepareHost();
+        const SpotPluginApi::host_event_t hostEvent = 20;
+        auto counter = std::make_shared<uint64_t>(0);
+        auto hub = std::make_shared<EventHub>();
+        std::function<void(int)> handler = [counter] (int value) { *counter += value; };
+        hub->Channel<EventChannel<EventArgCastTo<int>>>(hostEvent).AddDelegate(make_event_delegate(handler));
+        return [=] (uint64_t iterations)
+        {
+            auto& host = FakeHost::Instance();
+            for (uint64_t i = 0; i < iterations; ++i)
+                host.Raise(hostEvent, 1);
+            do_not_optimize(*counter);
+            do_not_optimize(hub);
+        };
+    });
+
+    // A host event with a string payload, like CameraInitialized, into a delegate that reads the length.
+    // The std::string argument is built for every event, the TextView refers to the host string.
+    template<typename EvSource>
+    benchmark_body_t StringEventBenchmark()
+    {
+        PrepareHost();
+        const SpotPluginApi::host_event_t hostEvent = 1001;
+        auto counter = std::make_shared<uint64_t>(0);
+        auto source = std::make_shared<EvSource>(hostEvent);
+        source->AddDelegate(make_event_delegate<typename EvSource::arg_type>([counter] (typename EvSource::arg_type& name) { *counter += std::distance(name.begin(), name.end()); }));
+        return [=] (uint64_t iterations)
+        {
+            auto& host = FakeHost::Instance();
+            const char* cameraName = "SPOT Insight 4 Megapixel Color Mosaic";
+            for (uint64_t i = 0; i < iterations; ++i)
+                host.Raise(hostEvent, reinterpret_cast<uintptr_t>(cameraName));
+            do_not_optimize(*counter);
+            do_not_optimize(source);
+        };
+    }
+
+    BenchmarkRegistration stringEvent("EventSource/StringPayload/string", StringEventBenchmark<string_event_t>);
+    BenchmarkRegistration textViewEvent("EventSource/StringPayload/text_view", StringEventBenchmark<text_event_t>);
+
+    // One synthetic 1280x1024 frame per operation delivered to a delegate that sums a row of it.
+    // Inline delivery reads the host pixels in place, a dedicated thread gets a detached copy.
+    benchmark_factory_t LiveFrameBenchmark(SpotPluginApi::channel_layout_t layout, uint32_t bitDepth, EventDispatchMode mode)
+    {
+        return [=] () -> benchmark_body_t
+        {
+            auto& host = PrepareHost();
+            host.ConfigureLive(1280, 1024, bitDepth, layout, false);
+            PluginHost::DoAction(SpotPluginApi::HostActionRequest::StartLive, 0, nullptr);
+
+            auto rowSum = std::make_shared<uint64_t>(0);
+            auto source = std::make_shared<live_frame_event_t>(SpotPluginApi::HostEvent::LiveFrameReady);
+            std::function<void(LiveFrame)> handler = [rowSum] (LiveFrame frame)
+            {
+                auto row = frame.Row<uint8_t>(frame.Height() / 2);
+                *rowSum += std::accumulate(row, row + frame.RowBytes(), uint64_t(0));
+            };
+            source->AddDelegate(make_event_delegate(handler));
+            source->SetDispatchPolicy(EventDispatchPolicy(mode, 4, QueueOverflowPolicy::Block));
+            return [=] (uint64_t iterations)
+            {
+                auto& host = FakeHost::Instance();
+                for (uint64_t i = 0; i < iterations; ++i)
+                    host.RaiseLiveFrame();
+                source->SetDispatchPolicy(EventDispatchPolicy(mode, 4, QueueOverflowPolicy::Block)); // waits for the queued frames
+                do_not_optimize(*rowSum);
+            };
+        };
+    }
+
+    BenchmarkRegistration liveFrameMono8("HostEvents/LiveFrameReady/inline/mono8", LiveFrameBenchmark(SpotPluginApi::ChannelLayout::Mono, 8, EventDispatchMode::Inline));
+    BenchmarkRegistration liveFrameRgb16("HostEvents/LiveFrameReady/inline/rgb16", LiveFrameBenchmark(SpotPluginApi::ChannelLayout::RGB, 16, EventDispatchMode::Inline));
+    BenchmarkRegistration liveFrameMono8Thread("HostEvents/LiveFrameReady/dedicated_thread/mono8", LiveFrameBenchmark(SpotPluginApi::ChannelLayout::Mono, 8, EventDispatchMode::DedicatedThread));
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // Image views
+
+    // Locks a 4 megapixel 16 bit image document and sums the samples of a rectangle in place
+    benchmark_factory_t ImageViewSumBenchmark(uint32_t width, uint32_t height)
+    {
+        return [=] () -> benchmark_body_t
+        {
+            auto& host = PrepareHost();
+            host.SetActiveImage(2048, 2048, 12, SpotPluginApi::ChannelLayout::Mono);
+            return [=] (uint64_t iterations)
+            {
+                for (uint64_t i = 0; i < iterations; ++i)
+                {
+                    auto lock = ImageLock::Acquire();
+                    auto view = lock.View<uint16_t>();
+                    auto area = view.SubView((view.Width() - width) / 2, (view.Height() - height) / 2, width, height);
+                    uint64_t sum = 0;
+                    for (auto row : area.Rows())
+                        sum = std::accumulate(row.begin(), row.end(), sum);
+                    do_not_optimize(sum);
+                }
+            };
+        };
+    }
+
+    BenchmarkRegistration imageViewSumFull("ImageView/Sum/2048x2048", ImageViewSumBenchmark(2048, 2048));
+    BenchmarkRegistration imageViewSumSub("ImageView/Sum/256x256", ImageViewSumBenchmark(256, 256));
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // Image statistics
+
+    // A camera frame of noise over a gradient, with rows padded to 64 bytes like the host's buffers.
+    // Frames deeper than 12 bits scale the 12 bit pattern up and fill the low bits with noise.
+    struct SyntheticFrame
+    {
+        std::vector<uint16_t> samples;
+        ImageView<const uint16_t> view;
+
+        SyntheticFrame(uint32_t width, uint32_t height, uint32_t channels, uint32_t bitDepth)
+        {
+            size_t rowSamples = (static_cast<size_t>(width) * channels + 31) & ~static_cast<size_t>(31);
+            samples.resize(rowSamples * height);
+            uint32_t extraBits = bitDepth - 12;
+            uint32_t noise = 2463534242u;
+            for (uint32_t y = 0; y < height; ++y)
+            {
+                for (size_t i = 0; i < static_cast<size_t>(width) * channels; ++i)
+                {
+                    noise ^= noise << 13;
+                    noise ^= noise >> 17;
+                    noise ^= noise << 5;
+                    uint32_t sample = (1024 + (i * 2048) / (static_cast<size_t>(width) * channels) + (noise & 511)) & 0xfff;
+                    samples[y * rowSamples + i] = static_cast<uint16_t>((sample << extraBits) | ((noise >> 9) & ((1u << extraBits) - 1)));
+                }
+            }
+            view = ImageView<const uint16_t>(samples.data(), width, height, static_cast<intptr_t>(rowSamples * sizeof(uint16_t)), channels);
+        }
+    };
+
+    bool SameStatistics(const ChannelStatistics& lhs, const ChannelStatistics& rhs)
+    {
+        return lhs.Count == rhs.Count && lhs.Minimum == rhs.Minimum && lhs.Maximum == rhs.Maximum
+            && lhs.Sum == rhs.Sum && lhs.SumOfSquares == rhs.SumOfSquares;
+    }
+
+    bool SameStatistics(const ImageStatistics& lhs, const ImageStatistics& rhs)
+    {
+        if (lhs.Channels != rhs.Channels || lhs.BitDepth != rhs.BitDepth || lhs.HistogramBits != rhs.HistogramBits || lhs.Histogram != rhs.Histogram)
+            return false;
+        for (uint32_t channel = 0; channel < 4; ++channel)
+        {
+            if (!SameStatistics(lhs.Channel[channel], rhs.Channel[channel]))
+                return false;
+        }
+        return true;
+    }
+
+    // Computes histogram, min/max, mean and contrast of a whole frame with the kernels of one instruction set.
+    // Every field of the result is checked against the scalar reference once before timing.
+    benchmark_factory_t ImageStatisticsBenchmark(uint32_t width, uint32_t height, uint32_t channels, uint32_t bitDepth, SimdLevel level)
+    {
+        return [=] () -> benchmark_body_t
+        {
+            std::shared_ptr<SyntheticFrame> frame(new SyntheticFrame(width, height, channels, bitDepth));
+            auto expected = ImageStatistics::Compute(frame->view, bitDepth, 12, SimdLevel::Scalar);
+            auto actual = ImageStatistics::Compute(frame->view, bitDepth, 12, level);
+            if (!SameStatistics(actual, expected))
+                throw std::logic_error(std::string(simd_level_name(level)).append(" image statistics differ from the scalar reference"));
+
+            return [=] (uint64_t iterations)
+            {
+                for (uint64_t i = 0; i < iterations; ++i)
+                {
+                    auto statistics = ImageStatistics::Compute(frame->view, bitDepth, 12, level);
+                    do_not_optimize(statistics.Contrast());
+                }
+            };
+        };
+    }
+
+    // One benchmark per frame and instruction set the machine supports
+    bool RegisterImageStatisticsBenchmarks()
+    {
+        struct FrameSize { const char* name; uint32_t width; uint32_t height; uint32_t channels; uint32_t bitDepth; };
+        const FrameSize frames[] =
+        {
+            { "mono12/5MP", 2592, 1944, 1, 12 },
+            { "mono12/12MP", 4000, 3000, 1, 12 },
+            { "mono12/20MP", 5472, 3648, 1, 12 },
+            { "mono16/5MP", 2592, 1944, 1, 16 },
+            { "rgb12/5MP", 2592, 1944, 3, 12 },
+            { "rgba12/5MP", 2592, 1944, 4, 12 },
+            { "rgba16/5MP", 2592, 1944, 4, 16 }
+        };
+        for (auto& frame : frames)
+        {
+            for (int level = static_cast<int>(SimdLevel::Scalar); level <= static_cast<int>(supported_simd_level()); ++level)
+            {
+                auto simdLevel = static_cast<SimdLevel>(level);
+                BenchmarkRegistry::Instance().Add(std::string("ImageStatistics/Compute/").append(frame.name).append("/").append(simd_level_name(simdLevel)),
+                    ImageStatisticsBenchmark(frame.width, frame.height, frame.channels, frame.bitDepth, simdLevel));
+            }
+        }
+        return true;
+    }
+
+    const bool imageStatisticsRegistered = RegisterImageStatisticsBenchmarks();
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // TaskScheduler
+
+    // Starts and waits for a group of empty tasks, which is the bare scheduling cost
+    BenchmarkRegistration runWait("TaskScheduler/RunWait/1000", [] () -> benchmark_body_t
+    {
+        return [] (uint64_t iterations)
+        {
+            auto& scheduler = TaskScheduler::Instance();
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                TaskGroup group(scheduler);
+                for (int task = 0; task < 1000; ++task)
+                    scheduler.Run(group, [] { });
+                scheduler.Wait(group);
+            }
+        };
+    });
+
+    // Sums a 20 megapixel 12 bit frame in tiles on TaskScheduler::Instance(). tileSize zero picks cache sized tiles.
+    benchmark_factory_t ParallelForTilesBenchmark(uint32_t tileSize)
+    {
+        return [=] () -> benchmark_body_t
+        {
+            std::shared_ptr<SyntheticFrame> frame(new SyntheticFrame(5472, 3648, 1, 12));
+            return [=] (uint64_t iterations)
+            {
+                for (uint64_t i = 0; i < iterations; ++i)
+                {
+                    std::atomic<uint64_t> total(0);
+                    parallel_for_tiles(frame->view, tileSize, [&total] (const ImageView<const uint16_t>& tile, uint32_t, uint32_t)
+                    {
+                        uint64_t sum = 0;
+                        for (auto row : tile.Rows())
+                            sum = std::accumulate(row.begin(), row.end(), sum);
+                        total += sum;
+                    });
+                    do_not_optimize(total.load());
+                }
+            };
+        };
+    }
+
+    BenchmarkRegistration parallelTilesCache("TaskScheduler/ParallelForTiles/20MP/cache_sized", ParallelForTilesBenchmark(0));
+    BenchmarkRegistration parallelTiles512("TaskScheduler/ParallelForTiles/20MP/512", ParallelForTilesBenchmark(512));
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // SequenceProcessor
+
+    // Measures a sequence of 16 frames of 1 megapixel whose frames take the host 5 ms to show.
+    // With a look-ahead of 1 reading and processing alternate, a larger window overlaps them.
+    // Uses at least two workers so the overlap shows on machines with few cores as well.
+    benchmark_factory_t SequenceBenchmark(size_t lookAhead)
+    {
+        return [=] () -> benchmark_body_t
+        {
+            static TaskScheduler scheduler(std::max<unsigned>(2, std::thread::hardware_concurrency()));
+            auto& host = PrepareHost();
+            host.SetActiveSequence(16, 1024, 1024, 12, SpotPluginApi::ChannelLayout::Mono, std::chrono::microseconds(5000));
+            return [=] (uint64_t iterations)
+            {
+                for (uint64_t i = 0; i < iterations; ++i)
+                {
+                    double contrast = 0.0;
+                    SequenceProcessor<ImageStatistics> sequence(
+                        [] (const SequenceFrame& frame) { return ImageStatistics::Compute(frame.View<uint16_t>(), frame.BitDepth); },
+                        [&contrast] (const SequenceFrame&, ImageStatistics& statistics) { contrast += statistics.Contrast(); },
+                        lookAhead, scheduler);
+                    sequence.SetMetadata(std::vector<IVariable*>(1, &StdVar<StdVarId::ImgSensorTemp>()));
+                    sequence.Run();
+                    do_not_optimize(contrast);
+                }
+            };
+        };
+    }
+
+    BenchmarkRegistration sequenceLookAhead1("SequenceProcessor/Run/16x1MP/lookahead_1", SequenceBenchmark(1));
+    BenchmarkRegistration sequenceLookAhead4("SequenceProcessor/Run/16x1MP/lookahead_4", SequenceBenchmark(4));
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // CallbackDispatcher
+
+    // Sends action codes through the callback the host calls, cycling over codes so the lookup is not trivially predicted
+    benchmark_factory_t DispatchBenchmark(uintptr_t firstCode, bool hasActions)
+    {
+        return [=] () -> benchmark_body_t
+        {
+            const size_t codeCount = 64;
+            auto counter = std::make_shared<uint64_t>(0);
+            auto dispatcher = std::make_shared<CallbackDispatcher>();
+            if (hasActions)
+            {
+                uint64_t* target = counter.get();
+                for (uintptr_t code = firstCode; code < firstCode + codeCount; ++code)
+                    dispatcher->SetAction(code, [target] () { ++*target; });
+            }
+            return [=] (uint64_t iterations)
+            {
+                auto userData = reinterpret_cast<uintptr_t>(dispatcher.get());
+                for (uint64_t i = 0; i < iterations; ++i)
+                    CallbackDispatcher::master_callback_func(SpotPluginApi::CallbackReason::ActionCode, firstCode + (i % codeCount), userData);
+                do_not_optimize(*counter);
+            };
+        };
+    }
+
+    BenchmarkRegistration dispatchDense("CallbackDispatcher/Dispatch/dense", DispatchBenchmark(1, true));
+    BenchmarkRegistration dispatchSparse("CallbackDispatcher/Dispatch/sparse", DispatchBenchmark(100000, true));
+    BenchmarkRegistration dispatchUnknown("CallbackDispatcher/Dispatch/unknown", DispatchBenchmark(1, false));
+}
+
+int main(int argc, char* argv[])
+{
+    return BenchmarkRegistry::Instance().Main(argc, argv);
+}
@@ -0,0 +1,80 @@
+// EventLogDecoder.cpp : Renders the binary event log files written by EventLog as text.
+//
+// Usage: EventLogDecoder <log file> [<log file> ...]
+// Rotated files can be passed oldest first (SampleSpotPlugin.elog.3 ... SampleSpotPlugin.elog) to get one timeline.
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <iostream>
+#include "EventLog.h"
+
+using namespace std;
+
+/// Summary:
+///     Prints the records of one log file.
+/// Arguments:
+///     startTicks - The time stamp shown as time 0. Set from the first record if 0.
+/// Returns:
+///     false if the file could not be read
+bool DecodeFile(const char* path, uint64_t& startTicks)
+{
+    FILE* file = fopen(path, "rb");
+    if (nullptr == file)
+    {
+        cerr << path << ": cannot open file" << endl;
+        return false;
+    }
+
+    EventLogFileHeader header;
+    if (1 != fread(&header, sizeof(header), 1, file) || 0 != memcmp(header.Magic, "SPOTELOG", sizeof(header.Magic)))
+    {
+        cerr << path << ": not an event log file" << endl;
+        fclose(file);
+        return false;
+    }
+    if (header.Version != event_log_file_version || header.RecordSize != sizeof(EventLogRecord))
+    {
+        cerr << path << ": unsupported version " << header.Version << " with record size " << header.RecordSize << endl;
+        fclose(file);
+        return false;
+    }
+
+    vector<string> names;
+    EventLogRecord record;
+    size_t count = 0;
+    while (1 == fread(&record, sizeof(record), 1, file))
+    {
+        if (EventLogRecordKind::Name == record.Kind)
+        {
+            if (record.Code >= names.size())
+                names.resize(record.Code + 1);
+            names[record.Code].resize(static_cast<size_t>(record.Value));
+            names[record.Code].append(record.Text, record.TextLength);
+            continue;
+        }
+        if (0 == startTicks)
+            startTicks = record.Ticks;
+        cout << format_event_log_record(record, names, header.TicksPerSecond, startTicks) << '\n';
+        ++count;
+    }
+    fclose(file);
+    cerr << path << ": " << count << " records" << endl;
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        cerr << "Usage: EventLogDecoder <log file> [<log file> ...]" << endl;
+        return 2;
+    }
+
+    uint64_t startTicks = 0;
+    bool allRead = true;
+    for (int i = 1; i < argc; ++i)
+        allRead = DecodeFile(argv[i], startTicks) && allRead;
+    return allRead ? 0 : 1;
+}
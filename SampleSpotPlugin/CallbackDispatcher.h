@@ -2,26 +2,149 @@
 
 #include <string>
 #include <unordered_map>
+#include <vector>
+#include <utility>
 #include <algorithm>
 #include "SpotPlugin.h"
+#include "InplaceFunction.h"
 
-typedef void (*action_func_t)(void); 
+typedef void (*action_func_t)(void);
+
+// An action can be any callable with up to 32 bytes of captures. It is stored without heap allocation.
+typedef InplaceFunction<void(), 32> action_t;
 
 class CallbackDispatcher
 {
+public:
+    // Action codes below this value are kept in an array, larger codes in a hash table
+    static const size_t dense_action_count = 256;
+
 private:
-    std::unordered_map<uintptr_t, action_func_t> actionFunctions;
-    
+    action_t denseActions[dense_action_count];
+    std::unordered_map<uintptr_t, action_t> sparseActions;
+    action_t unloadFunction;
+    action_t completionFunction;
+    std::vector<uintptr_t> runningActions;                      // The codes Invoke is running, innermost last
+    std::vector<std::pair<uintptr_t, action_t>> deferredActions; // Changes to running actions, made when they return
+
+    // no copies allowed. The host holds a pointer to this object
+    CallbackDispatcher(const CallbackDispatcher&);
+    CallbackDispatcher& operator = (const CallbackDispatcher&);
+
+    // Returns the action for the code or nullptr if there is none. Never inserts.
+    const action_t* FindAction(uintptr_t actionId) const
+    {
+        if (actionId < dense_action_count)
+            return denseActions[actionId] ? &denseActions[actionId] : nullptr;
+        auto item = sparseActions.find(actionId);
+        return (sparseActions.end() == item) ? nullptr : &item->second;
+    }
+
+    bool IsRunning(uintptr_t actionId) const
+    {
+        return runningActions.end() != std::find(runningActions.begin(), runningActions.end(), actionId);
+    }
+
+    void StoreAction(uintptr_t actionId, action_t&& func)
+    {
+        if (actionId < dense_action_count)
+            denseActions[actionId] = std::move(func);
+        else if (func)
+            sparseActions[actionId] = std::move(func);
+        else
+            sparseActions.erase(actionId);
+    }
+
+    // Leaves the innermost running action and makes the changes to actions that are no longer running
+    void EndInvoke()
+    {
+        runningActions.pop_back();
+        for (size_t i = 0; i < deferredActions.size(); )
+        {
+            if (IsRunning(deferredActions[i].first))
+            {
+                ++i;
+                continue;
+            }
+            auto deferred = std::move(deferredActions[i]);
+            deferredActions.erase(deferredActions.begin() + i);
+            StoreAction(deferred.first, std::move(deferred.second));
+        }
+    }
+
 public:
+    CallbackDispatcher()
+    {
+    }
 
-    void SetAction(uintptr_t actionId, action_func_t func)
+    // Sets the action for a code. An empty action or a null function pointer removes it.
+    // An action that is running is replaced when it returns.
+    void SetAction(uintptr_t actionId, action_t func)
     {
-        actionFunctions[actionId] = func;
+        if (IsRunning(actionId))
+            deferredActions.push_back(std::make_pair(actionId, std::move(func)));
+        else
+            StoreAction(actionId, std::move(func));
     }
 
     void RemoveAction(uintptr_t actionId)
     {
-        actionFunctions.erase(actionId);
+        SetAction(actionId, nullptr);
+    }
+
+    // Removes every action. The actions that are running are removed when they return.
+    void RemoveAllActions()
+    {
+        for (uintptr_t actionId = 0; actionId < dense_action_count; ++actionId)
+            SetAction(actionId, nullptr);
+        for (auto item = sparseActions.begin(); sparseActions.end() != item; )
+        {
+            if (IsRunning(item->first))
+            {
+                deferredActions.push_back(std::make_pair(item->first, action_t()));
+                ++item;
+            }
+            else
+            {
+                item = sparseActions.erase(item);
+            }
+        }
+    }
+
+    // Sets the function called when the host is about to unload the plug-in
+    void SetUnloadAction(action_t func)
+    {
+        unloadFunction = std::move(func);
+    }
+
+    // Sets the function called after every action code the host sends, whether or not an action is set for it
+    void SetCompletionAction(action_t func)
+    {
+        completionFunction = std::move(func);
+    }
+
+    /// Summary:
+    ///     Runs the action for a code. The action may replace or remove itself and other actions while
+    ///     it runs. Changes to an action that is running are made after it returns.
+    /// Returns:
+    ///     false if no action is set for the code
+    bool Invoke(uintptr_t actionId)
+    {
+        auto action = FindAction(actionId);
+        if (nullptr == action)
+            return false;
+        runningActions.push_back(actionId);
+        try
+        {
+            (*action)();
+        }
+        catch (...)
+        {
+            EndInvoke();
+            throw;
+        }
+        EndInvoke();
+        return true;
     }
 
     static void SPOTPLUGINAPI master_callback_func(SpotPluginApi::callback_reason_t reason, uintptr_t info, uintptr_t userData)
@@ -30,14 +153,17 @@ public:
         switch (reason)
         {
         case SpotPluginApi::CallbackReason::UnloadingPlugin:
-            obj->actionFunctions.clear();
+            if (obj->unloadFunction)
+                obj->unloadFunction();
+            obj->RemoveAllActions();
             break;
         case SpotPluginApi::CallbackReason::ActionCode:
-            if (obj->actionFunctions[info] != nullptr)
-                obj->actionFunctions[info]();
+            obj->Invoke(info);
+            if (obj->completionFunction)
+                obj->completionFunction();
             break;
         default:
             break;
         }
     }
-};
\ No newline at end of file
+};
@@ -3,6 +3,7 @@
 #include <stdint.h>
 #include <string>
 #include <functional>
+#include "TextView.h"
 
 struct EventArgNoOp : public std::unary_function<uintptr_t, uintptr_t>
 {
@@ -17,7 +18,34 @@ struct EventArgCastTo : public std::unary_function<uintptr_t, T>
 };
 
 
+// Copies the host string into a new std::string for every event. EventArgToTextView does not allocate.
 struct EventArgToString : public std::unary_function<uintptr_t, std::string>
 {
     std::string operator() (uintptr_t val) { return std::string(reinterpret_cast<const char*>(val));}
 };
+
+
+// Refers to the host string without copying it. A null string gives an empty view.
+struct EventArgToTextView : public std::unary_function<uintptr_t, TextView>
+{
+    TextView operator() (uintptr_t val) { return TextView(reinterpret_cast<const char*>(val));}
+};
+
+
+/// Summary:
+///     Passes a struct of type T that the host sends by address to the delegates as a const reference,
+///     so the struct is neither copied nor wrapped. A null address gives a default constructed T.
+template <typename T>
+struct EventArgToDescriptor : public std::unary_function<uintptr_t, const T&>
+{
+    // Initialized with the other statics when the library loads, so events on any thread can use it
+    static const T empty;
+
+    const T& operator() (uintptr_t val)
+    {
+        return val ? *reinterpret_cast<const T*>(val) : empty;
+    }
+};
+
+template <typename T>
+const T EventArgToDescriptor<T>::empty = T();
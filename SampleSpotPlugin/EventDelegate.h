@@ -1,14 +1,20 @@
 #pragma once
 
+#include <memory>
+#include <utility>
+#include <type_traits>
 #include "function_traits.h"
 
+/// Summary:
+///     The receiver of an event. ArgType may be a reference to const, in which case the delegates get the
+///     argument of the event source without a copy, or a move-only type, which the delegates get by reference.
 template<typename ArgType>
 class EventDelegate
 {
 protected: 
     EventDelegate() {}
 public:
-    typedef typename ArgType arg_type;
+    typedef ArgType arg_type;
 
     virtual ~EventDelegate() {}
     virtual void operator()(ArgType &args) = 0;
@@ -20,11 +26,12 @@ class EventDelegateFunctionWrapper : public EventDelegate<Arg>
 {
     Func func;
 public:
-    EventDelegateFunctionWrapper(Func f) : func(f)
+    template<typename F>
+    explicit EventDelegateFunctionWrapper(F&& f) : func(std::forward<F>(f))
     {
     }
 
-    virtual void operator() (arg_type & args)
+    virtual void operator() (Arg & args)
     {
         func(args);
     }
@@ -39,3 +46,13 @@ std::shared_ptr<EventDelegate<Arg>> make_event_delegate(std::function<void(Arg)>
     typedef std::function<void(Arg)> func_t;
     return std::make_shared<EventDelegateFunctionWrapper<func_t, Arg>>(theFunction);
 }
+
+/// Constructs a new EventDelegate on the heap for the event argument type Arg that calls any callable,
+/// e.g. make_event_delegate<text_event_t::arg_type>([](TextView name) { ... }).
+/// The callable is moved or copied into the delegate as passed, without being wrapped in a std::function.
+template<typename Arg, typename Func>
+std::shared_ptr<EventDelegate<Arg>> make_event_delegate(Func&& func)
+{
+    typedef typename std::decay<Func>::type func_t;
+    return std::make_shared<EventDelegateFunctionWrapper<func_t, Arg>>(std::forward<Func>(func));
+}
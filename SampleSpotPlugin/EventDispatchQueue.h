@@ -0,0 +1,423 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include "TextView.h"
+
+/// Summary:
+///     Where an EventSource runs its delegates.
+enum class EventDispatchMode
+{
+    Inline,             // On the host thread during the host callback (default)
+    WorkerPool,         // On a thread of the shared EventWorkerPool
+    DedicatedThread     // On a thread owned by the event source
+};
+
+/// Summary:
+///     What happens to a new event when the dispatch queue of an EventSource is full.
+enum class QueueOverflowPolicy
+{
+    DropOldest,         // The oldest queued event is discarded
+    CoalesceLatest,     // The newest queued event is replaced with the new event
+    Block               // The host thread waits for the delegates to catch up, up to EventDispatchPolicy::BlockTimeoutMilliseconds.
+                        // After that the oldest queued event is discarded as with DropOldest.
+};
+
+struct EventDispatchPolicy
+{
+    EventDispatchPolicy(EventDispatchMode mode = EventDispatchMode::Inline, size_t capacity = 64, QueueOverflowPolicy overflow = QueueOverflowPolicy::DropOldest,
+                        uint32_t blockTimeoutMilliseconds = 100) :
+        Mode(mode), Capacity(capacity), Overflow(overflow), BlockTimeoutMilliseconds(blockTimeoutMilliseconds)
+    { }
+
+    EventDispatchMode Mode;
+    size_t Capacity;                // Maximum number of events waiting to be delivered
+    QueueOverflowPolicy Overflow;
+    uint32_t BlockTimeoutMilliseconds;  // Longest wait of the host thread for room with QueueOverflowPolicy::Block
+};
+
+/// Summary:
+///     Counters of an asynchronous event dispatch queue. All latencies are measured from the
+///     host callback to the start of the delivery to the delegates.
+struct EventDispatchStats
+{
+    EventDispatchStats() :
+        Queued(0), Delivered(0), Dropped(0), Coalesced(0), Blocked(0), BlockTimeouts(0), Failed(0),
+        Depth(0), MaxDepth(0), TotalLatencyMicroseconds(0), MaxLatencyMicroseconds(0)
+    { }
+
+    uint64_t Queued;                    // Events received from the host
+    uint64_t Delivered;                 // Events passed to the delegates
+    uint64_t Dropped;                   // Events discarded by QueueOverflowPolicy::DropOldest, including BlockTimeouts
+    uint64_t Coalesced;                 // Events replaced by QueueOverflowPolicy::CoalesceLatest
+    uint64_t Blocked;                   // Host callbacks that waited for room by QueueOverflowPolicy::Block
+    uint64_t BlockTimeouts;             // Blocked host callbacks that found no room in time and discarded the oldest event
+    uint64_t Failed;                    // Deliveries where a delegate threw an exception
+    size_t Depth;                       // Events waiting now
+    size_t MaxDepth;                    // Most events ever waiting at once
+    uint64_t TotalLatencyMicroseconds;
+    uint64_t MaxLatencyMicroseconds;
+
+    double MeanLatencyMicroseconds() const
+    {
+        return Delivered ? static_cast<double>(TotalLatencyMicroseconds) / Delivered : 0.0;
+    }
+};
+
+/// Summary:
+///     How an event argument is kept while it waits in a dispatch queue.
+///     Host strings are only valid during the host callback so they are copied. The delegates get a
+///     pointer to the copy that is valid while they run. Changes written through a char* argument
+///     do not reach the host when the event is not dispatched inline.
+///     Other arguments are moved into the queue and moved out again for their single delivery, so
+///     move-only argument types work as well. Arguments passed by const reference are queued as a copy.
+template<typename ArgType>
+struct event_arg_storage
+{
+    typedef ArgType type;
+    static type Store(ArgType&& arg) { return std::move(arg); }
+    static ArgType View(type& stored) { return std::move(stored); }
+};
+
+template<typename ArgType>
+struct event_arg_storage<const ArgType&>
+{
+    typedef ArgType type;
+    static type Store(const ArgType& arg) { return arg; }
+    static const ArgType& View(type& stored) { return stored; }
+};
+
+struct stored_event_text
+{
+    std::string Text;
+    bool IsNull;
+};
+
+template<>
+struct event_arg_storage<const char*>
+{
+    typedef stored_event_text type;
+
+    static type Store(const char* arg)
+    {
+        type stored;
+        stored.IsNull = (nullptr == arg);
+        if (arg)
+            stored.Text = arg;
+        return stored;
+    }
+
+    static const char* View(type& stored) { return stored.IsNull ? nullptr : stored.Text.c_str(); }
+};
+
+template<>
+struct event_arg_storage<char*>
+{
+    typedef stored_event_text type;
+
+    static type Store(const char* arg) { return event_arg_storage<const char*>::Store(arg); }
+    static char* View(type& stored) { return stored.IsNull ? nullptr : &stored.Text[0]; }
+};
+
+template<>
+struct event_arg_storage<TextView>
+{
+    typedef std::string type;
+    static type Store(const TextView& arg) { return arg.ToString(); }
+    static TextView View(type& stored) { return TextView(stored); }
+};
+
+
+/// Summary:
+///     A fixed set of threads that run event delivery jobs in the order they are scheduled.
+///     The threads are started by the first Schedule call. Shutdown must be called before the plug-in
+///     library is unloaded because threads cannot be joined while the loader lock is held.
+///     ShutdownAll does this for the shared pool and every pool made by CreateDedicated.
+class EventWorkerPool
+{
+    // The pools made by CreateDedicated that have not been destroyed yet
+    struct DedicatedPools
+    {
+        DedicatedPools() : isShutdown(false) { }
+
+        std::mutex lock;
+        std::vector<EventWorkerPool*> pools;
+        bool isShutdown;
+    };
+
+    std::vector<std::thread> threads;
+    std::deque<std::function<void()>> jobs;
+    std::mutex lock;
+    std::condition_variable jobAvailable;
+    size_t threadCount;
+    bool stopping;
+    bool isDedicated;
+
+    // no copies allowed. The threads refer to this object
+    EventWorkerPool(const EventWorkerPool&);
+    EventWorkerPool& operator = (const EventWorkerPool&);
+
+    // Never destroyed, because dedicated pools may be destroyed by objects with static storage
+    static DedicatedPools& Dedicated()
+    {
+        static DedicatedPools* dedicated = new DedicatedPools();
+        return *dedicated;
+    }
+
+    void Run()
+    {
+        for (;;)
+        {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                jobAvailable.wait(guard, [this] { return stopping || !jobs.empty(); });
+                if (jobs.empty())
+                    return;
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            job();
+        }
+    }
+
+public:
+    explicit EventWorkerPool(size_t threadCount) :
+        threadCount(std::max<size_t>(1, threadCount)), stopping(false), isDedicated(false)
+    {
+    }
+
+    ~EventWorkerPool()
+    {
+        if (isDedicated)
+        {
+            auto& dedicated = Dedicated();
+            std::lock_guard<std::mutex> guard(dedicated.lock);
+            dedicated.pools.erase(std::remove(dedicated.pools.begin(), dedicated.pools.end(), this), dedicated.pools.end());
+        }
+        Shutdown();
+    }
+
+    /// Summary:
+    ///     The pool used by event sources with EventDispatchMode::WorkerPool.
+    static EventWorkerPool& Shared()
+    {
+        static EventWorkerPool instance(std::min<size_t>(4, std::max<size_t>(1, std::thread::hardware_concurrency() / 2)));
+        return instance;
+    }
+
+    /// Summary:
+    ///     A pool with one thread for an event source with EventDispatchMode::DedicatedThread.
+    ///     After ShutdownAll the pool refuses every job, so its events are delivered by the caller.
+    static std::unique_ptr<EventWorkerPool> CreateDedicated()
+    {
+        std::unique_ptr<EventWorkerPool> pool(new EventWorkerPool(1));
+        pool->isDedicated = true;
+        auto& dedicated = Dedicated();
+        std::lock_guard<std::mutex> guard(dedicated.lock);
+        pool->stopping = dedicated.isShutdown;
+        dedicated.pools.push_back(pool.get());
+        return pool;
+    }
+
+    /// Summary:
+    ///     Shuts down the shared pool and every dedicated pool. Must be called before the plug-in library
+    ///     is unloaded. The pools are kept from being destroyed until they are stopped, so a delegate
+    ///     running on one of them must not change the dispatch policy of an event source meanwhile.
+    static void ShutdownAll()
+    {
+        Shared().Shutdown();
+        auto& dedicated = Dedicated();
+        std::lock_guard<std::mutex> guard(dedicated.lock);
+        dedicated.isShutdown = true;
+        for (auto pool : dedicated.pools)
+            pool->Shutdown();
+    }
+
+    /// Returns:
+    ///     false if the pool has been shut down. The job was not scheduled and must be run by the caller.
+    bool Schedule(std::function<void()> job)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (stopping)
+            return false;
+        if (threads.empty())
+        {
+            for (size_t i = 0; i < threadCount; ++i)
+                threads.push_back(std::thread(&EventWorkerPool::Run, this));
+        }
+        jobs.push_back(std::move(job));
+        jobAvailable.notify_one();
+        return true;
+    }
+
+    // Runs the jobs already scheduled, then stops the threads. Later jobs are refused.
+    void Shutdown()
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+            jobAvailable.notify_all();
+        }
+        for (auto& thread : threads)
+        {
+            if (thread.joinable())
+                thread.join();
+        }
+        threads.clear();
+    }
+};
+
+
+/// Summary:
+///     A bounded queue of events that are delivered on worker threads in the order they were received.
+///     Only one thread delivers the events of a queue at a time.
+template<typename StoredArg>
+class EventDispatchQueue
+{
+public:
+    typedef std::function<void(StoredArg&)> deliver_func_t;
+
+private:
+    typedef std::chrono::steady_clock clock_t;
+
+    struct Entry
+    {
+        Entry(StoredArg&& arg, clock_t::time_point queuedAt) : Arg(std::move(arg)), QueuedAt(queuedAt) { }
+        StoredArg Arg;
+        clock_t::time_point QueuedAt;
+    };
+
+    EventDispatchPolicy policy;
+    deliver_func_t deliver;
+    std::deque<Entry> pending;
+    mutable std::mutex lock;
+    std::condition_variable spaceAvailable;
+    std::condition_variable drained;
+    bool drainScheduled;            // A job delivering the pending events is scheduled or running
+    EventDispatchStats stats;
+    std::unique_ptr<EventWorkerPool> dedicatedThread;
+    EventWorkerPool* executor;
+
+    // no copies allowed. Scheduled jobs refer to this object
+    EventDispatchQueue(const EventDispatchQueue&);
+    EventDispatchQueue& operator = (const EventDispatchQueue&);
+
+    void Drain()
+    {
+        for (;;)
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            if (pending.empty())
+            {
+                drainScheduled = false;
+                drained.notify_all();
+                return;
+            }
+            Entry entry(std::move(pending.front().Arg), pending.front().QueuedAt);
+            pending.pop_front();
+            stats.Depth = pending.size();
+            auto latency = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(clock_t::now() - entry.QueuedAt).count());
+            stats.TotalLatencyMicroseconds += latency;
+            stats.MaxLatencyMicroseconds = std::max<uint64_t>(stats.MaxLatencyMicroseconds, latency);
+            ++stats.Delivered;
+            spaceAvailable.notify_one();
+            guard.unlock();
+
+            try
+            {
+                deliver(entry.Arg);
+            }
+            catch (...)
+            {
+                // There is nobody to report to on a worker thread
+                guard.lock();
+                ++stats.Failed;
+            }
+        }
+    }
+
+public:
+    EventDispatchQueue(const EventDispatchPolicy& dispatchPolicy, deliver_func_t deliverFunc) :
+        policy(dispatchPolicy), deliver(deliverFunc), drainScheduled(false), executor(nullptr)
+    {
+        policy.Capacity = std::max<size_t>(1, policy.Capacity);
+        if (EventDispatchMode::DedicatedThread == policy.Mode)
+        {
+            dedicatedThread = EventWorkerPool::CreateDedicated();
+            executor = dedicatedThread.get();
+        }
+        else
+        {
+            executor = &EventWorkerPool::Shared();
+        }
+    }
+
+    // Delivers the pending events before returning. Must not be called from a delegate of this queue.
+    ~EventDispatchQueue()
+    {
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            drained.wait(guard, [this] { return !drainScheduled; });
+        }
+        dedicatedThread.reset();
+    }
+
+    /// Summary:
+    ///     Queues an event for delivery. Called on the host thread.
+    void Push(StoredArg&& arg)
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        ++stats.Queued;
+        if (pending.size() >= policy.Capacity)
+        {
+            switch (policy.Overflow)
+            {
+            case QueueOverflowPolicy::DropOldest:
+                pending.pop_front();
+                ++stats.Dropped;
+                break;
+            case QueueOverflowPolicy::CoalesceLatest:
+                pending.back() = Entry(std::move(arg), clock_t::now());
+                ++stats.Coalesced;
+                return;
+            case QueueOverflowPolicy::Block:
+                ++stats.Blocked;
+                // A delegate that waits for the host thread would never make room, so the wait is bounded
+                if (!spaceAvailable.wait_for(guard, std::chrono::milliseconds(policy.BlockTimeoutMilliseconds), [this] { return pending.size() < policy.Capacity; }))
+                {
+                    pending.pop_front();
+                    ++stats.Dropped;
+                    ++stats.BlockTimeouts;
+                }
+                break;
+            }
+        }
+        pending.push_back(Entry(std::move(arg), clock_t::now()));
+        stats.Depth = pending.size();
+        stats.MaxDepth = std::max<size_t>(stats.MaxDepth, stats.Depth);
+        if (drainScheduled)
+            return;
+        drainScheduled = true;
+        guard.unlock();
+        if (!executor->Schedule([this] { Drain(); }))
+            Drain();
+    }
+
+    EventDispatchStats Stats() const
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return stats;
+    }
+
+    const EventDispatchPolicy& Policy() const { return policy; }
+};
@@ -0,0 +1,345 @@
+#pragma once
+
+#include <stdint.h>
+#include <array>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include "SpotPlugin.h"
+#include "PluginHost.h"
+#include "EventSource.h"
+
+namespace HostInterop
+{
+    class EventHub;
+
+    /// Summary:
+    ///     A typed channel of an EventHub. The hub routes the events of one host event to it.
+    class IEventChannel
+    {
+        friend class EventHub;
+
+    protected:
+        IEventChannel() {}
+
+        // Converts the raw argument and calls the delegates, or queues it for them
+        virtual void HandleHostEvent(uintptr_t args) = 0;
+
+        // Delivers the queued events and calls the delegates inline from now on
+        virtual void ResetDispatch() = 0;
+
+    private:
+        // no copies allowed. The hub refers to this object
+        IEventChannel(const IEventChannel&);
+        IEventChannel& operator = (const IEventChannel&);
+
+    public:
+        virtual ~IEventChannel() {}
+
+        virtual SpotPluginApi::host_event_t HostEvent() const = 0;
+        virtual size_t DelegateCount() const = 0;
+    };
+
+    struct EventHubStats
+    {
+        EventHubStats() : BindActions(0), UnbindActions(0), BoundEvents(0), RefusedEvents(0)
+        { }
+
+        uint64_t BindActions;           // BindEventHandler host actions, each with all the events that were bound
+        uint64_t UnbindActions;
+        size_t BoundEvents;             // Host events bound right now
+        size_t RefusedEvents;           // Host events with delegates that the host refused to bind
+    };
+
+    /// Summary:
+    ///     Routes the host events to typed channels through one event handler.
+    ///     The channels are kept in a table indexed by the host event, so an event costs an array lookup
+    ///     and a virtual call before its argument is converted. A host event is bound while its channel has
+    ///     delegates and unbound when the last one is removed. All events that need binding or unbinding at
+    ///     the same time are passed to the host in the HostEventSourceList of a single host action.
+    ///     SuspendBinding collects the changes of several channels into one such action, for example while
+    ///     a plug-in adds its delegates during loading. If the host refuses the action, e.g. an older host that
+    ///     does not know one of the events, the events are bound one at a time, so only the unknown ones stay
+    ///     unbound. A refused event is not tried again until its channel has lost all its delegates.
+    ///     Channels are owned by the hub and live as long as it does. Adding and removing delegates may call
+    ///     the host, so it belongs on the host thread (or in a delegate, which is allowed).
+    class EventHub
+    {
+    public:
+        // Host events with a larger value cannot have a channel
+        static const size_t table_size = 32;
+
+    private:
+        std::array<std::unique_ptr<IEventChannel>, table_size> channels;   // Slots are set once and never replaced
+        std::array<bool, table_size> bound;                                  // Guarded by lock
+        std::array<bool, table_size> refused;                                // Guarded by lock
+        mutable std::mutex lock;
+        unsigned suspendCount;
+        bool isShutdown;
+        EventHubStats stats;
+
+        // no copies allowed. The host and the channels refer to this object
+        EventHub(const EventHub&);
+        EventHub& operator = (const EventHub&);
+
+        static void SPOTPLUGINAPI dispatch_to_channel(SpotPluginApi::host_event_t hostEvent, uintptr_t args, uintptr_t hub)
+        {
+            auto& table = reinterpret_cast<EventHub*>(hub)->channels;
+            if (hostEvent < table_size && table[hostEvent])
+                table[hostEvent]->HandleHostEvent(args);
+        }
+
+        bool DoBindingAction(SpotPluginApi::host_action_t action, std::vector<SpotPluginApi::host_event_t>& hostEvents)
+        {
+            SpotPluginApi::msg_event_handler_binding_t eventBinding;
+            eventBinding.EventHandler = dispatch_to_channel;
+            eventBinding.UserData = reinterpret_cast<uintptr_t>(this);
+            eventBinding.EventSourceListLength = hostEvents.size();
+            eventBinding.HostEventSourceList = hostEvents.data();
+            return PluginHost::DoAction(action, 0, &eventBinding);
+        }
+
+        void MarkBound(SpotPluginApi::host_event_t hostEvent)
+        {
+            bound[hostEvent] = true;
+            ++stats.BoundEvents;
+        }
+
+        void MarkRefused(SpotPluginApi::host_event_t hostEvent)
+        {
+            refused[hostEvent] = true;
+            ++stats.RefusedEvents;
+        }
+
+        // Binds the events of the channels that gained delegates and unbinds those that lost them.
+        // Must be called with lock held.
+        void Sync()
+        {
+            if (suspendCount > 0 || isShutdown)
+                return;
+            std::vector<SpotPluginApi::host_event_t> toBind;
+            std::vector<SpotPluginApi::host_event_t> toUnbind;
+            for (size_t i = 0; i < table_size; ++i)
+            {
+                bool wanted = channels[i] && channels[i]->DelegateCount() > 0;
+                if (!wanted && refused[i])
+                {
+                    refused[i] = false;
+                    --stats.RefusedEvents;
+                }
+                if (wanted && !bound[i] && !refused[i])
+                    toBind.push_back(static_cast<SpotPluginApi::host_event_t>(i));
+                else if (!wanted && bound[i])
+                    toUnbind.push_back(static_cast<SpotPluginApi::host_event_t>(i));
+            }
+            if (!toBind.empty())
+            {
+                ++stats.BindActions;
+                if (DoBindingAction(SpotPluginApi::HostActionRequest::BindEventHandler, toBind))
+                {
+                    for (auto hostEvent : toBind)
+                        MarkBound(hostEvent);
+                }
+                else if (1 == toBind.size())
+                {
+                    MarkRefused(toBind.front());
+                }
+                else
+                {
+                    // One unknown event makes the host refuse all of them, so find out which it is
+                    for (auto hostEvent : toBind)
+                    {
+                        std::vector<SpotPluginApi::host_event_t> single(1, hostEvent);
+                        ++stats.BindActions;
+                        if (DoBindingAction(SpotPluginApi::HostActionRequest::BindEventHandler, single))
+                            MarkBound(hostEvent);
+                        else
+                            MarkRefused(hostEvent);
+                    }
+                }
+            }
+            if (!toUnbind.empty())
+            {
+                ++stats.UnbindActions;
+                DoBindingAction(SpotPluginApi::HostActionRequest::UnbindEventHandler, toUnbind);
+                for (auto hostEvent : toUnbind)
+                    bound[hostEvent] = false;
+                stats.BoundEvents -= toUnbind.size();
+            }
+        }
+
+    public:
+        EventHub() : suspendCount(0), isShutdown(false)
+        {
+            bound.fill(false);
+            refused.fill(false);
+        }
+
+        ~EventHub()
+        {
+            Shutdown();
+        }
+
+        /// Summary:
+        ///     The hub of the host events of the plug-in, see HostEvents. It is never destroyed, because
+        ///     objects with static storage such as VariableManager::StandardVars() remove their delegates
+        ///     from its channels in their destructors, which may run after any static hub would be gone.
+        static EventHub& Instance()
+        {
+            static EventHub* instance = new EventHub();
+            return *instance;
+        }
+
+        /// Summary:
+        ///     The channel of a host event. It is created on first use with the converter of ChannelType.
+        /// Throws:
+        ///     out_of_range if hostEvent is not below table_size
+        ///     invalid_argument if the channel already exists with a different type
+        template<typename ChannelType>
+        ChannelType& Channel(SpotPluginApi::host_event_t hostEvent)
+        {
+            if (hostEvent >= table_size)
+                throw std::out_of_range(std::string("The host event (").append(std::to_string(hostEvent)).append(") is out of range of the event hub"));
+            std::lock_guard<std::mutex> guard(lock);
+            auto& slot = channels[hostEvent];
+            if (!slot)
+            {
+                std::unique_ptr<ChannelType> channel(new ChannelType(*this, hostEvent));
+                auto& created = *channel;
+                slot = std::move(channel);
+                return created;
+            }
+            auto existing = dynamic_cast<ChannelType*>(slot.get());
+            if (nullptr == existing)
+                throw std::invalid_argument(std::string("The host event (").append(std::to_string(hostEvent)).append(") has a channel of a different type"));
+            return *existing;
+        }
+
+        // Binds or unbinds the host event of a channel after its delegates changed
+        void Update()
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            Sync();
+        }
+
+        bool IsBound(SpotPluginApi::host_event_t hostEvent) const
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            return hostEvent < table_size && bound[hostEvent];
+        }
+
+        // true if the host refused to bind the event of a channel that has delegates
+        bool IsRefused(SpotPluginApi::host_event_t hostEvent) const
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            return hostEvent < table_size && refused[hostEvent];
+        }
+
+        // Delays binding and unbinding until every SuspendBinding call has been matched by ResumeBinding
+        void SuspendBinding()
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            ++suspendCount;
+        }
+
+        // Makes the changes since SuspendBinding with at most one bind and one unbind host action
+        void ResumeBinding()
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (0 == suspendCount)
+                throw std::logic_error("ResumeBinding was called without SuspendBinding");
+            --suspendCount;
+            Sync();
+        }
+
+        /// Summary:
+        ///     Unbinds all host events with one host action and switches every channel to inline dispatch,
+        ///     which delivers the queued events and stops the dispatch threads. Channels keep their delegates
+        ///     but get no more events. Must be called before the plug-in library is unloaded, because threads
+        ///     cannot be joined while the loader lock is held.
+        void Shutdown()
+        {
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                if (isShutdown)
+                    return;
+                isShutdown = true;
+                std::vector<SpotPluginApi::host_event_t> toUnbind;
+                for (size_t i = 0; i < table_size; ++i)
+                {
+                    if (bound[i])
+                        toUnbind.push_back(static_cast<SpotPluginApi::host_event_t>(i));
+                }
+                if (!toUnbind.empty())
+                {
+                    ++stats.UnbindActions;
+                    DoBindingAction(SpotPluginApi::HostActionRequest::UnbindEventHandler, toUnbind);
+                    bound.fill(false);
+                    stats.BoundEvents = 0;
+                }
+            }
+            // Outside the lock, the queued events may call delegates that add or remove delegates.
+            // Slots are never replaced, so the channels can be used without it.
+            for (auto& channel : channels)
+            {
+                if (channel)
+                    channel->ResetDispatch();
+            }
+        }
+
+        EventHubStats Stats() const
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            return stats;
+        }
+    };
+
+    /// Summary:
+    ///     An EventSource whose host event is bound by an EventHub. It has the delegates, the argument
+    ///     conversion and the dispatch policies of an EventSource. Adding the first delegate binds the host
+    ///     event and removing the last one unbinds it. Get one with EventHub::Channel.
+    template<typename ArgTransformFunc, typename EventArgType = typename ArgTransformFunc::result_type>
+    class EventChannel : public EventSource<ArgTransformFunc, EventArgType>, public IEventChannel
+    {
+        typedef EventSource<ArgTransformFunc, EventArgType> base_t;
+
+        EventHub* hub;
+
+        // no copies allowed. The hub refers to this object
+        EventChannel(const EventChannel&);
+        EventChannel& operator = (const EventChannel&);
+
+    protected:
+        virtual void HandleHostEvent(uintptr_t args)
+        {
+            base_t::HandleEvent(args);
+        }
+
+        virtual void ResetDispatch()
+        {
+            base_t::SetDispatchPolicy(EventDispatchPolicy());
+        }
+
+        // Binds the host event on the first delegate and unbinds it after the last
+        virtual void OnDelegatesChanged()
+        {
+            hub->Update();
+        }
+
+    public:
+        typedef typename base_t::arg_type arg_type;
+
+        EventChannel(EventHub& eventHub, SpotPluginApi::host_event_t hostEvent, ArgTransformFunc argTransform = ArgTransformFunc()) :
+            base_t(hostEvent, argTransform, typename base_t::unbound_t()), hub(&eventHub)
+        {
+        }
+
+        virtual SpotPluginApi::host_event_t HostEvent() const { return base_t::HostEvent(); }
+        virtual size_t DelegateCount() const { return base_t::DelegateCount(); }
+
+        // true while the host event is bound
+        virtual bool Listening() const { return hub->IsBound(HostEvent()); }
+    };
+}
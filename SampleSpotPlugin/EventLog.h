@@ -0,0 +1,494 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <algorithm>
+#include <vector>
+#include <sstream>
+#include <iomanip>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+#include <type_traits>
+#include "Utilities.h"
+#include "TextView.h"
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Binary event log file format
+//
+// A file starts with an EventLogFileHeader followed by EventLogRecord entries of RecordSize bytes.
+// Names are written as EventLogRecordKind::Name records before the first record that refers to them
+// and again at the start of every file after a rotation, so each file can be decoded on its own.
+
+namespace EventLogRecordKind
+{
+    enum
+    {
+        Name        = 0,    // Code: name id, Value: offset of Text in the name. Long names span several records
+        Integer     = 1,    // Code: name id, Value: the argument
+        Float       = 2,    // Code: name id, Value: the bits of a double argument
+        Text        = 3,    // Code: name id, Value: full length of the text. Text holds the first TextLength characters
+        HostEvent   = 4     // Code: host event, Value: the raw argument
+    };
+}
+
+struct EventLogRecord
+{
+    uint64_t Ticks;         // Time stamp in units of EventLogFileHeader::TicksPerSecond
+    uint64_t Value;
+    uint32_t ThreadId;
+    uint32_t Code;
+    uint16_t Kind;          // EventLogRecordKind
+    uint16_t TextLength;
+    char Text[36];
+};
+
+static_assert(sizeof(EventLogRecord) == 64, "Event log records must stay 64 bytes");
+
+struct EventLogFileHeader
+{
+    char Magic[8];          // "SPOTELOG"
+    uint32_t Version;
+    uint32_t RecordSize;
+    uint64_t TicksPerSecond;
+    uint64_t Reserved;
+};
+
+static const uint32_t event_log_file_version = 1;
+
+/// Summary:
+///     Formats a record as a line of text. Name records return an empty string.
+/// Arguments:
+///     names - The names read so far, indexed by name id
+///     startTicks - The time stamp that is shown as time 0
+inline std::string format_event_log_record(const EventLogRecord& record, const std::vector<std::string>& names, uint64_t ticksPerSecond, uint64_t startTicks)
+{
+    if (EventLogRecordKind::Name == record.Kind)
+        return std::string();
+
+    std::ostringstream line;
+    double seconds = ticksPerSecond ? static_cast<double>(record.Ticks - startTicks) / ticksPerSecond : 0.0;
+    line << std::fixed << std::setprecision(6) << seconds << " [" << record.ThreadId << "] ";
+    if (EventLogRecordKind::HostEvent == record.Kind)
+    {
+        line << "Dispatching event: " << record.Code << " with argument: " << record.Value;
+        return line.str();
+    }
+
+    line << "Event: {" << (record.Code < names.size() ? names[record.Code] : std::string("#").append(std::to_string(static_cast<unsigned long long>(record.Code)))) << "} Args: {";
+    switch (record.Kind)
+    {
+    case EventLogRecordKind::Integer:
+        line << record.Value;
+        break;
+    case EventLogRecordKind::Float:
+        {
+            double value;
+            memcpy(&value, &record.Value, sizeof(value));
+            line.unsetf(std::ios_base::floatfield);
+            line << value;
+        }
+        break;
+    case EventLogRecordKind::Text:
+        line.write(record.Text, record.TextLength);
+        if (record.Value > record.TextLength)
+            line << "...";
+        break;
+    default:
+        line << "?";
+        break;
+    }
+    line << "}";
+    return line.str();
+}
+
+
+/// Summary:
+///     Asynchronous binary event log.
+///     Write calls copy a fixed size record into a lock-free ring buffer that any number of threads can write to.
+///     They do not allocate, lock or do I/O, and they drop the record when the ring is full. A background
+///     thread moves the records to a binary file that is rotated by size and optionally echoes them
+///     as text to the debugger. Use the EventLogDecoder tool to render the files as text.
+class EventLog
+{
+public:
+    static const size_t ring_capacity = 8192;      // Must be a power of 2
+
+private:
+    // Bounded queue after D. Vyukov. A cell is free for the writer claiming position p when its sequence
+    // is p and holds a record for the reader at position p when its sequence is p + 1.
+    struct Cell
+    {
+        std::atomic<size_t> Sequence;
+        EventLogRecord Record;
+    };
+
+    Cell* cells;
+    std::atomic<size_t> enqueuePosition;
+    size_t dequeuePosition;                     // Only used by the writer thread
+    std::atomic<size_t> droppedCount;
+    uint64_t ticksPerSecond;
+
+    std::mutex nameLock;                        // Guards names
+    std::vector<std::string> names;
+
+    std::mutex fileLock;                        // Guards the members below and serializes draining the ring
+    std::condition_variable stopRequested;
+    std::thread writerThread;
+    bool stopping;
+    FILE* file;
+    std::string filePath;
+    size_t maxFileSize;
+    unsigned maxFileCount;
+    size_t fileSize;
+    size_t namesWritten;
+    bool echoToDebugger;
+
+    // no copies allowed. This is a singleton
+    EventLog(const EventLog&);
+    EventLog& operator = (const EventLog&);
+
+    EventLog() :
+        cells(new Cell[ring_capacity]), enqueuePosition(0), dequeuePosition(0), droppedCount(0),
+        stopping(false), file(nullptr), maxFileSize(0), maxFileCount(0), fileSize(0), namesWritten(0), echoToDebugger(false)
+    {
+        static_assert(0 == (ring_capacity & (ring_capacity - 1)), "ring_capacity must be a power of 2");
+        for (size_t i = 0; i < ring_capacity; ++i)
+            cells[i].Sequence.store(i, std::memory_order_relaxed);
+        ticksPerSecond = performance_counter_frequency();
+    }
+
+    ~EventLog()
+    {
+        Close();
+        delete[] cells;
+    }
+
+    static uint32_t CurrentThreadId()
+    {
+#ifdef _WIN32
+        return static_cast<uint32_t>(GetCurrentThreadId());
+#else
+        return static_cast<uint32_t>(std::hash<std::thread::id>()(std::this_thread::get_id()));
+#endif
+    }
+
+    // Claims a cell, lets fill write the record and publishes it. Returns false if the ring is full.
+    template<typename FillFunc>
+    bool Enqueue(uint16_t kind, uint32_t code, uint64_t value, FillFunc fill)
+    {
+        Cell* cell;
+        size_t position = enqueuePosition.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            cell = &cells[position & (ring_capacity - 1)];
+            size_t sequence = cell->Sequence.load(std::memory_order_acquire);
+            intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (0 == difference)
+            {
+                if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (difference < 0)
+            {
+                droppedCount.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            else
+            {
+                position = enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+
+        auto& record = cell->Record;
+        record.Ticks = performance_counter();
+        record.Value = value;
+        record.ThreadId = CurrentThreadId();
+        record.Code = code;
+        record.Kind = kind;
+        record.TextLength = 0;
+        fill(record);
+        cell->Sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Must be called with fileLock held
+    bool Dequeue(EventLogRecord& record)
+    {
+        auto& cell = cells[dequeuePosition & (ring_capacity - 1)];
+        if (cell.Sequence.load(std::memory_order_acquire) != dequeuePosition + 1)
+            return false;
+        record = cell.Record;
+        cell.Sequence.store(dequeuePosition + ring_capacity, std::memory_order_release);
+        ++dequeuePosition;
+        return true;
+    }
+
+    static void CopyText(EventLogRecord& record, const char* text, size_t length)
+    {
+        record.TextLength = static_cast<uint16_t>(std::min<size_t>(length, sizeof(record.Text)));
+        memcpy(record.Text, text, record.TextLength);
+    }
+
+    // Must be called with fileLock held
+    void WriteRecord(const EventLogRecord& record)
+    {
+        if (file && 1 == fwrite(&record, sizeof(record), 1, file))
+            fileSize += sizeof(record);
+    }
+
+    // Must be called with fileLock held
+    void WriteNames(size_t first, size_t last)
+    {
+        std::lock_guard<std::mutex> guard(nameLock);
+        for (size_t id = first; id < last; ++id)
+        {
+            const auto& name = names[id];
+            size_t offset = 0;
+            do
+            {
+                EventLogRecord record;
+                memset(&record, 0, sizeof(record));
+                record.Kind = EventLogRecordKind::Name;
+                record.Code = static_cast<uint32_t>(id);
+                record.Value = offset;
+                CopyText(record, name.data() + offset, name.size() - offset);
+                WriteRecord(record);
+                offset += record.TextLength;
+            } while (offset < name.size());
+        }
+    }
+
+    // Must be called with fileLock held
+    bool OpenFile()
+    {
+        file = fopen(filePath.c_str(), "wb");
+        if (nullptr == file)
+            return false;
+        EventLogFileHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.Magic, "SPOTELOG", sizeof(header.Magic));
+        header.Version = event_log_file_version;
+        header.RecordSize = sizeof(EventLogRecord);
+        header.TicksPerSecond = ticksPerSecond;
+        fwrite(&header, sizeof(header), 1, file);
+        fileSize = sizeof(header);
+        WriteNames(0, namesWritten);
+        return true;
+    }
+
+    // Must be called with fileLock held
+    void RotateFile()
+    {
+        fclose(file);
+        file = nullptr;
+        // log, log.1 ... log.N-1 become log.1, log.2 ... log.N
+        for (unsigned i = maxFileCount - 1; i > 0; --i)
+        {
+            auto older = filePath + "." + std::to_string(static_cast<unsigned long long>(i));
+            if (i == maxFileCount - 1)
+                remove(older.c_str());
+            auto newer = (1 == i) ? filePath : filePath + "." + std::to_string(static_cast<unsigned long long>(i - 1));
+            rename(newer.c_str(), older.c_str());
+        }
+        if (maxFileCount <= 1)
+            remove(filePath.c_str());
+        OpenFile();
+    }
+
+    // Moves all queued records to the file. Must be called with fileLock held.
+    size_t Drain()
+    {
+        size_t nameCount;
+        {
+            std::lock_guard<std::mutex> guard(nameLock);
+            nameCount = names.size();
+        }
+        // Names are registered before records can refer to them, so writing the new ones first keeps the order
+        if (nameCount > namesWritten)
+        {
+            WriteNames(namesWritten, nameCount);
+            namesWritten = nameCount;
+        }
+
+        std::vector<std::string> echoNames;
+        size_t count = 0;
+        EventLogRecord record;
+        while (Dequeue(record))
+        {
+            WriteRecord(record);
+            ++count;
+#ifdef _WIN32
+            if (echoToDebugger)
+            {
+                if (echoNames.empty())
+                {
+                    std::lock_guard<std::mutex> guard(nameLock);
+                    echoNames = names;
+                }
+                auto line = format_event_log_record(record, echoNames, ticksPerSecond, 0).append("\n");
+                OutputDebugStringA(line.c_str());
+            }
+#endif
+            if (maxFileSize && fileSize >= maxFileSize)
+                RotateFile();
+        }
+        if (file && count)
+            fflush(file);
+        return count;
+    }
+
+    void RunWriter()
+    {
+        std::unique_lock<std::mutex> guard(fileLock);
+        while (!stopping)
+        {
+            Drain();
+            stopRequested.wait_for(guard, std::chrono::milliseconds(20));
+        }
+        Drain();
+    }
+
+public:
+    static EventLog& Instance()
+    {
+        static EventLog instance;
+        return instance;
+    }
+
+    /// Summary:
+    ///     Starts writing the log to a file. Records written before Open are kept in the ring until then.
+    /// Arguments:
+    ///     path - The file to write. Older files are renamed to path.1, path.2 ...
+    ///     maxFileBytes - The size at which the file is rotated. 0 never rotates.
+    ///     maxFiles - The number of files kept including the current one.
+    ///     echo - Also send every record as text to the debugger output. This formats on the writer thread.
+    /// Returns:
+    ///     false if the file could not be created
+    bool Open(const std::string& path, size_t maxFileBytes = 4 * 1024 * 1024, unsigned maxFiles = 4, bool echo = false)
+    {
+        Close();
+        std::lock_guard<std::mutex> guard(fileLock);
+        filePath = path;
+        maxFileSize = maxFileBytes;
+        maxFileCount = std::max<unsigned>(1, maxFiles);
+        echoToDebugger = echo;
+        namesWritten = 0;
+        if (!OpenFile())
+            return false;
+        stopping = false;
+        writerThread = std::thread(&EventLog::RunWriter, this);
+        return true;
+    }
+
+    // Writes the queued records and stops the writer thread. Must be called before the plug-in library is unloaded.
+    void Close()
+    {
+        {
+            std::lock_guard<std::mutex> guard(fileLock);
+            stopping = true;
+            stopRequested.notify_all();
+        }
+        if (writerThread.joinable())
+            writerThread.join();
+        std::lock_guard<std::mutex> guard(fileLock);
+        if (file)
+        {
+            fclose(file);
+            file = nullptr;
+        }
+    }
+
+    bool IsOpen() const { return nullptr != file; }
+
+    /// Summary:
+    ///     Returns the id to write records for a name. Registering the same name twice returns the same id.
+    ///     This allocates and takes a lock so it should be done once per name, not per record.
+    uint32_t RegisterName(const std::string& name)
+    {
+        std::lock_guard<std::mutex> guard(nameLock);
+        auto existing = std::find(names.begin(), names.end(), name);
+        if (existing != names.end())
+            return static_cast<uint32_t>(existing - names.begin());
+        names.push_back(name);
+        return static_cast<uint32_t>(names.size() - 1);
+    }
+
+    bool WriteInteger(uint32_t nameId, uint64_t value)
+    {
+        return Enqueue(EventLogRecordKind::Integer, nameId, value, [] (EventLogRecord&) { });
+    }
+
+    bool WriteFloat(uint32_t nameId, double value)
+    {
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return Enqueue(EventLogRecordKind::Float, nameId, bits, [] (EventLogRecord&) { });
+    }
+
+    bool WriteText(uint32_t nameId, const char* text, size_t length)
+    {
+        return Enqueue(EventLogRecordKind::Text, nameId, length, [=] (EventLogRecord& record) { CopyText(record, text, length); });
+    }
+
+    bool WriteHostEvent(uint32_t hostEvent, uintptr_t args)
+    {
+        return Enqueue(EventLogRecordKind::HostEvent, hostEvent, args, [] (EventLogRecord&) { });
+    }
+
+    // Writes an event argument as the matching record kind
+    bool Write(uint32_t nameId, const char* text)
+    {
+        return text ? WriteText(nameId, text, strlen(text)) : WriteText(nameId, "(null)", 6);
+    }
+
+    bool Write(uint32_t nameId, char* text)
+    {
+        return Write(nameId, const_cast<const char*>(text));
+    }
+
+    bool Write(uint32_t nameId, const std::string& text)
+    {
+        return WriteText(nameId, text.data(), text.size());
+    }
+
+    bool Write(uint32_t nameId, const TextView& text)
+    {
+        return WriteText(nameId, text.Data(), text.Size());
+    }
+
+    template<typename T>
+    bool Write(uint32_t nameId, const T& value)
+    {
+        return WriteValue(nameId, value, std::integral_constant<int, std::is_floating_point<T>::value ? 2 : (std::is_integral<T>::value || std::is_enum<T>::value) ? 1 : 0>());
+    }
+
+    // Records lost because the ring was full
+    size_t Dropped() const { return droppedCount.load(std::memory_order_relaxed); }
+
+private:
+    template<typename T>
+    bool WriteValue(uint32_t nameId, const T& value, std::integral_constant<int, 1>)
+    {
+        return WriteInteger(nameId, static_cast<uint64_t>(value));
+    }
+
+    template<typename T>
+    bool WriteValue(uint32_t nameId, const T& value, std::integral_constant<int, 2>)
+    {
+        return WriteFloat(nameId, static_cast<double>(value));
+    }
+
+    // Other types are formatted with operator<<, which allocates
+    template<typename T>
+    bool WriteValue(uint32_t nameId, const T& value, std::integral_constant<int, 0>)
+    {
+        std::ostringstream text;
+        text << value;
+        return Write(nameId, text.str());
+    }
+};
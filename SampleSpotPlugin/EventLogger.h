@@ -1,25 +1,24 @@
 #pragma once
-#include "stdafx.h"
 #include <memory>
 #include <string>
-#include <sstream>
 #include "EventDelegate.h"
+#include "EventLog.h"
 
 
+/// Summary:
+///     Writes every event with its argument to the EventLog.
+///     The name is registered once when the logger is created so logging an event does not allocate.
 template<typename ArgType>
 class EventLogger : public EventDelegate<ArgType>
 {
 private:
-    std::string name;
+    uint32_t nameId;
 public:
-    EventLogger(const std::string name) : name(name) {}
+    EventLogger(const std::string name) : nameId(EventLog::Instance().RegisterName(name)) {}
 
     virtual void operator()(ArgType &args)
     {
-        std::ostringstream message;
-        message << "Event: {"<< name << "} Args: {" << args << "}" << std::endl;
-        auto msg = message.str();
-        OutputDebugStringA(msg.c_str());
+        EventLog::Instance().Write(nameId, args);
     }
 };
 
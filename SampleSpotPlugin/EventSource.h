@@ -2,7 +2,9 @@
 #include "SpotPlugin.h"
 #include "PluginHost.h"
 #include "MulticastEventDelegate.h"
+#include "EventDispatchQueue.h"
 #include <functional>
+#include <memory>
 
 
 /// Summary:
@@ -11,14 +13,19 @@ template<typename ArgTransformFunc, typename EventArgType = typename ArgTransfor
 class EventSource
 {
 public:
-    typedef typename EventArgType arg_type;
-    typedef typename ArgTransformFunc unary_function;
+    typedef EventArgType arg_type;
+    typedef ArgTransformFunc unary_function;
 
 private:
+    typedef event_arg_storage<arg_type> arg_storage;
+    typedef EventDispatchQueue<typename arg_storage::type> dispatch_queue_t;
+
     MulticastEventDelegate<arg_type> eventDelegate;
     SpotPluginApi::host_event_t targetEvent;
     bool isEnabled;
+    bool bindsHost;                                     // false if someone else binds the host event
     ArgTransformFunc argTransformFunc;
+    std::unique_ptr<dispatch_queue_t> dispatchQueue;    // nullptr when the delegates run inline
 
 
     static void SPOTPLUGINAPI dispatch_to_owner(SpotPluginApi::host_event_t hostEvent, uintptr_t args, uintptr_t source)
@@ -30,17 +37,43 @@ private:
     EventSource(const EventSource&); 
     EventSource& operator = (const EventSource& );
 
-    void HandleEvent(uintptr_t rawArgs)
+    void DeliverQueuedEvent(typename arg_storage::type& storedArg)
     {
-        auto realArg = argTransformFunc(rawArgs);
+        arg_type realArg = arg_storage::View(storedArg);
         eventDelegate(realArg);
     }
 
+protected:
+    struct unbound_t {};
+
+    // For a derived source whose host binding is made by someone else (see HostInterop::EventHub).
+    // Enable and Disable do nothing, HandleEvent must be called for every event instead.
+    EventSource(SpotPluginApi::host_event_t hostEvent, ArgTransformFunc argTransform, unbound_t) :
+        targetEvent(hostEvent), isEnabled(false), bindsHost(false), argTransformFunc(argTransform)
+    {
+    }
+
+    // Called after a delegate has been added or removed
+    virtual void OnDelegatesChanged()
+    {
+    }
+
+    void HandleEvent(uintptr_t rawArgs)
+    {
+        // The argument is always converted on the host thread while the raw value is valid.
+        // Converters that return a reference are not copied.
+        arg_type realArg = argTransformFunc(rawArgs);
+        if (dispatchQueue)
+            dispatchQueue->Push(arg_storage::Store(std::move(realArg)));
+        else
+            eventDelegate(realArg);
+    }
+
 
 public:
 
     EventSource(SpotPluginApi::host_event_t hostEvent, ArgTransformFunc argTransform = ArgTransformFunc()) :
-        targetEvent(hostEvent), argTransformFunc(argTransform), isEnabled(false)
+        targetEvent(hostEvent), isEnabled(false), bindsHost(true), argTransformFunc(argTransform)
     {
         Enable();
     }
@@ -48,10 +81,14 @@ public:
     // Move constructor
     EventSource (EventSource && rhs)
     {
+        auto policy = rhs.DispatchPolicy();
+        rhs.SetDispatchPolicy(EventDispatchPolicy());
+        SetDispatchPolicy(policy);
         eventDelegate = std::move(rhs.eventDelegate);
         targetEvent = std::move(rhs.targetEvent);
         argTransformFunc = std::move(rhs.argTransformFunc);
         isEnabled = rhs.isEnabled;
+        bindsHost = rhs.bindsHost;
         // Setting this will disable ownership of the event
         if (rhs.isEnabled)
         {
@@ -62,12 +99,16 @@ public:
 
     EventSource& operator = (EventSource && rhs)
     {
-        if (this != &other)
+        if (this != &rhs)
         {
+            auto policy = rhs.DispatchPolicy();
+            rhs.SetDispatchPolicy(EventDispatchPolicy());
+            SetDispatchPolicy(policy);
             eventDelegate = std::move(rhs.eventDelegate);
             targetEvent = std::move(rhs.targetEvent);
             argTransformFunc = std::move(rhs.argTransformFunc);
             isEnabled = rhs.isEnabled;
+            bindsHost = rhs.bindsHost;
             // Setting this will disable ownership of the event
             if (rhs.isEnabled)
             {
@@ -78,28 +119,87 @@ public:
         return *this;
     }
 
-    ~EventSource()
+    virtual ~EventSource()
     {
         Disable();
+        dispatchQueue.reset();
+    }
+
+    /// Summary:
+    ///     Selects the thread the delegates run on. With a mode other than EventDispatchMode::Inline the
+    ///     host callback only queues the converted argument and returns, so slow delegates do not stall
+    ///     the host. The delegates of one source are always called one event at a time in the order received.
+    ///     Events queued under the previous policy are delivered before this returns, so it must not be
+    ///     called from one of the delegates of this source.
+    ///     The host is not thread safe and only accepts calls on its own thread. Delegates of a source with
+    ///     an asynchronous policy must not call the host, e.g. to get or set variables. Keep such delegates
+    ///     on a source with inline dispatch or hand their results to the host thread.
+    void SetDispatchPolicy(const EventDispatchPolicy& policy)
+    {
+        dispatchQueue.reset();
+        if (EventDispatchMode::Inline != policy.Mode)
+            dispatchQueue.reset(new dispatch_queue_t(policy, [this] (typename arg_storage::type& storedArg) { DeliverQueuedEvent(storedArg); }));
+    }
+
+    EventDispatchPolicy DispatchPolicy() const
+    {
+        return dispatchQueue ? dispatchQueue->Policy() : EventDispatchPolicy();
+    }
+
+    // Queue depth and latency counters. All zero for inline dispatch.
+    EventDispatchStats DispatchStats() const
+    {
+        return dispatchQueue ? dispatchQueue->Stats() : EventDispatchStats();
     }
 
     void AddDelegate(std::shared_ptr<EventDelegate<EventArgType>> d)
     {
         eventDelegate.AddDelegate(d);
+        OnDelegatesChanged();
+    }
+
+    // Adds a delegate that is called before all delegates added so far
+    void AddDelegateFirst(std::shared_ptr<EventDelegate<EventArgType>> d)
+    {
+        eventDelegate.AddDelegateFirst(d);
+        OnDelegatesChanged();
     }
 
     void RemoveDelegate(std::shared_ptr<EventDelegate<EventArgType>> d)
     {
         eventDelegate.RemoveDelegate(d);
+        OnDelegatesChanged();
     }
 
     void RemoveDelegate(const EventDelegate<EventArgType>* d)
     {
         eventDelegate.RemoveDelegate(d);
+        OnDelegatesChanged();
     }
+
+    // Adds a callable that is stored with the delegates, see MulticastEventDelegate::Subscribe
+    template<typename Func>
+    delegate_token_t Subscribe(Func&& func)
+    {
+        auto token = eventDelegate.Subscribe(std::forward<Func>(func));
+        OnDelegatesChanged();
+        return token;
+    }
+
+    void Unsubscribe(delegate_token_t token)
+    {
+        eventDelegate.Unsubscribe(token);
+        OnDelegatesChanged();
+    }
+
+    size_t DelegateCount() const { return eventDelegate.Count(); }
+
+    SpotPluginApi::host_event_t HostEvent() const { return targetEvent; }
     
     void Enable()
     {
+        if (!bindsHost)
+            return;
         SpotPluginApi::msg_event_handler_binding_t eventBinding;
         eventBinding.EventHandler = dispatch_to_owner;
         eventBinding.EventSourceListLength = 1;
@@ -120,5 +220,5 @@ public:
         isEnabled = false;
     }
 
-    bool Listening() const { return isEnabled; }
+    virtual bool Listening() const { return isEnabled; }
 };
@@ -1,10 +1,13 @@
 #pragma once
 #include "EventSource.h"
 #include "EventArgConverters.h"
+#include "LiveFrame.h"
 
 typedef EventSource<EventArgNoOp>                raw_event_t;           // the original value passed from the host 
 typedef raw_event_t                              null_event_t;          // the event has no usable argument
 typedef EventSource<EventArgCastTo<int>>         integer_event_t;       // the event is an integer value
 typedef EventSource<EventArgCastTo<char*>>       write_string_event_t;  // the event is a pointer to a writable char buffer
 typedef EventSource<EventArgCastTo<const char*>> read_string_event_t;   // the event is a pointer to a read only C-style string
-typedef EventSource<EventArgToString>            string_event_t;        // the event is a std::string object
+typedef EventSource<EventArgToString>            string_event_t;        // the event is a std::string object copied from the host
+typedef EventSource<EventArgToTextView>          text_event_t;          // the event is a TextView of the host string
+typedef EventSource<EventArgToLiveFrame>         live_frame_event_t;    // the event is a HostInterop::LiveFrame that refers to the host pixels
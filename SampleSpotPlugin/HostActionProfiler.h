@@ -0,0 +1,342 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+#include "SpotPlugin.h"
+#include "PluginHost.h"
+#include "Utilities.h"
+
+/// Summary:
+///     Latency and call counters of one host action.
+///     Buckets[i] counts the calls that took from 2^i up to 2^(i+1) nanoseconds (bucket 0 also holds faster calls).
+struct HostActionStats
+{
+    static const size_t bucket_count = 40;
+
+    SpotPluginApi::host_action_t Action;
+    uint64_t Calls;
+    uint64_t Failures;              // Calls the host returned false for
+    uint64_t TotalNanoseconds;
+    uint64_t MaxNanoseconds;
+    uint64_t Buckets[bucket_count];
+
+    double MeanMicroseconds() const
+    {
+        return Calls ? TotalNanoseconds / 1000.0 / Calls : 0.0;
+    }
+
+    // Returns the upper bound of the bucket holding the given fraction (0 to 1) of the calls
+    uint64_t PercentileNanoseconds(double fraction) const
+    {
+        uint64_t target = static_cast<uint64_t>(fraction * Calls + 0.5);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < bucket_count; ++i)
+        {
+            seen += Buckets[i];
+            if (seen >= target && seen > 0)
+                return std::min<uint64_t>(uint64_t(2) << i, MaxNanoseconds);
+        }
+        return MaxNanoseconds;
+    }
+};
+
+/// Summary:
+///     Host time spent on one variable by the variable actions.
+///     Bulk actions split their time evenly over the variables in the list.
+struct HostVariableStats
+{
+    std::string Name;
+    uint64_t Gets;
+    uint64_t Sets;
+    uint64_t Failures;
+    uint64_t TotalNanoseconds;
+    uint64_t MaxNanoseconds;
+};
+
+struct HostActionProfile
+{
+    std::vector<HostActionStats> Actions;       // Actions that were called, slowest total first
+    std::vector<HostVariableStats> Variables;   // Variables that were accessed, slowest total first
+
+    std::string ToString() const;
+};
+
+/// Summary:
+///     Optional instrumentation of PluginHost::DoAction.
+///     While enabled every host action is timed and counted per action code, and the variable actions are
+///     also counted per variable name. The action counters are lock free. The variable counters take a lock
+///     and hash the name, but they do not allocate after the first call for a name.
+///     When disabled DoAction only pays for one atomic load.
+class HostActionProfiler : public PluginHost::IHostActionObserver
+{
+public:
+    static const size_t action_slot_count = 64;     // Action codes from this value up share the last slot
+
+private:
+    struct ActionCounters
+    {
+        std::atomic<uint64_t> Calls;
+        std::atomic<uint64_t> Failures;
+        std::atomic<uint64_t> TotalNanoseconds;
+        std::atomic<uint64_t> MaxNanoseconds;
+        std::atomic<uint64_t> Buckets[HostActionStats::bucket_count];
+    };
+
+    struct VariableCounters
+    {
+        uint64_t Gets;
+        uint64_t Sets;
+        uint64_t Failures;
+        uint64_t TotalNanoseconds;
+        uint64_t MaxNanoseconds;
+    };
+
+    ActionCounters actions[action_slot_count];
+    std::unordered_map<std::string, VariableCounters> variables;
+    mutable std::mutex variableLock;                // Guards variables and nameKey
+    std::string nameKey;                            // Reused to look up names without allocating
+    double nanosecondsPerTick;
+
+    // no copies allowed. This is a singleton
+    HostActionProfiler(const HostActionProfiler&);
+    HostActionProfiler& operator = (const HostActionProfiler&);
+
+    HostActionProfiler() :
+        nanosecondsPerTick(1e9 / performance_counter_frequency())
+    {
+        Reset();
+    }
+
+    static void StoreMax(std::atomic<uint64_t>& maximum, uint64_t value)
+    {
+        uint64_t current = maximum.load(std::memory_order_relaxed);
+        while (value > current && !maximum.compare_exchange_weak(current, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    static size_t BucketOf(uint64_t nanoseconds)
+    {
+        size_t bucket = 0;
+        while (nanoseconds > 1 && bucket + 1 < HostActionStats::bucket_count)
+        {
+            nanoseconds >>= 1;
+            ++bucket;
+        }
+        return bucket;
+    }
+
+    void RecordVariable(const char* name, bool isSet, bool succeeded, uint64_t nanoseconds)
+    {
+        if (nullptr == name)
+            return;
+        std::lock_guard<std::mutex> guard(variableLock);
+        nameKey.assign(name);
+        auto item = variables.find(nameKey);
+        if (variables.end() == item)
+        {
+            VariableCounters empty = {};
+            item = variables.insert(std::make_pair(nameKey, empty)).first;
+        }
+        auto& counters = item->second;
+        ++(isSet ? counters.Sets : counters.Gets);
+        if (!succeeded)
+            ++counters.Failures;
+        counters.TotalNanoseconds += nanoseconds;
+        counters.MaxNanoseconds = std::max<uint64_t>(counters.MaxNanoseconds, nanoseconds);
+    }
+
+public:
+    static HostActionProfiler& Instance()
+    {
+        static HostActionProfiler instance;
+        return instance;
+    }
+
+    // Starts or stops measuring host actions. The counters are kept when stopping.
+    static void Enable(bool enable)
+    {
+        PluginHost::ActionObserver.store(enable ? &Instance() : nullptr, std::memory_order_release);
+    }
+
+    static bool IsEnabled()
+    {
+        return nullptr != PluginHost::ActionObserver.load(std::memory_order_acquire);
+    }
+
+    void Reset()
+    {
+        for (auto& counters : actions)
+        {
+            counters.Calls.store(0);
+            counters.Failures.store(0);
+            counters.TotalNanoseconds.store(0);
+            counters.MaxNanoseconds.store(0);
+            for (auto& bucket : counters.Buckets)
+                bucket.store(0);
+        }
+        std::lock_guard<std::mutex> guard(variableLock);
+        variables.clear();
+    }
+
+    virtual void OnHostAction(SpotPluginApi::host_action_t action, const void *data, uint64_t elapsedTicks, bool succeeded)
+    {
+        using namespace SpotPluginApi;
+
+        auto nanoseconds = static_cast<uint64_t>(elapsedTicks * nanosecondsPerTick);
+        auto& counters = actions[std::min<size_t>(action, action_slot_count - 1)];
+        counters.Calls.fetch_add(1, std::memory_order_relaxed);
+        if (!succeeded)
+            counters.Failures.fetch_add(1, std::memory_order_relaxed);
+        counters.TotalNanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+        StoreMax(counters.MaxNanoseconds, nanoseconds);
+        counters.Buckets[BucketOf(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+
+        if (nullptr == data)
+            return;
+        switch (action)
+        {
+        case HostActionRequest::GetVariable:
+        case HostActionRequest::SetVariable:
+        case HostActionRequest::ResolveVariable:
+            RecordVariable(static_cast<const msg_get_set_variable_t*>(data)->VariableName, HostActionRequest::SetVariable == action, succeeded, nanoseconds);
+            break;
+        case HostActionRequest::GetVariables:
+        case HostActionRequest::SetVariables:
+            {
+                auto list = static_cast<const msg_get_set_variable_list_t*>(data);
+                if (0 == list->VariableListLength || nullptr == list->VariableList)
+                    break;
+                auto share = nanoseconds / list->VariableListLength;
+                for (size_t i = 0; i < list->VariableListLength; ++i)
+                {
+                    bool itemSucceeded = succeeded && (nullptr == list->StatusList || VariableStatus::Ok == list->StatusList[i]);
+                    RecordVariable(list->VariableList[i].VariableName, HostActionRequest::SetVariables == action, itemSucceeded, share);
+                }
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    // Copies the counters. Actions and variables that were not used are left out.
+    HostActionProfile Snapshot() const
+    {
+        HostActionProfile profile;
+        for (size_t i = 0; i < action_slot_count; ++i)
+        {
+            auto& counters = actions[i];
+            HostActionStats stats;
+            stats.Action = static_cast<SpotPluginApi::host_action_t>(i);
+            stats.Calls = counters.Calls.load(std::memory_order_relaxed);
+            if (0 == stats.Calls)
+                continue;
+            stats.Failures = counters.Failures.load(std::memory_order_relaxed);
+            stats.TotalNanoseconds = counters.TotalNanoseconds.load(std::memory_order_relaxed);
+            stats.MaxNanoseconds = counters.MaxNanoseconds.load(std::memory_order_relaxed);
+            for (size_t b = 0; b < HostActionStats::bucket_count; ++b)
+                stats.Buckets[b] = counters.Buckets[b].load(std::memory_order_relaxed);
+            profile.Actions.push_back(stats);
+        }
+        {
+            std::lock_guard<std::mutex> guard(variableLock);
+            for (auto& item : variables)
+            {
+                HostVariableStats stats;
+                stats.Name = item.first;
+                stats.Gets = item.second.Gets;
+                stats.Sets = item.second.Sets;
+                stats.Failures = item.second.Failures;
+                stats.TotalNanoseconds = item.second.TotalNanoseconds;
+                stats.MaxNanoseconds = item.second.MaxNanoseconds;
+                profile.Variables.push_back(stats);
+            }
+        }
+        std::sort(profile.Actions.begin(), profile.Actions.end(), [] (const HostActionStats& a, const HostActionStats& b) { return a.TotalNanoseconds > b.TotalNanoseconds; });
+        std::sort(profile.Variables.begin(), profile.Variables.end(), [] (const HostVariableStats& a, const HostVariableStats& b) { return a.TotalNanoseconds > b.TotalNanoseconds; });
+        return profile;
+    }
+
+    // Writes a text report of the current counters. Returns false if the file could not be written.
+    bool ExportToFile(const std::string& path) const
+    {
+        std::ofstream file(path.c_str());
+        file << Snapshot().ToString();
+        return file.good();
+    }
+
+    /// Summary:
+    ///     Writes a text report of the current counters into a host text variable,
+    ///     so it can be shown by a macro. The write itself is counted after the snapshot is taken.
+    bool ExportToVariable(const std::string& variableName) const
+    {
+        auto report = Snapshot().ToString();
+        SpotPluginApi::msg_get_set_variable_t message;
+        message.DataType = SpotPluginApi::msg_get_set_variable_t::Text;
+        message.VariableName = variableName.c_str();
+        message.TextValue = SpotPluginApi::make_text_variable(report);
+        return PluginHost::DoAction(SpotPluginApi::HostActionRequest::SetVariable, 0, &message);
+    }
+};
+
+inline const char* host_action_label(SpotPluginApi::host_action_t action)
+{
+    using namespace SpotPluginApi;
+    switch (action)
+    {
+    case HostActionRequest::BindEventHandler:       return "BindEventHandler";
+    case HostActionRequest::UnbindEventHandler:     return "UnbindEventHandler";
+    case HostActionRequest::GetVariable:            return "GetVariable";
+    case HostActionRequest::GetVariables:           return "GetVariables";
+    case HostActionRequest::ResolveVariable:        return "ResolveVariable";
+    case HostActionRequest::SetVariable:            return "SetVariable";
+    case HostActionRequest::SetVariables:           return "SetVariables";
+    case HostActionRequest::SaveVariable:           return "SaveVariable";
+    case HostActionRequest::RecallVariable:         return "RecallVariable";
+    case HostActionRequest::AcqSingleImage:         return "AcqSingleImage";
+    case HostActionRequest::StartLive:              return "StartLive";
+    case HostActionRequest::PauseLive:              return "PauseLive";
+    case HostActionRequest::EndLive:                return "EndLive";
+    case HostActionRequest::AcquireImageView:       return "AcquireImageView";
+    case HostActionRequest::ReleaseImageView:       return "ReleaseImageView";
+    case HostActionRequest::ShowSequenceFrame:      return "ShowSequenceFrame";
+    case HostActionProfiler::action_slot_count - 1: return "(other)";
+    default:                                        return "(unknown)";
+    }
+}
+
+inline std::string HostActionProfile::ToString() const
+{
+    std::ostringstream report;
+    report << std::fixed << std::setprecision(1);
+    report << "Host actions (times in microseconds)\n";
+    report << std::left << std::setw(20) << "Action" << std::right << std::setw(10) << "Calls" << std::setw(10) << "Failed"
+           << std::setw(12) << "Total" << std::setw(10) << "Mean" << std::setw(10) << "p50" << std::setw(10) << "p99" << std::setw(10) << "Max" << "\n";
+    for (auto& action : Actions)
+    {
+        report << std::left << std::setw(20) << host_action_label(action.Action) << std::right
+               << std::setw(10) << action.Calls << std::setw(10) << action.Failures
+               << std::setw(12) << action.TotalNanoseconds / 1000.0 << std::setw(10) << action.MeanMicroseconds()
+               << std::setw(10) << action.PercentileNanoseconds(0.5) / 1000.0 << std::setw(10) << action.PercentileNanoseconds(0.99) / 1000.0
+               << std::setw(10) << action.MaxNanoseconds / 1000.0 << "\n";
+    }
+    report << "\nVariables (times in microseconds)\n";
+    report << std::left << std::setw(40) << "Name" << std::right << std::setw(10) << "Gets" << std::setw(10) << "Sets" << std::setw(10) << "Failed"
+           << std::setw(12) << "Total" << std::setw(10) << "Max" << "\n";
+    for (auto& variable : Variables)
+    {
+        report << std::left << std::setw(40) << variable.Name << std::right
+               << std::setw(10) << variable.Gets << std::setw(10) << variable.Sets << std::setw(10) << variable.Failures
+               << std::setw(12) << variable.TotalNanoseconds / 1000.0 << std::setw(10) << variable.MaxNanoseconds / 1000.0 << "\n";
+    }
+    return report.str();
+}
@@ -4,68 +4,65 @@
 #include <memory>
 #include "SpotPlugin.h"
 #include "PluginHost.h"
-#include "EventSourceTypes.h"
 #include "EventArgConverters.h"
+#include "LiveFrame.h"
+#include "EventHub.h"
 
 namespace HostInterop
 {
+    /// Summary:
+    ///     The host events of the plug-in. Each is a channel of EventHub::Instance(), so all of them are
+    ///     dispatched by one event handler and a host event is only bound while its channel has delegates.
     class HostEvents
     {
     public:
-        typedef null_event_t                idle_event_t;
-        typedef read_string_event_t         camera_initialize_t;
-        typedef raw_event_t                 application_closing_t;
-        typedef raw_event_t                 image_doc_changed_t;
+        typedef EventChannel<EventArgNoOp>                  idle_event_t;
+        typedef EventChannel<EventArgCastTo<const char*>>   camera_initialize_t;
+        typedef EventChannel<EventArgNoOp>                  application_closing_t;
+        typedef EventChannel<EventArgNoOp>                  image_doc_changed_t;
+        typedef EventChannel<EventArgToLiveFrame>           live_frame_ready_t;
 
-        static HostEvents& Instance()
+        static EventHub& Hub()
         {
-            static HostEvents instance;
-            return instance;
+            return EventHub::Instance();
         }
 
         static idle_event_t& Idle()
         {
-            if (nullptr == Instance().idleEventSource)
-                Instance().idleEventSource = new idle_event_t(SpotPluginApi::HostEvent::Idle);
-            return *(Instance().idleEventSource);
+            return Hub().Channel<idle_event_t>(SpotPluginApi::HostEvent::Idle);
         }
 
+        /// Summary:
+        ///     Raised when the host has initialized a camera. The delegates get the camera name as the host
+        ///     string, which is only valid until the delegates return when the event is dispatched inline.
+        ///     Wrap it in a TextView to read it without a copy.
         static camera_initialize_t& CameraInit()
         {
-            if (nullptr == Instance().cameraInitEventSource)
-                Instance().cameraInitEventSource = new camera_initialize_t(SpotPluginApi::HostEvent::CameraInitialized);
-            return *(Instance().cameraInitEventSource);
+            return Hub().Channel<camera_initialize_t>(SpotPluginApi::HostEvent::CameraInitialized);
         }
 
         static application_closing_t& ApplicationClosing()
         {
-            if (nullptr == Instance().applicationClosingEventSource)
-                Instance().applicationClosingEventSource = new application_closing_t(SpotPluginApi::HostEvent::ApplicationClosing);
-            return *(Instance().applicationClosingEventSource);
+            return Hub().Channel<application_closing_t>(SpotPluginApi::HostEvent::ApplicationClosing);
         }
 
         static image_doc_changed_t& ImageDocChanged()
         {
-            if (nullptr == Instance().imageDocChangedEventSource)
-                Instance().imageDocChangedEventSource = new image_doc_changed_t(SpotPluginApi::HostEvent::ImageDocChanged);
-            return *(Instance().imageDocChangedEventSource);
-        }        
-
-    private:
+            return Hub().Channel<image_doc_changed_t>(SpotPluginApi::HostEvent::ImageDocChanged);
+        }
 
-        // Private constructor because this is a singleton object. Use Instance() function for access to the object.
-        HostEvents() :
-            idleEventSource(nullptr),
-            cameraInitEventSource(nullptr),
-            applicationClosingEventSource(nullptr),
-            imageDocChangedEventSource(nullptr)
+        /// Summary:
+        ///     Raised for every frame acquired in live mode. The delegates get the frame without a copy of its
+        ///     pixels, which are only valid until the delegates return when the event is dispatched inline.
+        ///     Listening() is false if the host does not send this event.
+        static live_frame_ready_t& LiveFrameReady()
         {
+            return Hub().Channel<live_frame_ready_t>(SpotPluginApi::HostEvent::LiveFrameReady);
         }
 
-        idle_event_t*               idleEventSource;
-        camera_initialize_t*        cameraInitEventSource;
-        application_closing_t*      applicationClosingEventSource;
-        image_doc_changed_t*        imageDocChangedEventSource;
+    private:
+        // Only static members
+        HostEvents();
     };
 
 }
\ No newline at end of file
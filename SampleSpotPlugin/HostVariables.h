@@ -5,9 +5,18 @@
 #include <map>
 #include <type_traits>
 #include <cassert>
+#include <memory>
+#include <vector>
+#include <functional>
+#include <iterator>
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
 #include "SpotPlugin.h"
 #include "PluginHost.h"
+#include "HostEvents.h"
 #include "Utilities.h"
+#include "MappedFile.h"
 
 
 namespace HostInterop
@@ -56,6 +65,128 @@ namespace internal // implementation specific namespace not for general usage
         getVarMsg.TextValue.UpdateLength();
         return std::string(getVarMsg.TextValue.c_str());
     }
+
+    // Returns the number of characters the host wrote to a text buffer that holds up to bufferLength characters.
+    // truncated is set if the host reported a value that is longer than the buffer (GetSetVariableVersion::TextLength)
+    // or filled the whole buffer, since a host without GetSetVariableVersion::TextLength cuts a value that does
+    // not fit at the end of the buffer without saying so.
+    static inline size_t _ReceivedTextLength(const SpotPluginApi::text_variable_t& text, size_t bufferLength, bool& truncated)
+    {
+        size_t length = std::find(text.Text, text.Text + bufferLength, '\0') - text.Text;
+        truncated = text.Length > bufferLength || length == bufferLength;
+        return length;
+    }
+
+    static inline const char* _DataTypeLabel(SpotPluginApi::msg_get_set_variable_t::VariableType dataType)
+    {
+        switch (dataType)
+        {
+        case SpotPluginApi::msg_get_set_variable_t::Text:
+            return "text";
+        case SpotPluginApi::msg_get_set_variable_t::Bool:
+            return "Boolean";
+        default:
+            return "numeric";
+        }
+    }
+
+    // Sends a GetVariable message that already identifies the variable and its data type
+    static inline void _GetVariable(SpotPluginApi::msg_get_set_variable_t& getVarMsg)
+    {
+        if (!PluginHost::DoAction( SpotPluginApi::HostActionRequest::GetVariable, 0, &getVarMsg))
+            throw std::runtime_error(std::string("Error getting ").append(_DataTypeLabel(getVarMsg.DataType)).append(" macro variable named ").append(getVarMsg.VariableName));
+    }
+
+    // Sends a SetVariable message that already identifies the variable and holds the new value
+    static inline void _SetVariable(SpotPluginApi::msg_get_set_variable_t& setVarMsg)
+    {
+        if (!PluginHost::DoAction( SpotPluginApi::HostActionRequest::SetVariable, 0, &setVarMsg))
+            throw std::runtime_error(std::string("Error setting ").append(_DataTypeLabel(setVarMsg.DataType)).append(" macro variable named ").append(setVarMsg.VariableName));
+    }
+
+    // Reads a text variable into the storage of value, growing it only if the value does not fit.
+    // getVarMsg must identify the variable. With version GetSetVariableVersion::TextLength or later the host
+    // reports the length of a value that does not fit, older hosts are asked again with twice the buffer.
+    static inline void _ReadTextVariable(SpotPluginApi::msg_get_set_variable_t& getVarMsg, std::string& value)
+    {
+        getVarMsg.DataType = SpotPluginApi::msg_get_set_variable_t::Text;
+
+        bool truncated = false;
+        value.resize(value.capacity()); // use all of the storage that is already allocated
+        do
+        {
+            getVarMsg.TextValue = SpotPluginApi::make_text_variable(&value[0], value.size());
+            _GetVariable(getVarMsg);
+            auto length = _ReceivedTextLength(getVarMsg.TextValue, value.size(), truncated);
+            if (!truncated)
+                value.resize(length); // up to the null terminator the host wrote
+            else if (getVarMsg.TextValue.Length > value.size())
+                value.resize(getVarMsg.TextValue.Length + 1); // room for the terminator, so the value fits without filling the buffer
+            else
+                value.resize(std::max<size_t>(64, 2 * value.size()));
+        } while (truncated); // the value may have grown again between the two calls
+    }
+
+    static inline void _ReadTextVariable(const char* name, std::string& value)
+    {
+        SpotPluginApi::msg_get_set_variable_t getVarMsg;
+        getVarMsg.Version = SpotPluginApi::GetSetVariableVersion::TextLength;
+        getVarMsg.VariableName = name;
+        _ReadTextVariable(getVarMsg, value);
+    }
+
+    // The message data type used to transfer a variable of the given type
+    static inline SpotPluginApi::msg_get_set_variable_t::VariableType _MessageDataType(VariableType type)
+    {
+        switch (type)
+        {
+        case VariableType::Bool:
+            return SpotPluginApi::msg_get_set_variable_t::Bool;
+        case VariableType::Text:
+            return SpotPluginApi::msg_get_set_variable_t::Text;
+        default:
+            return SpotPluginApi::msg_get_set_variable_t::Numeric;
+        }
+    }
+
+    // Sends all messages to the host with a single GetVariables/SetVariables action and
+    // fills status with a SpotPluginApi::VariableStatus value for each message.
+    // Hosts without bulk support are sent one GetVariable/SetVariable action per message instead.
+    static inline void _TransferVariables(bool setValues, std::vector<SpotPluginApi::msg_get_set_variable_t>& messages, std::vector<SpotPluginApi::variable_status_t>& status)
+    {
+        using namespace SpotPluginApi;
+        status.assign(messages.size(), VariableStatus::Failed);
+        if (messages.empty())
+            return;
+
+        // The list elements have the layout of every host version, so the handles go in a parallel array
+        std::vector<msg_get_set_variable_entry_t> entries;
+        std::vector<uintptr_t> handles;
+        entries.reserve(messages.size());
+        handles.reserve(messages.size());
+        for (auto& message : messages)
+        {
+            entries.push_back(message);
+            handles.push_back(message.Handle);
+        }
+
+        msg_get_set_variable_list_t listMsg;
+        listMsg.Version = GetSetVariableListVersion::HandleList;
+        listMsg.VariableListLength = entries.size();
+        listMsg.VariableList = entries.data();
+        listMsg.StatusList = status.data();
+        listMsg.HandleList = handles.data();
+        if (PluginHost::DoAction(setValues ? HostActionRequest::SetVariables : HostActionRequest::GetVariables, 0, &listMsg))
+        {
+            for (size_t i = 0; i < messages.size(); ++i)
+                static_cast<msg_get_set_variable_entry_t&>(messages[i]) = entries[i];
+            return;
+        }
+
+        auto singleAction = setValues ? HostActionRequest::SetVariable : HostActionRequest::GetVariable;
+        for (size_t i = 0; i < messages.size(); ++i)
+            status[i] = PluginHost::DoAction(singleAction, 0, &messages[i]) ? VariableStatus::Ok : VariableStatus::Failed;
+    }
 } // end namespace internal
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -100,11 +231,60 @@ namespace internal // implementation specific namespace not for general usage
     /// Arguments:
     ///     name - A null terminated string of the name of the target variable
     /// Returns:
-    ///     A std::string that is set to the current value of the global variable up to the first 1024 characters.
+    ///     A std::string that is set to the current value of the global variable.
     /// Throws:
     ///     runtime_error if unable to get the variable value
     static inline std::string GetTextVariable(const char* name)
-    { return internal::_GetTextVariable<1024>(name); }
+    {
+        std::string value;
+        internal::_ReadTextVariable(name, value);
+        return value;
+    }
+
+    /// Summary:
+    ///     Reads the current value of a global text variable with a matching name into an existing string.
+    ///     The storage of value is reused, so repeated reads into the same string do not allocate
+    ///     once it has grown to the length of the longest value read.
+    ///     Values of any length are read completely.
+    /// Arguments:
+    ///     name  - A null terminated string of the name of the target variable
+    ///     value - Receives the value of the variable
+    /// Returns:
+    ///     void
+    /// Throws:
+    ///     runtime_error if unable to get the variable value
+    static inline void GetTextVariable(const char* name, std::string& value)
+    { internal::_ReadTextVariable(name, value); }
+
+    /// Summary:
+    ///     Returns the length of the current value of a global text variable with a matching name without reading it.
+    /// Arguments:
+    ///     name - A null terminated string of the name of the target variable
+    /// Returns:
+    ///     The number of characters in the value
+    /// Throws:
+    ///     runtime_error if unable to get the variable value
+    static inline size_t GetTextVariableLength(const char* name)
+    {
+        // A one character buffer instead of a NULL Text, which a host without GetSetVariableVersion::TextLength
+        // would write to. Such a host fills the buffer and leaves the length unchanged.
+        char firstCharacter[2] = { 0 };
+        SpotPluginApi::msg_get_set_variable_t getVarMsg;
+        getVarMsg.Version = SpotPluginApi::GetSetVariableVersion::TextLength;
+        getVarMsg.DataType = SpotPluginApi::msg_get_set_variable_t::Text;
+        getVarMsg.VariableName = name;
+        getVarMsg.TextValue = SpotPluginApi::make_text_variable(firstCharacter, 1);
+        if (!PluginHost::DoAction( SpotPluginApi::HostActionRequest::GetVariable, 0, &getVarMsg))
+            throw std::runtime_error(std::string("Error getting text macro variable named ") + name);
+        if ('\0' == firstCharacter[0])
+            return 0;
+        if (getVarMsg.TextValue.Length > 1)
+            return getVarMsg.TextValue.Length;
+        // One character or a host that cannot report the length
+        std::string value;
+        internal::_ReadTextVariable(name, value);
+        return value.size();
+    }
 
     
     /// Summary:
@@ -199,21 +379,373 @@ namespace internal // implementation specific namespace not for general usage
         if (!PluginHost::DoAction( SpotPluginApi::HostActionRequest::RecallVariable, 0, &restoreMsg))
             throw std::runtime_error(std::string("Error reading variable (").append(name).append(") from file ").append(fileName));
     }
-    
+
+    /// Summary:
+    ///     Asks the host for a handle that identifies a variable in later get/set messages without a lookup by name.
+    /// Arguments:
+    ///     name       - A null terminated string of the name of the target variable
+    ///     dialogName - The name of the dialog that owns the variable or nullptr for a global variable
+    /// Returns:
+    ///     The handle of the variable or zero if the variable does not exist or the host does not support handles.
+    static inline uintptr_t ResolveVariable(const char* name, const char* dialogName = nullptr)
+    {
+        SpotPluginApi::msg_get_set_variable_t resolveMsg;
+        resolveMsg.Version = SpotPluginApi::GetSetVariableVersion::Handle;
+        resolveMsg.VariableName = name;
+        resolveMsg.DialogName = dialogName;
+        if (!PluginHost::DoAction( SpotPluginApi::HostActionRequest::ResolveVariable, 0, &resolveMsg))
+            return 0;
+        return resolveMsg.Handle;
+    }
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    /// Summary:
+    ///     Bookkeeping for the optional read-through cache of a VariableManager.
+    ///     Each scope bit has a generation number that is bumped when the scope is flushed.
+    ///     A cached value is stamped with the generations of its scopes when it is read from the host
+    ///     and is stale as soon as any of those scopes has been flushed since.
+    ///     Only variables whose scopes are all in CachedScopes() are cached, all others always go to the host,
+    ///     because a value can change with any of its scopes. Volatile variables (see IVariable::IsVolatile)
+    ///     are never cached.
+    class VariableCache
+    {
+    public:
+        static const size_t scope_bit_count = 8;
+
+        // The scopes that have a host event that tells us when their values change
+        static ScopeFlags DefaultCachedScopes()
+        { return ScopeFlags::ImageMetaData | ScopeFlags::CameraSetting | ScopeFlags::ApplicationState; }
+
+    private:
+        uint32_t generations[scope_bit_count];
+        ScopeFlags cachedScopes;
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t bypassed;
+        std::vector<std::function<void()>> unbindActions;
+
+        // no copies allowed. The invalidation delegates hold a pointer to this object
+        VariableCache(const VariableCache&);
+        VariableCache& operator = (const VariableCache&);
+
+        template<typename EvSource>
+        void InvalidateOn(EvSource& eventSource, ScopeFlags scope)
+        {
+            typedef typename EvSource::arg_type arg_type;
+            struct ScopeInvalidator : public EventDelegate<arg_type>
+            {
+                VariableCache* cache;
+                ScopeFlags scope;
+                ScopeInvalidator(VariableCache* cache, ScopeFlags scope) : cache(cache), scope(scope) {}
+                virtual void operator()(arg_type&) { cache->Invalidate(scope); }
+            };
+            auto invalidator = std::make_shared<ScopeInvalidator>(this, scope);
+            // Delegates that are already bound read the variables as well, so the scope must be flushed before they run
+            eventSource.AddDelegateFirst(invalidator);
+            unbindActions.push_back([&eventSource, invalidator]() { eventSource.RemoveDelegate(invalidator); });
+        }
+
+    public:
+        explicit VariableCache(ScopeFlags cachedScopes = DefaultCachedScopes()) :
+            cachedScopes(cachedScopes), hits(0), misses(0), bypassed(0)
+        {
+            std::fill(std::begin(generations), std::end(generations), 1u);
+        }
+
+        ~VariableCache()
+        {
+            UnbindFromHostEvents();
+        }
+
+        ScopeFlags CachedScopes() const { return cachedScopes; }
+
+        bool IsCacheable(ScopeFlags scope) const { return ScopeFlags::Unknown != scope && scope == (scope & cachedScopes); }
+
+        // Returns a value that changes whenever any of the scopes is invalidated. Never returns zero for a cacheable scope.
+        uint64_t Stamp(ScopeFlags scope) const
+        {
+            auto bits = static_cast<std::underlying_type<ScopeFlags>::type>(scope);
+            uint64_t stamp = 0;
+            for (size_t i = 0; i < scope_bit_count; ++i)
+            {
+                if (bits & (1u << i))
+                    stamp += generations[i];
+            }
+            return stamp;
+        }
+
+        // Marks every cached value that belongs to any of the scopes as stale
+        void Invalidate(ScopeFlags scope)
+        {
+            auto bits = static_cast<std::underlying_type<ScopeFlags>::type>(scope);
+            for (size_t i = 0; i < scope_bit_count; ++i)
+            {
+                if (bits & (1u << i))
+                    ++generations[i];
+            }
+        }
+
+        void InvalidateAll()
+        {
+            for (auto& generation : generations)
+                ++generation;
+        }
+
+        /// Summary:
+        ///     Subscribes to the host events that signal when a scope needs to be flushed.
+        ///         ImageMetaData    - HostEvent::ImageDocChanged
+        ///         CameraSetting    - HostEvent::CameraInitialized
+        ///         ApplicationState - HostEvent::Idle
+        void BindToHostEvents()
+        {
+            if (!unbindActions.empty())
+                return;
+            InvalidateOn(HostEvents::ImageDocChanged(), ScopeFlags::ImageMetaData);
+            InvalidateOn(HostEvents::CameraInit(), ScopeFlags::CameraSetting);
+            InvalidateOn(HostEvents::Idle(), ScopeFlags::ApplicationState);
+        }
+
+        void UnbindFromHostEvents()
+        {
+            for (auto& unbind : unbindActions)
+                unbind();
+            unbindActions.clear();
+        }
+
+        void RecordHit() { ++hits; }
+        void RecordMiss() { ++misses; }
+        void RecordBypass() { ++bypassed; }
+
+        uint64_t Hits() const { return hits; }         // reads served without a host call
+        uint64_t Misses() const { return misses; }     // reads of cacheable variables that went to the host
+        uint64_t Bypassed() const { return bypassed; } // reads of variables outside the cached scopes
+        void ResetCounters() { hits = misses = bypassed = 0; }
+    };
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    class IVariable;
+
+    /// Summary:
+    ///     The value of a variable transferred in bulk by VariableManager::Fetch, Snapshot and Store.
+    ///     Only the member that matches the type of the target variable is meaningful.
+    ///     Integer variables use NumericValue.
+    struct VariableValue
+    {
+        VariableValue() :
+            Target(nullptr), Status(SpotPluginApi::VariableStatus::Failed), NumericValue(0.0), BoolValue(false)
+        { }
+
+        IVariable* Target;
+        SpotPluginApi::variable_status_t Status;   // SpotPluginApi::VariableStatus of the last transfer
+        double NumericValue;
+        bool BoolValue;
+        std::string TextValue;
+
+        bool IsValid() const { return SpotPluginApi::VariableStatus::Ok == Status; }
+    };
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    struct WriteBehindStats
+    {
+        WriteBehindStats() : Deferred(0), Elided(0), Flushes(0), Written(0), Failed(0)
+        { }
+
+        uint64_t Deferred;              // Writes made through managed variables while writing behind
+        uint64_t Elided;                // Writes replaced by a later write to the same variable before the flush
+        uint64_t Flushes;               // Host actions that sent pending writes
+        uint64_t Written;               // Values the host accepted
+        uint64_t Failed;                // Values the host rejected
+        std::string LastFailure;        // The name of the last variable the host rejected
+    };
+
+    /// Summary:
+    ///     The pending writes of a VariableManager in write-behind mode (see VariableManager::EnableWriteBehind).
+    ///     Each variable has at most one pending value. A later write replaces it, so a variable set many times
+    ///     before the flush costs a single transfer. The values are sent in the order of the first write to each variable.
+    class WriteBehindBuffer
+    {
+        std::vector<VariableValue> pending;
+        WriteBehindStats stats;
+
+        friend class IVariable;
+        friend class VariableManager;
+
+        // no copies allowed. Managed variables point to this object
+        WriteBehindBuffer(const WriteBehindBuffer&);
+        WriteBehindBuffer& operator = (const WriteBehindBuffer&);
+
+        // Returns the pending value of the variable, adding one on its first write since the last flush.
+        // position is remembered by the variable to find its value again without a search.
+        VariableValue& Defer(IVariable* target, size_t& position)
+        {
+            ++stats.Deferred;
+            if (position < pending.size() && pending[position].Target == target)
+            {
+                ++stats.Elided;
+                return pending[position];
+            }
+            position = pending.size();
+            pending.push_back(VariableValue());
+            pending.back().Target = target;
+            return pending.back();
+        }
+
+        const VariableValue* Find(const IVariable* target, size_t position) const
+        {
+            return (position < pending.size() && pending[position].Target == target) ? &pending[position] : nullptr;
+        }
+
+        // Removes the pending values so they can be sent to the host
+        std::vector<VariableValue> Take()
+        {
+            std::vector<VariableValue> values;
+            values.swap(pending);
+            return values;
+        }
+
+    public:
+        WriteBehindBuffer()
+        {
+        }
+
+        size_t Pending() const { return pending.size(); }
+        const WriteBehindStats& Stats() const { return stats; }
+        void ResetCounters() { stats = WriteBehindStats(); }
+    };
+
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     /// Summary:
     ///
     class IVariable
     {
+        friend class VariableManager;
     protected:
         std::string name;
         std::shared_ptr<std::string> objectId; // The name of the object that owns the variable
         VariableType type;
         ScopeFlags scope;
         bool readOnly;
+        bool isVolatile;                // The value changes without a host event, so it is never cached
+        VariableCache* cache;           // Set by the owning VariableManager when caching is enabled
+        mutable uint64_t cacheStamp;    // VariableCache::Stamp() of the cached value or zero if there is none
+        WriteBehindBuffer* writeBehind; // Set by the owning VariableManager while it writes behind
+        mutable size_t pendingPosition; // Where the pending value of this variable was last put in writeBehind
+        mutable uintptr_t handle;       // The host handle of the variable or zero if the host does not have one
+        mutable bool isResolved;        // true once the host was asked for the handle
 
         IVariable(std::string name, std::shared_ptr<std::string> objectId, VariableType type, ScopeFlags scope, bool readOnly) :
-            name(name), objectId(objectId), type(type), scope(scope), readOnly(readOnly) {}
+            name(std::move(name)), objectId(std::move(objectId)), type(type), scope(scope), readOnly(readOnly), isVolatile(false), cache(nullptr), cacheStamp(0),
+            writeBehind(nullptr), pendingPosition(0), handle(0), isResolved(false) {}
+
+        // Returns a get/set message that identifies this variable to the host.
+        // The variable is resolved to a handle on first use so the host can skip the lookup by name.
+        // The name is always sent as well, so hosts without handle support still find the variable.
+        SpotPluginApi::msg_get_set_variable_t NewMessage(SpotPluginApi::msg_get_set_variable_t::VariableType dataType) const
+        {
+            if (!isResolved)
+            {
+                handle = ResolveVariable(name.c_str(), IsGlobal() ? nullptr : objectId->c_str());
+                isResolved = true;
+            }
+            SpotPluginApi::msg_get_set_variable_t message;
+            message.Version = SpotPluginApi::GetSetVariableVersion::Handle;
+            message.DataType = dataType;
+            message.VariableName = name.c_str();
+            message.DialogName = IsGlobal() ? nullptr : objectId->c_str();
+            message.Handle = handle;
+            return message;
+        }
+
+        // Returns the value waiting to be written or nullptr if there is none. Reads return it instead of the host value.
+        const VariableValue* PendingValue() const
+        {
+            return (nullptr != writeBehind) ? writeBehind->Find(this, pendingPosition) : nullptr;
+        }
+
+        bool GetHostBool() const
+        {
+            auto pending = PendingValue();
+            if (nullptr != pending)
+                return pending->BoolValue;
+            auto message = NewMessage(SpotPluginApi::msg_get_set_variable_t::Bool);
+            internal::_GetVariable(message);
+            return message.BoolValue != 0;
+        }
+
+        double GetHostNumeric() const
+        {
+            auto pending = PendingValue();
+            if (nullptr != pending)
+                return pending->NumericValue;
+            auto message = NewMessage(SpotPluginApi::msg_get_set_variable_t::Numeric);
+            internal::_GetVariable(message);
+            return message.NumericValue;
+        }
+
+        void GetHostText(std::string& value) const
+        {
+            auto pending = PendingValue();
+            if (nullptr != pending)
+            {
+                value.assign(pending->TextValue);
+                return;
+            }
+            auto message = NewMessage(SpotPluginApi::msg_get_set_variable_t::Text);
+            internal::_ReadTextVariable(message, value);
+        }
+
+        // The SetHost methods only queue the value while the owning VariableManager writes behind
+
+        void SetHostBool(bool value) const
+        {
+            if (nullptr != writeBehind)
+            {
+                writeBehind->Defer(const_cast<IVariable*>(this), pendingPosition).BoolValue = value;
+                return;
+            }
+            auto message = NewMessage(SpotPluginApi::msg_get_set_variable_t::Bool);
+            message.BoolValue = value;
+            internal::_SetVariable(message);
+        }
+
+        void SetHostNumeric(double value) const
+        {
+            if (nullptr != writeBehind)
+            {
+                writeBehind->Defer(const_cast<IVariable*>(this), pendingPosition).NumericValue = value;
+                return;
+            }
+            auto message = NewMessage(SpotPluginApi::msg_get_set_variable_t::Numeric);
+            message.NumericValue = value;
+            internal::_SetVariable(message);
+        }
+
+        void SetHostText(const std::string& value) const
+        {
+            if (nullptr != writeBehind)
+            {
+                writeBehind->Defer(const_cast<IVariable*>(this), pendingPosition).TextValue.assign(value);
+                return;
+            }
+            auto message = NewMessage(SpotPluginApi::msg_get_set_variable_t::Text);
+            message.TextValue = SpotPluginApi::make_text_variable(value);
+            internal::_SetVariable(message);
+        }
+
+        // Discards the cached value so the next read goes to the host
+        void InvalidateCachedValue() const { cacheStamp = 0; }
+
+        void AttachCache(VariableCache* newCache)
+        {
+            cache = newCache;
+            cacheStamp = 0;
+        }
+
+        void AttachWriteBehind(WriteBehindBuffer* buffer)
+        {
+            writeBehind = buffer;
+            pendingPosition = 0;
+        }
     public:
         virtual ~IVariable() {};
         const std::string& Name() const { return name; }
@@ -222,15 +754,80 @@ namespace internal // implementation specific namespace not for general usage
         ScopeFlags Scope() const { return scope; }
         bool IsReadOnly() const { return readOnly; }
         bool IsGlobal() const { return nullptr == objectId; }
+
+        // A volatile variable, e.g. a sensor reading, changes without an event that invalidates its scope,
+        // so its value is always read from the host even when its scopes are cached.
+        bool IsVolatile() const { return isVolatile; }
+
+        void SetVolatile(bool changesWithoutEvent)
+        {
+            isVolatile = changesWithoutEvent;
+            cacheStamp = 0;
+        }
+        uintptr_t Handle() const { return handle; }
+
+        // Forgets the host handle so the variable is resolved again on next use
+        void ResetHandle()
+        {
+            handle = 0;
+            isResolved = false;
+        }
         virtual std::string ToString() { return std::string(name).append(", type:").append(std::to_string((int)type)).append(", {undefined value}"); }
     };
     
     template<typename T>
     class Variable : public IVariable
     {
+    private:
+        mutable T cachedValue;
+
+    protected:
+        // Returns the cached value, refreshing it first with readIntoFunc(T&) if it is stale.
+        // Returns nullptr if the value of this variable is not cached, in which case the caller reads it from the host.
+        template<typename ReadIntoFunc>
+        const T* CachedRead(ReadIntoFunc readIntoFunc) const
+        {
+            if (nullptr == cache)
+                return nullptr;
+            if (isVolatile || !cache->IsCacheable(scope))
+            {
+                cache->RecordBypass();
+                return nullptr;
+            }
+            auto currentStamp = cache->Stamp(scope);
+            if (cacheStamp == currentStamp)
+            {
+                cache->RecordHit();
+                return &cachedValue;
+            }
+            cache->RecordMiss();
+            readIntoFunc(cachedValue);
+            cacheStamp = currentStamp;
+            return &cachedValue;
+        }
+
+        // Returns the cached value when it is still current, otherwise reads it from the host with readFunc.
+        template<typename ReadFunc>
+        T ReadThrough(ReadFunc readFunc) const
+        {
+            auto cached = CachedRead([&readFunc](T& target) { target = readFunc(); });
+            return (nullptr != cached) ? *cached : readFunc();
+        }
+
+        // Replaces the cached value with one that was read from the host by other means (e.g. a bulk read)
+        void StoreCachedValue(const T& value) const
+        {
+            if (nullptr == cache || isVolatile || !cache->IsCacheable(scope))
+                return;
+            cachedValue = value;
+            cacheStamp = cache->Stamp(scope);
+        }
+
+        friend class VariableManager;
+
     public:
         Variable(std::string name, std::shared_ptr<std::string> objectId, VariableType type, ScopeFlags scope, bool readOnly) :
-            IVariable(name, objectId, type, scope, readOnly)
+            IVariable(std::move(name), std::move(objectId), type, scope, readOnly), cachedValue()
         {}
         virtual ~Variable() {}
         virtual T Value() const = 0;
@@ -244,16 +841,17 @@ namespace internal // implementation specific namespace not for general usage
     {
     public:
         BoolVariable(const char* name, ScopeFlags scope = ScopeFlags::Unknown, bool isReadOnly=false) :
-            Variable<bool>(name, nullptr, VariableType::Text, scope, isReadOnly)
+            Variable<bool>(name, nullptr, VariableType::Bool, scope, isReadOnly)
         {   }
 
-        virtual bool Value() const { return GetBoolVariable(name.c_str()); }
+        virtual bool Value() const { return ReadThrough([this]() { return GetHostBool(); }); }
 
         virtual Variable<bool>& Value(const bool& newValue)
         {
             if (IsReadOnly())
                 throw std::runtime_error(std::string("Illegal operation. The variable (").append(name).append(") is a read only variable"));
-            SetBoolVariable(name.c_str(), newValue);
+            SetHostBool(newValue);
+            InvalidateCachedValue();
             return *this;
         }
 
@@ -271,13 +869,30 @@ namespace internal // implementation specific namespace not for general usage
             Variable<std::string>(name, nullptr, VariableType::Text, scope, isReadOnly)
         {  }
 
-        virtual std::string Value() const { return GetTextVariable(name.c_str()); }
+        virtual std::string Value() const
+        {
+            std::string value;
+            Read(value);
+            return value;
+        }
+
+        // Reads the value into buffer reusing its storage. See GetTextVariable(const char*, std::string&).
+        const std::string& Read(std::string& buffer) const
+        {
+            auto cached = CachedRead([this](std::string& target) { GetHostText(target); });
+            if (nullptr != cached)
+                buffer.assign(*cached);
+            else
+                GetHostText(buffer);
+            return buffer;
+        }
 
         virtual Variable<std::string>& Value(const std::string& newValue)
         {
             if (IsReadOnly())
                 throw std::runtime_error(std::string("Illegal operation. The variable (").append(name).append(") is a read only variable"));
-            SetTextVariable(name.c_str(), newValue);
+            SetHostText(newValue);
+            InvalidateCachedValue();
             return *this;
         }
 
@@ -295,13 +910,14 @@ namespace internal // implementation specific namespace not for general usage
             Variable(name, nullptr, VariableType::Numeric, scope, isReadOnly)
         { }
 
-        virtual double Value() const { return GetNumericVariable(name.c_str());}
+        virtual double Value() const { return ReadThrough([this]() { return GetHostNumeric(); }); }
 
         virtual Variable<double>& Value(int newValue)
         {
             if (IsReadOnly())
                 throw std::runtime_error(std::string("Illegal operation. The variable (").append(name).append(") is a read only variable"));
-            SetNumericVariable(name.c_str(), newValue);
+            SetHostNumeric(newValue);
+            InvalidateCachedValue();
             return *this;
         }
 
@@ -309,7 +925,8 @@ namespace internal // implementation specific namespace not for general usage
         {
             if (IsReadOnly())
                 throw std::runtime_error(std::string("Illegal operation. The variable (").append(name).append(") is a read only variable"));
-            SetNumericVariable(name.c_str(), newValue);
+            SetHostNumeric(newValue);
+            InvalidateCachedValue();
             return *this;
         }
 
@@ -317,7 +934,8 @@ namespace internal // implementation specific namespace not for general usage
         {
             if (IsReadOnly())
                 throw std::runtime_error(std::string("Illegal operation. The variable (").append(name).append(") is a read only variable"));
-            SetNumericVariable(name.c_str(), std::stod(textToParse));
+            SetHostNumeric(std::stod(textToParse));
+            InvalidateCachedValue();
             return *this;
         }
 
@@ -338,14 +956,15 @@ namespace internal // implementation specific namespace not for general usage
             Variable(name, nullptr, VariableType::Integer, scope, isReadOnly)
         { }
 
-        virtual int Value() const { return static_cast<int>(GetNumericVariable(name.c_str()));}
+        virtual int Value() const { return ReadThrough([this]() { return static_cast<int>(GetHostNumeric()); }); }
 
         virtual Variable<int>& Value(const int& newValue)
         {
             if (IsReadOnly())
                 throw std::runtime_error(std::string("Illegal operation. The variable (").append(name).append(") is a read only variable"));
             double realVal = newValue;
-            SetNumericVariable(name.c_str(), realVal);
+            SetHostNumeric(realVal);
+            InvalidateCachedValue();
             return *this;
         }
 
@@ -354,7 +973,8 @@ namespace internal // implementation specific namespace not for general usage
             if (IsReadOnly())
                 throw std::runtime_error(std::string("Illegal operation. The variable (").append(name).append(") is a read only variable"));
             newValue = round_to_nearest_awayzero(newValue);
-            SetNumericVariable(name.c_str(), newValue);
+            SetHostNumeric(newValue);
+            InvalidateCachedValue();
             return *this;
         }
 
@@ -362,7 +982,8 @@ namespace internal // implementation specific namespace not for general usage
         {
             if (IsReadOnly())
                 throw std::runtime_error(std::string("Illegal operation. The variable (").append(name).append(") is a read only variable"));
-            SetNumericVariable(name.c_str(), static_cast<double>(std::stoi(textToParse, nullptr, base)));
+            SetHostNumeric(static_cast<double>(std::stoi(textToParse, nullptr, base)));
+            InvalidateCachedValue();
             return *this;
         }
 
@@ -374,157 +995,488 @@ namespace internal // implementation specific namespace not for general usage
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 #include "StandardHostVariables.h"
+#include "VariableIndex.h"
+#include "VariableSnapshot.h"
 
     class VariableManager
     {
-        typedef std::unordered_map<std::string, std::shared_ptr<IVariable>> ivar_collection_t;
-        ivar_collection_t variableCollection;
+        // Variables live in a dense array of slots in the index, which refers to them by position.
+        // owned holds the variables added with Manage(IVariable*), indexed by slot, and is empty when there are none.
+        VariableIndex index;
+        std::vector<std::unique_ptr<IVariable>> owned;
+        std::unordered_map<std::string, size_t> slotByName;
+        const StandardVariables* standard;   // The standard variables are found by name in its table and not in slotByName
+        std::unique_ptr<VariableCache> cache;
+        std::unique_ptr<WriteBehindBuffer> writeBehind;
+        std::shared_ptr<EventDelegate<HostEvents::idle_event_t::arg_type>> flushOnIdle;
+
+        // no copies allowed. Managed variables point back to the cache and write buffer owned by this object
+        VariableManager(const VariableManager&);
+        VariableManager& operator = (const VariableManager&);
+
+        static const size_t no_slot = static_cast<size_t>(-1);
 
     public:
-        VariableManager()
+        VariableManager() :
+            standard(nullptr)
+        {
+        }
+
+        /// Summary:
+        ///     Creates a manager of all the standard variables, see StandardVars().
+        ///     The slot of a standard variable is its StdVarId and names are found with StandardVariables::Find,
+        ///     so no memory is allocated per variable.
+        explicit VariableManager(const StandardVariables& standardVariables) :
+            standard(&standardVariables)
         {
+            index.Reserve(standardVariables.size());
+            for (auto variable : standardVariables)
+                ManageSlot(variable, false);
         }
 
+        // Pending writes are dropped, the host may already be gone. Call DisableWriteBehind to keep them.
         ~VariableManager()
         {
+            DetachWriteBehind();
+            DisableCaching();
         }
 
-        size_t Size() const
+        /// Summary:
+        ///     Turns on the read-through cache for all current and future variables of this manager.
+        ///     Values of variables in cachedScopes are read from the host once and then served from memory
+        ///     until the host event for one of their scopes flushes them (see VariableCache::BindToHostEvents).
+        ///     Writes through a managed variable always go to the host and discard that variable's cached value.
+        /// Arguments:
+        ///     cachedScopes - The scopes to cache. Only scopes with an invalidation event are safe to cache.
+        /// Returns:
+        ///     The cache object to query the hit/miss counters or flush scopes by hand.
+        VariableCache& EnableCaching(ScopeFlags cachedScopes = VariableCache::DefaultCachedScopes())
         {
-            return variableCollection.size();
+            DisableCaching();
+            cache.reset(new VariableCache(cachedScopes));
+            cache->BindToHostEvents();
+            for (size_t slot = 0; slot < index.SlotCount(); ++slot)
+                index.At(slot)->AttachCache(cache.get());
+            return *cache;
         }
 
-        void SaveAll(const std::string& fileName)
+        void DisableCaching()
         {
-            for(auto& item : variableCollection)
-                SaveVariable(item.first.c_str(), fileName.c_str());
+            if (!cache)
+                return;
+            for (size_t slot = 0; slot < index.SlotCount(); ++slot)
+                index.At(slot)->AttachCache(nullptr);
+            cache.reset();
         }
 
-        void RestoreAll(const std::string& fileName)
+        bool IsCaching() const { return nullptr != cache; }
+
+        // Returns the active cache or nullptr if caching is disabled
+        VariableCache* Cache() const { return cache.get(); }
+
+        /// Summary:
+        ///     Turns on write-behind for all current and future variables of this manager.
+        ///     Writes through a managed variable are kept in memory instead of going to the host, and a
+        ///     variable written again before the flush only keeps its last value. Reads of a variable with
+        ///     a pending write return that value. The pending values are sent with a single host action by
+        ///     Flush, which is also called on every HostEvents::Idle() event.
+        ///     Errors of deferred writes are not thrown by the setters but reported by Flush.
+        ///     Writes by name with SetTextVariable and the like are not deferred.
+        /// Returns:
+        ///     The write buffer to query the counters
+        WriteBehindBuffer& EnableWriteBehind()
         {
-            for(auto item : AllMutable())
-            {
-                RestoreVariableFromFile(item->Name().c_str(), fileName.c_str());           
-            }
+            if (writeBehind)
+                return *writeBehind;
+            writeBehind.reset(new WriteBehindBuffer());
+            for (size_t slot = 0; slot < index.SlotCount(); ++slot)
+                index.At(slot)->AttachWriteBehind(writeBehind.get());
+            std::function<void(HostEvents::idle_event_t::arg_type)> onIdle = [this] (HostEvents::idle_event_t::arg_type) { Flush(); };
+            flushOnIdle = make_event_delegate(onIdle);
+            HostEvents::Idle().AddDelegate(flushOnIdle);
+            return *writeBehind;
+        }
+
+        /// Summary:
+        ///     Sends the pending writes and goes back to writing through to the host.
+        /// Returns:
+        ///     The values the host rejected, see Flush
+        std::vector<VariableValue> DisableWriteBehind()
+        {
+            auto failed = Flush();
+            DetachWriteBehind();
+            return failed;
         }
 
-        std::vector<IVariable*> MatchingAll(ScopeFlags withScope) const
+        bool IsWritingBehind() const { return nullptr != writeBehind; }
+
+        // Returns the write buffer or nullptr if write-behind is disabled
+        WriteBehindBuffer* WriteBehind() const { return writeBehind.get(); }
+
+        /// Summary:
+        ///     Sends the pending writes to the host with a single host action.
+        ///     Does nothing when write-behind is disabled or nothing is pending.
+        /// Returns:
+        ///     The values the host rejected with the reason in their Status. Their targets keep the host value.
+        std::vector<VariableValue> Flush()
         {
-            std::vector<IVariable*> matching;
-            for( auto& item : variableCollection)
+            std::vector<VariableValue> failed;
+            if (!writeBehind || 0 == writeBehind->Pending())
+                return failed;
+            auto values = writeBehind->Take(); // Store flushes first as well and finds nothing left
+            auto& stats = writeBehind->stats;
+            ++stats.Flushes;
+            if (Store(values))
             {
-                if (item.second && item.second->Scope() == withScope)
-                    matching.push_back(item.second.get());
+                stats.Written += values.size();
+                return failed;
             }
-            return matching;
+            for (auto& value : values)
+            {
+                if (value.IsValid())
+                {
+                    ++stats.Written;
+                    continue;
+                }
+                ++stats.Failed;
+                stats.LastFailure = value.Target->Name();
+                failed.push_back(std::move(value));
+            }
+            return failed;
         }
 
-        template<typename T>
-        std::vector<T*> MatchingAll(ScopeFlags withScope) const
+        size_t Size() const
         {
-            std::vector<T*> matching;
-            for( auto& item : variableCollection)
+            return index.SlotCount();
+        }
+
+        /// Summary:
+        ///     Writes the values of all managed variables to a snapshot file (see SnapshotWriter).
+        ///     The values are read with a single host action and the file is written at once.
+        ///     Variables the host can not read are left out.
+        /// Throws:
+        ///     runtime_error if the file can not be written
+        void SaveAll(const std::string& fileName)
+        {
+            std::vector<IVariable*> variables;
+            variables.reserve(index.SlotCount());
+            for (size_t slot = 0; slot < index.SlotCount(); ++slot)
+                variables.push_back(index.At(slot));
+            auto values = Fetch(variables);
+
+            SnapshotWriter snapshot;
+            snapshot.Reserve(values.size());
+            for (auto& value : values)
             {
-                if (item.second && item.second->Scope() == withScope && dynamic_cast<T*>(item.second.get()))
-                    matching.push_back(static_cast<T*>(item.second.get()));
+                if (value.IsValid())
+                    snapshot.Add(value);
             }
-            return matching;
+            snapshot.Save(fileName);
         }
 
-        std::vector<IVariable*> MatchingAny(ScopeFlags withScope) const
+        /// Summary:
+        ///     Sets the mutable managed variables to the values in a file written by SaveAll with a single host action.
+        ///     Variables that are not in the file, or were saved with a different type, keep their value.
+        ///     Files saved by the host one variable at a time are read back through the host.
+        /// Throws:
+        ///     runtime_error if the file is damaged or a variable can not be set
+        void RestoreAll(const std::string& fileName)
         {
-            std::vector<IVariable*> matching;
-            for( auto& item : variableCollection)
+            SnapshotReader snapshot;
+            if (!snapshot.Open(fileName))
             {
-                if (item.second && bool(item.second->Scope() & withScope))
-                    matching.push_back(item.second.get());
+                for (auto item : AllMutable())
+                    RestoreVariableFromFile(item->Name().c_str(), fileName.c_str());
+                return;
+            }
+
+            std::vector<VariableValue> values;
+            values.reserve(snapshot.Size());
+            for (size_t i = 0; i < snapshot.Size(); ++i)
+            {
+                auto slot = FindSlot(snapshot.Name(i));
+                if (no_slot == slot)
+                    continue;
+                auto variable = index.At(slot);
+                if (variable->IsReadOnly() || variable->Type() != snapshot.Type(i))
+                    continue;
+                VariableValue value;
+                value.Target = variable;
+                snapshot.ReadValue(i, value);
+                values.push_back(std::move(value));
+            }
+            snapshot.Close();
+
+            if (Store(values))
+                return;
+            for (auto& value : values)
+            {
+                if (!value.IsValid())
+                    throw std::runtime_error(std::string("Error reading variable (").append(value.Target->Name()).append(") from file ").append(fileName));
             }
-            return matching;
         }
 
-        template<typename T>
-        std::vector<T*> MatchingAny(ScopeFlags withScope) const 
+        /// Summary:
+        ///     Reads the current values of many variables with a single host action.
+        ///     When caching is enabled the cached values of the variables are replaced with the values read.
+        /// Arguments:
+        ///     variables - The variables to read. They do not need to be managed by this object.
+        /// Returns:
+        ///     One VariableValue per variable in the same order.
+        ///     Entries the host could not read have a Status other than VariableStatus::Ok.
+        std::vector<VariableValue> Fetch(const std::vector<IVariable*>& variables) const
         {
-            std::vector<T*> matching;
-            for( auto& item : variableCollection)
+            using SpotPluginApi::msg_get_set_variable_t;
+            const size_t textReadLength = 1024;
+
+            std::vector<VariableValue> values(variables.size());
+            std::vector<msg_get_set_variable_t> messages(variables.size());
+            auto textCount = std::count_if(variables.begin(), variables.end(), [](const IVariable* item) { return item->Type() == VariableType::Text; });
+            std::vector<char> textBuffer(textCount * (textReadLength + 1));
+            char* nextText = textBuffer.data();
+
+            for (size_t i = 0; i < variables.size(); ++i)
             {
-                if (item.second && bool(item.second->Scope() & withScope) && dynamic_cast<T*>(item.second.get()))
-                    matching.push_back(static_cast<T*>(item.second.get()));
+                values[i].Target = variables[i];
+                messages[i] = variables[i]->NewMessage(internal::_MessageDataType(variables[i]->Type()));
+                if (msg_get_set_variable_t::Text == messages[i].DataType)
+                {
+                    messages[i].TextValue = SpotPluginApi::make_text_variable(nextText, textReadLength);
+                    nextText += textReadLength + 1;
+                }
             }
-            return matching;
+
+            std::vector<SpotPluginApi::variable_status_t> status;
+            internal::_TransferVariables(false, messages, status);
+
+            for (size_t i = 0; i < values.size(); ++i)
+            {
+                auto& value = values[i];
+                auto& message = messages[i];
+                value.Status = status[i];
+                bool truncated = false;
+                if (msg_get_set_variable_t::Text == message.DataType && value.IsValid())
+                    value.TextValue.assign(message.TextValue.Text, internal::_ReceivedTextLength(message.TextValue, textReadLength, truncated));
+                if (truncated || SpotPluginApi::VariableStatus::Truncated == value.Status)
+                {
+                    // Read long values on their own into a buffer of the right size
+                    try
+                    {
+                        value.Target->GetHostText(value.TextValue);
+                        value.Status = SpotPluginApi::VariableStatus::Ok;
+                    }
+                    catch (std::runtime_error&)
+                    {
+                        value.Status = SpotPluginApi::VariableStatus::Failed;
+                    }
+                }
+                if (!value.IsValid())
+                    continue;
+
+                switch (value.Target->Type())
+                {
+                case VariableType::Bool:
+                    value.BoolValue = message.BoolValue != 0;
+                    PrimeCachedValue(value.Target, value.BoolValue);
+                    break;
+                case VariableType::Integer:
+                    value.NumericValue = message.NumericValue;
+                    PrimeCachedValue(value.Target, static_cast<int>(value.NumericValue));
+                    break;
+                case VariableType::Numeric:
+                    value.NumericValue = message.NumericValue;
+                    PrimeCachedValue(value.Target, value.NumericValue);
+                    break;
+                case VariableType::Text:
+                    PrimeCachedValue(value.Target, value.TextValue);
+                    break;
+                }
+            }
+
+            // Values waiting to be written replace the host values, like reads of single variables
+            if (writeBehind)
+            {
+                for (auto& value : values)
+                {
+                    auto pending = value.Target->PendingValue();
+                    if (nullptr == pending)
+                        continue;
+                    value.NumericValue = pending->NumericValue;
+                    value.BoolValue = pending->BoolValue;
+                    value.TextValue = pending->TextValue;
+                    value.Status = SpotPluginApi::VariableStatus::Ok;
+                    value.Target->InvalidateCachedValue(); // the cache was primed with the host value above
+                }
+            }
+            return values;
+        }
+
+        /// Summary:
+        ///     Reads the values of all managed variables that have any of the scope flags with a single host action.
+        ///     See Fetch.
+        std::vector<VariableValue> Snapshot(ScopeFlags withScope) const
+        {
+            return Fetch(MatchingAny(withScope).ToVector());
         }
 
-        std::vector<IVariable*> AllMutable() const
+        /// Summary:
+        ///     Writes many variable values with a single host action.
+        ///     Read only variables are not sent to the host and get a status of VariableStatus::ReadOnly.
+        ///     Store is never deferred. Pending writes are flushed first so they can not overwrite the values stored.
+        /// Arguments:
+        ///     values - The values to write. The Status of each entry is updated with the outcome of the write.
+        /// Returns:
+        ///     true if every value was written
+        bool Store(std::vector<VariableValue>& values)
         {
-            std::vector<IVariable*> matching;
-            for( auto& item : variableCollection)
+            using SpotPluginApi::msg_get_set_variable_t;
+            Flush();
+
+            std::vector<msg_get_set_variable_t> messages;
+            std::vector<size_t> valueIndex;
+            messages.reserve(values.size());
+            valueIndex.reserve(values.size());
+
+            for (size_t i = 0; i < values.size(); ++i)
             {
-                if (item.second && !item.second->IsReadOnly())
-                    matching.push_back(item.second.get());
+                auto& value = values[i];
+                if (value.Target->IsReadOnly())
+                {
+                    value.Status = SpotPluginApi::VariableStatus::ReadOnly;
+                    continue;
+                }
+                auto message = value.Target->NewMessage(internal::_MessageDataType(value.Target->Type()));
+                switch (value.Target->Type())
+                {
+                case VariableType::Bool:
+                    message.BoolValue = value.BoolValue;
+                    break;
+                case VariableType::Integer:
+                    message.NumericValue = round_to_nearest_awayzero(value.NumericValue);
+                    break;
+                case VariableType::Numeric:
+                    message.NumericValue = value.NumericValue;
+                    break;
+                case VariableType::Text:
+                    message.TextValue = SpotPluginApi::make_text_variable(value.TextValue);
+                    break;
+                }
+                messages.push_back(message);
+                valueIndex.push_back(i);
             }
-            return matching;
+
+            std::vector<SpotPluginApi::variable_status_t> status;
+            internal::_TransferVariables(true, messages, status);
+
+            bool allStored = messages.size() == values.size();
+            for (size_t i = 0; i < messages.size(); ++i)
+            {
+                auto& value = values[valueIndex[i]];
+                value.Status = status[i];
+                value.Target->InvalidateCachedValue();
+                allStored = allStored && value.IsValid();
+            }
+            return allStored;
+        }
+
+        // The query methods below return ranges that are evaluated while iterating and do not allocate.
+        // A range is invalidated when variables are added with Manage. Call ToVector() to keep the result.
+
+        // Variables with exactly the scope flags withScope
+        VariableRange<IVariable> MatchingAll(ScopeFlags withScope) const
+        {
+            return MatchingAll<IVariable>(withScope);
         }
 
         template<typename T>
-        std::vector<T*> AllMutable() const 
+        VariableRange<T> MatchingAll(ScopeFlags withScope) const
         {
-            std::vector<T*> matching;
-            for( auto& item : variableCollection)
-            {
-                if (item.second && !item.second->IsReadOnly() && dynamic_cast<T*>(item.second.get()))
-                    matching.push_back(static_cast<T*>(item.second.get()));
-            }
-            return matching;
+            auto query = TypedQuery<T>();
+            query.requiredScopes = static_cast<uint32_t>(withScope);
+            query.excludedScopes = ~query.requiredScopes;
+            return VariableRange<T>(index, query);
         }
 
-        std::vector<IVariable*> AllImmutable() const
+        // Variables with any of the scope flags withScope
+        VariableRange<IVariable> MatchingAny(ScopeFlags withScope) const
         {
-            std::vector<IVariable*> matching;
-            for( auto& item : variableCollection)
-            {
-                if (item.second && item.second->IsReadOnly())
-                    matching.push_back(item.second.get());
-            }
-            return matching;
+            return MatchingAny<IVariable>(withScope);
         }
 
         template<typename T>
-        std::vector<T*> AllImmutable() const 
+        VariableRange<T> MatchingAny(ScopeFlags withScope) const
         {
-            std::vector<T*> matching;
-            for( auto& item : variableCollection)
-            {
-                if (item.second && item.second->IsReadOnly() && dynamic_cast<T*>(item.second.get()))
-                    matching.push_back(static_cast<T*>(item.second.get()));
-            }
-            return matching;
+            auto query = TypedQuery<T>();
+            query.anyScopes = static_cast<uint32_t>(withScope);
+            if (0 == query.anyScopes)
+                query.partition = VariableIndex::PartitionCount; // nothing matches an empty scope
+            return VariableRange<T>(index, query);
+        }
+
+        VariableRange<IVariable> AllMutable() const
+        {
+            return AllMutable<IVariable>();
+        }
+
+        template<typename T>
+        VariableRange<T> AllMutable() const
+        {
+            auto query = TypedQuery<T>();
+            query.mutability = 1;
+            return VariableRange<T>(index, query);
+        }
+
+        VariableRange<IVariable> AllImmutable() const
+        {
+            return AllImmutable<IVariable>();
+        }
+
+        template<typename T>
+        VariableRange<T> AllImmutable() const
+        {
+            auto query = TypedQuery<T>();
+            query.mutability = 0;
+            return VariableRange<T>(index, query);
+        }
+
+        // Variables that report the host data type
+        VariableRange<IVariable> OfType(VariableType type) const
+        {
+            VariableQuery query;
+            query.partition = VariableIndex::PartitionOf(type);
+            return VariableRange<IVariable>(index, query);
         }
-        
 
+        // Adds a variable and takes ownership of it
         void Manage(IVariable* variable)
         {
-            variableCollection[variable->Name()].reset(variable);
+            ManageSlot(variable, true);
+        }
+
+        // Adds a variable that is owned elsewhere. The variable must outlive this object.
+        void Manage(IVariable& variable)
+        {
+            ManageSlot(&variable, false);
         }
 
         bool ContainsVariable(const std::string& name)
         {
-            return variableCollection.find(name) != variableCollection.end();
+            return no_slot != FindSlot(name);
         }
 
         template<typename T>
         bool ContainsVariable(const std::string& name)
         {
-            auto item = variableCollection.find(name);
-            return (item != variableCollection.end() && dynamic_cast<Variable<T*>>(item->second.get()) != nullptr);
-
+            auto slot = FindSlot(name);
+            return (no_slot != slot && dynamic_cast<Variable<T>*>(index.At(slot)) != nullptr);
         }
         
         IVariable& GetByName(const std::string& name) const
         {
-            auto itemLocation = variableCollection.find(name);
-            if (variableCollection.end() == itemLocation)
+            auto slot = FindSlot(name);
+            if (no_slot == slot)
                 throw std::invalid_argument(std::string("No variable with the name (").append(name).append(") exists"));
-            return *(itemLocation->second.get());
+            return *index.At(slot);
         }
 
         template<typename T>
@@ -542,40 +1494,73 @@ namespace internal // implementation specific namespace not for general usage
             GetByName<Variable<T>>(name).Value(value);
         }
 
-        // Return a reference to a VariableManager that includes all the standard variables available by the host application.
-        static VariableManager& StandardVars()
+    private:
+        void DetachWriteBehind()
         {
-            static VariableManager stdVars; // Singleton
+            if (!writeBehind)
+                return;
+            HostEvents::Idle().RemoveDelegate(flushOnIdle);
+            flushOnIdle.reset();
+            for (size_t slot = 0; slot < index.SlotCount(); ++slot)
+                index.At(slot)->AttachWriteBehind(nullptr);
+            writeBehind.reset();
+        }
 
-            if (stdVars.Size() == 0)
+        // Returns the slot of the variable with the name or no_slot
+        size_t FindSlot(const std::string& name) const
+        {
+            StdVarId id;
+            if (nullptr != standard && standard->Find(name.c_str(), id))
+                return static_cast<size_t>(id);
+            auto item = slotByName.find(name);
+            return (slotByName.end() == item) ? no_slot : item->second;
+        }
+
+        // Adds a variable or replaces the variable with the same name, which keeps its slot
+        void ManageSlot(IVariable* variable, bool takeOwnership)
+        {
+            std::unique_ptr<IVariable> ownedVariable(takeOwnership ? variable : nullptr);
+            auto slot = FindSlot(variable->Name());
+            if (no_slot == slot)
             {
-                for(auto &item : internal::std_vars_build_script)
-                {
-                    try
-                    {
-                        switch(item.type)
-                        {
-                        case VariableType::Bool:
-                            stdVars.Manage(new BoolVariable(item.szName, item.scope, item.readonly));
-                            break;
-                        case VariableType::Integer:
-                            stdVars.Manage(new IntegerVariable(item.szName, item.scope, item.readonly));
-                            break;
-                        case VariableType::Numeric:
-                            stdVars.Manage(new NumericVariable(item.szName, item.scope, item.readonly));
-                            break;
-                        case VariableType::Text:
-                            stdVars.Manage(new TextVariable(item.szName, item.scope, item.readonly));
-                            break;
-                        default:
-                            assert(false); 
-                            throw std::logic_error("application logic error in file " AT_FILE_LOCATION);
-                        }
-                    }
-                    catch(std::runtime_error&)
-                    { /* ignore load failures */ }
-                }
+                slot = index.SlotCount();
+                slotByName.insert(std::make_pair(variable->Name(), slot));
             }
+            else if (slot < index.SlotCount())
+                Flush(); // the pending value may belong to the variable that is replaced
+            index.Set(slot, variable);
+            variable->AttachCache(cache.get());
+            variable->AttachWriteBehind(writeBehind.get());
+            if (takeOwnership || slot < owned.size())
+            {
+                if (slot >= owned.size())
+                    owned.resize(slot + 1);
+                owned[slot] = std::move(ownedVariable); // deletes the replaced variable if it was owned
+            }
+        }
+
+        template<typename T>
+        static VariableQuery TypedQuery()
+        {
+            VariableQuery query;
+            query.partition = variable_partition<T>::value;
+            return query;
+        }
+
+        template<typename T>
+        static void PrimeCachedValue(IVariable* variable, const T& value)
+        {
+            auto typedVariable = dynamic_cast<Variable<T>*>(variable);
+            if (nullptr != typedVariable)
+                typedVariable->StoreCachedValue(value);
+        }
+
+    public:
+        // Return a reference to a VariableManager that includes all the standard variables available by the host application.
+        // The variables are the members of StandardVariables::Instance().
+        static VariableManager& StandardVars()
+        {
+            static VariableManager stdVars(StandardVariables::Instance()); // Singleton
             return stdVars;
         }
 
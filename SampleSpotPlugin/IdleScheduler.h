@@ -0,0 +1,320 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include "EventDelegate.h"
+#include "HostEvents.h"
+
+namespace HostInterop
+{
+    enum class IdlePriority
+    {
+        High,               // Work the user waits for
+        Normal,
+        Low                 // Background work such as housekeeping
+    };
+
+    /// Summary:
+    ///     The time left for the task of an idle tick. A task checks Expired() between units of work
+    ///     and returns once it is set, so the host thread gets back to the UI in time.
+    class IdleBudget
+    {
+    public:
+        typedef std::chrono::steady_clock clock_t;
+
+    private:
+        clock_t::time_point deadline;
+
+    public:
+        explicit IdleBudget(clock_t::time_point deadline) : deadline(deadline)
+        {
+        }
+
+        bool Expired() const { return clock_t::now() >= deadline; }
+
+        clock_t::duration Remaining() const
+        {
+            return std::max<clock_t::duration>(clock_t::duration::zero(), deadline - clock_t::now());
+        }
+
+        clock_t::time_point Deadline() const { return deadline; }
+    };
+
+    // Runtime of the tasks with the same name
+    struct IdleTaskStats
+    {
+        IdleTaskStats() : Posted(0), Completed(0), Cancelled(0), Failed(0), Slices(0), TotalMicroseconds(0), MaxSliceMicroseconds(0), Overruns(0)
+        { }
+
+        uint64_t Posted;
+        uint64_t Completed;
+        uint64_t Cancelled;
+        uint64_t Failed;                    // Tasks removed because they threw an exception
+        uint64_t Slices;                    // Calls of the task functions
+        uint64_t TotalMicroseconds;
+        uint64_t MaxSliceMicroseconds;
+        uint64_t Overruns;                  // Slices that returned more than a quarter of the time slice late
+        std::string LastError;              // The message of the last exception thrown by one of the tasks
+    };
+
+    struct IdleSchedulerStats
+    {
+        IdleSchedulerStats() : Ticks(0), BusyTicks(0), Slices(0), MaxTickMicroseconds(0), OverBudgetTicks(0)
+        { }
+
+        uint64_t Ticks;                     // Calls to RunSlice, usually one per Idle event
+        uint64_t BusyTicks;                 // Ticks that ran at least one task
+        uint64_t Slices;
+        uint64_t MaxTickMicroseconds;
+        uint64_t OverBudgetTicks;           // Ticks that ran more than a quarter of the time slice longer
+    };
+
+    /// Summary:
+    ///     Runs deferred work on the host thread while the host is idle, within a time slice per Idle event.
+    ///     A task is a function that does some work and returns true while it has more to do. It is called
+    ///     again on the following ticks until it returns false, so long jobs are cut into slices that keep the
+    ///     UI responsive. Each tick runs every task at most once, the tasks of the highest priority first,
+    ///     until the time slice is used. Tasks of one priority take turns, so the ones that did not fit into
+    ///     a tick run first on the next. Tasks posted by a task run on the next tick.
+    ///     A task that throws is removed and the error is recorded in its IdleTaskStats, since there is nobody
+    ///     to pass it to on the Idle event. Start binds RunSlice to HostEvents::Idle().
+    ///     All methods must be called on the host thread, tasks may post and cancel tasks.
+    class IdleScheduler
+    {
+    public:
+        typedef IdleBudget::clock_t clock_t;
+
+        // Returns true if the task has more work to do
+        typedef std::function<bool(const IdleBudget&)> task_func_t;
+
+    private:
+        typedef std::function<void(HostEvents::idle_event_t::arg_type)> idle_func_t;
+
+        struct Task
+        {
+            uint64_t id;
+            IdlePriority priority;
+            clock_t::time_point due;            // The task does not run on earlier ticks
+            task_func_t func;
+            IdleTaskStats* stats;
+        };
+
+        std::vector<std::shared_ptr<Task>> tasks;       // In the order they run within a priority
+        std::map<std::string, IdleTaskStats> taskStats;
+        clock_t::duration timeSlice;
+        uint64_t nextId;
+        IdleSchedulerStats stats;
+        std::shared_ptr<EventDelegate<HostEvents::idle_event_t::arg_type>> idleDelegate;
+
+        // no copies allowed. The Idle delegate refers to this object
+        IdleScheduler(const IdleScheduler&);
+        IdleScheduler& operator = (const IdleScheduler&);
+
+        static uint64_t Microseconds(clock_t::duration duration)
+        {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+        }
+
+        void Remove(const Task* task)
+        {
+            auto item = std::find_if(tasks.begin(), tasks.end(), [task] (const std::shared_ptr<Task>& candidate) { return candidate.get() == task; });
+            if (tasks.end() != item)
+                tasks.erase(item);
+        }
+
+    public:
+        explicit IdleScheduler(clock_t::duration timeSlice = std::chrono::milliseconds(2)) :
+            timeSlice(timeSlice), nextId(1)
+        {
+        }
+
+        ~IdleScheduler()
+        {
+            Stop();
+        }
+
+        // The scheduler of the sample plug-in
+        static IdleScheduler& Instance()
+        {
+            static IdleScheduler instance;
+            return instance;
+        }
+
+        clock_t::duration TimeSlice() const { return timeSlice; }
+        void SetTimeSlice(clock_t::duration slice) { timeSlice = slice; }
+
+        /// Summary:
+        ///     Adds a task that runs on the next ticks until it returns false.
+        /// Arguments:
+        ///     name     - Groups the runtime statistics of tasks
+        ///     func     - Does a part of the work and returns true if there is more
+        ///     priority - Tasks of a higher priority run first
+        /// Returns:
+        ///     The id to cancel the task
+        uint64_t Post(const std::string& name, task_func_t func, IdlePriority priority = IdlePriority::Normal)
+        {
+            return PostAfter(name, clock_t::duration::zero(), std::move(func), priority);
+        }
+
+        /// Summary:
+        ///     Adds a task like Post that runs on the first tick after the delay. For periodic work a task
+        ///     returns false and posts itself again, so it does not take a slice of the ticks in between.
+        uint64_t PostAfter(const std::string& name, clock_t::duration delay, task_func_t func, IdlePriority priority = IdlePriority::Normal)
+        {
+            std::shared_ptr<Task> task(new Task());
+            task->id = nextId++;
+            task->priority = priority;
+            task->due = clock_t::now() + delay;
+            task->func = std::move(func);
+            task->stats = &taskStats[name];
+            ++task->stats->Posted;
+            tasks.push_back(task);
+            return task->id;
+        }
+
+        /// Summary:
+        ///     Adds a task that calls func once for each index from 0 to count - 1, as many per tick as fit
+        ///     into the time slice, and then calls done.
+        uint64_t PostLoop(const std::string& name, size_t count, std::function<void(size_t)> func, std::function<void()> done = nullptr, IdlePriority priority = IdlePriority::Normal)
+        {
+            std::shared_ptr<size_t> next(new size_t(0));
+            return Post(name, [=] (const IdleBudget& budget) -> bool
+            {
+                while (*next < count)
+                {
+                    func((*next)++);
+                    if (budget.Expired())
+                        break;
+                }
+                if (*next < count)
+                    return true;
+                if (done)
+                    done();
+                return false;
+            }, priority);
+        }
+
+        // Removes a task that has not finished. Returns false if there is no such task.
+        bool Cancel(uint64_t id)
+        {
+            auto item = std::find_if(tasks.begin(), tasks.end(), [id] (const std::shared_ptr<Task>& task) { return task->id == id; });
+            if (tasks.end() == item)
+                return false;
+            ++(*item)->stats->Cancelled;
+            tasks.erase(item);
+            return true;
+        }
+
+        bool IsPending(uint64_t id) const
+        {
+            return std::any_of(tasks.begin(), tasks.end(), [id] (const std::shared_ptr<Task>& task) { return task->id == id; });
+        }
+
+        size_t Pending() const { return tasks.size(); }
+
+        const IdleSchedulerStats& Stats() const { return stats; }
+
+        // Runtime statistics by task name
+        const std::map<std::string, IdleTaskStats>& TaskStats() const { return taskStats; }
+
+        /// Summary:
+        ///     Runs each task that was due when the tick started once, until the time slice is used.
+        ///     At least one task runs per tick if any is due.
+        /// Returns:
+        ///     The number of task slices run
+        size_t RunSlice()
+        {
+            ++stats.Ticks;
+            auto start = clock_t::now();
+            IdleBudget budget(start + timeSlice);
+            size_t slices = 0;
+            auto now = start;
+
+            // The tasks may post and cancel tasks, so they run from a copy in the order of this tick
+            std::vector<std::shared_ptr<Task>> tickTasks(tasks);
+            std::stable_sort(tickTasks.begin(), tickTasks.end(), [] (const std::shared_ptr<Task>& left, const std::shared_ptr<Task>& right)
+            {
+                return left->priority < right->priority;
+            });
+            for (auto& task : tickTasks)
+            {
+                if (0 != slices && now >= budget.Deadline())
+                    break;
+                if (task->due > start || !IsPending(task->id))
+                    continue;
+                // Rotate so the other tasks of this priority run before this one again
+                Remove(task.get());
+                tasks.push_back(task);
+
+                bool more = false;
+                bool failed = true;
+                try
+                {
+                    more = task->func(budget);
+                    failed = false;
+                }
+                catch (std::exception& error)
+                {
+                    task->stats->LastError = error.what();
+                }
+                catch (...)
+                {
+                    task->stats->LastError = "Unknown exception";
+                }
+                auto finished = clock_t::now();
+                auto elapsed = Microseconds(finished - now);
+                auto& runtime = *task->stats;
+                ++runtime.Slices;
+                runtime.TotalMicroseconds += elapsed;
+                runtime.MaxSliceMicroseconds = std::max<uint64_t>(runtime.MaxSliceMicroseconds, elapsed);
+                if (finished - budget.Deadline() > timeSlice / 4)
+                    ++runtime.Overruns;
+                if (!more && IsPending(task->id))
+                {
+                    ++(failed ? runtime.Failed : runtime.Completed);
+                    Remove(task.get());
+                }
+                ++slices;
+                now = finished;
+            }
+
+            if (slices)
+            {
+                ++stats.BusyTicks;
+                stats.Slices += slices;
+                auto tick = Microseconds(now - start);
+                stats.MaxTickMicroseconds = std::max<uint64_t>(stats.MaxTickMicroseconds, tick);
+                if (now - start > timeSlice + timeSlice / 4)
+                    ++stats.OverBudgetTicks;
+            }
+            return slices;
+        }
+
+        // Runs a slice on every HostEvents::Idle() event
+        void Start()
+        {
+            if (idleDelegate)
+                return;
+            idle_func_t onIdle = [this] (HostEvents::idle_event_t::arg_type) { RunSlice(); };
+            idleDelegate = make_event_delegate(onIdle);
+            HostEvents::Idle().AddDelegate(idleDelegate);
+        }
+
+        void Stop()
+        {
+            if (!idleDelegate)
+                return;
+            HostEvents::Idle().RemoveDelegate(idleDelegate);
+            idleDelegate.reset();
+        }
+
+        bool IsStarted() const { return nullptr != idleDelegate; }
+    };
+}
@@ -0,0 +1,649 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include "ImageView.h"
+#include "LiveFrame.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#  define IMAGE_STATISTICS_X86
+#  if defined(_MSC_VER)
+#    include <intrin.h>
+#  else
+#    include <cpuid.h>
+#  endif
+#  include <immintrin.h>
+// AVX-512 intrinsics need Visual Studio 2017 or later
+#  if defined(__GNUC__) || (defined(_MSC_VER) && _MSC_VER >= 1911)
+#    define IMAGE_STATISTICS_AVX512
+#  endif
+#endif
+
+// Compiles a function for an instruction set that the rest of the build may not enable.
+// Visual C++ allows any intrinsic in any function, so nothing is needed there.
+#if defined(__GNUC__)
+#  define IMAGE_STATISTICS_TARGET(isa) __attribute__((target(isa)))
+#else
+#  define IMAGE_STATISTICS_TARGET(isa)
+#endif
+
+namespace HostInterop
+{
+    // Instruction sets of the image statistics kernels, from slowest to fastest
+    enum class SimdLevel
+    {
+        Scalar  = 0,
+        SSE41   = 1,
+        AVX2    = 2,
+        AVX512  = 3     // AVX-512 F and BW
+    };
+
+    inline const char* simd_level_name(SimdLevel level)
+    {
+        switch (level)
+        {
+        case SimdLevel::SSE41:
+            return "SSE4.1";
+        case SimdLevel::AVX2:
+            return "AVX2";
+        case SimdLevel::AVX512:
+            return "AVX-512";
+        default:
+            return "Scalar";
+        }
+    }
+
+namespace internal // implementation specific namespace not for general usage
+{
+    inline SimdLevel _DetectSimdLevel()
+    {
+#if defined(IMAGE_STATISTICS_X86)
+        unsigned leaf1[4] = { 0, 0, 0, 0 };
+        unsigned leaf7[4] = { 0, 0, 0, 0 };
+        unsigned long long enabledStates = 0;
+#  if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        unsigned maxLeaf = static_cast<unsigned>(info[0]);
+        __cpuid(info, 1);
+        std::copy(info, info + 4, leaf1);
+        if (maxLeaf >= 7)
+        {
+            __cpuidex(info, 7, 0);
+            std::copy(info, info + 4, leaf7);
+        }
+        if (leaf1[2] & (1u << 27))
+            enabledStates = _xgetbv(0);
+#  else
+        unsigned maxLeaf = __get_cpuid_max(0, nullptr);
+        __cpuid(1, leaf1[0], leaf1[1], leaf1[2], leaf1[3]);
+        if (maxLeaf >= 7)
+            __cpuid_count(7, 0, leaf7[0], leaf7[1], leaf7[2], leaf7[3]);
+        if (leaf1[2] & (1u << 27))
+        {
+            unsigned low, high;
+            __asm__ __volatile__("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+            enabledStates = (static_cast<unsigned long long>(high) << 32) | low;
+        }
+#  endif
+        // The operating system must save the vector registers, which XGETBV reports (OSXSAVE is CPUID.1:ECX bit 27)
+        bool hasAvxState = (enabledStates & 0x06) == 0x06;
+        bool hasAvx512State = (enabledStates & 0xe6) == 0xe6;
+        bool hasAvx512 = hasAvx512State && (leaf7[1] & (1u << 16)) && (leaf7[1] & (1u << 30));
+        bool hasAvx2 = hasAvxState && (leaf1[2] & (1u << 28)) && (leaf7[1] & (1u << 5));
+#  if defined(IMAGE_STATISTICS_AVX512)
+        if (hasAvx2 && hasAvx512)
+            return SimdLevel::AVX512;
+#  endif
+        if (hasAvx2)
+            return SimdLevel::AVX2;
+        if (leaf1[2] & (1u << 19))
+            return SimdLevel::SSE41;
+#endif
+        return SimdLevel::Scalar;
+    }
+} // end namespace internal
+
+    // The fastest kernels the processor and operating system support. Detected once.
+    inline SimdLevel supported_simd_level()
+    {
+        static const SimdLevel level = internal::_DetectSimdLevel();
+        return level;
+    }
+
+    /// Summary:
+    ///     Sample statistics of one channel (or of all channels, see ImageStatistics::Combined)
+    struct ChannelStatistics
+    {
+        ChannelStatistics() : Count(0), Minimum(0), Maximum(0), Sum(0), SumOfSquares(0) {}
+
+        uint64_t Count;
+        uint32_t Minimum;
+        uint32_t Maximum;
+        uint64_t Sum;
+        uint64_t SumOfSquares;
+
+        double Mean() const { return Count ? static_cast<double>(Sum) / Count : 0.0; }
+
+        // Population variance
+        double Variance() const
+        {
+            if (0 == Count)
+                return 0.0;
+            double mean = Mean();
+            return std::max<double>(static_cast<double>(SumOfSquares) / Count - mean * mean, 0.0);
+        }
+
+        double StandardDeviation() const { return std::sqrt(Variance()); }
+
+        // RMS contrast: the standard deviation relative to the mean. Zero for a black image.
+        double Contrast() const
+        {
+            double mean = Mean();
+            return (mean > 0.0) ? StandardDeviation() / mean : 0.0;
+        }
+    };
+
+namespace internal // implementation specific namespace not for general usage
+{
+    // Samples next to each other go to different copies of the histogram, so incrementing the same bin
+    // twice in a row does not wait for the previous store. The copies are added up at the end.
+    const uint32_t _HistogramLanes = 4;
+
+    // Rows are handed to the kernels in chunks of at most this many samples. It is a multiple of every
+    // SIMD period (3 channels x 32 lanes, 4 x 32) and small enough that 32 bit lane sums cannot overflow.
+    const size_t _StatisticsChunkSamples = 49152;
+
+    const uint32_t _MaxSimdLanes = 32;
+    const uint32_t _MaxSimdPhases = 3;
+
+    struct _StatisticsAccumulator
+    {
+        uint32_t channels;
+        uint32_t histogramShift;        // Sample values are shifted right by this to get the bin
+        uint32_t bins;
+        uint32_t* histogram;            // _HistogramLanes x channels x bins counts
+        uint32_t minimum[4];
+        uint32_t maximum[4];
+        uint64_t sum[4];
+        uint64_t sumOfSquares[4];
+    };
+
+    typedef void (*_statistics_kernel_t)(const uint16_t* samples, size_t count, _StatisticsAccumulator& acc);
+
+    /// The reference implementation. Counts into the first histogram lane only.
+    /// samples must start with channel 0 of a pixel.
+    template<typename T>
+    inline void _AccumulateScalar(const T* samples, size_t count, _StatisticsAccumulator& acc)
+    {
+        const uint32_t lastBin = acc.bins - 1;
+        uint32_t channel = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            uint32_t value = samples[i];
+            acc.minimum[channel] = std::min<uint32_t>(acc.minimum[channel], value);
+            acc.maximum[channel] = std::max<uint32_t>(acc.maximum[channel], value);
+            acc.sum[channel] += value;
+            acc.sumOfSquares[channel] += static_cast<uint64_t>(value) * value;
+            ++acc.histogram[channel * acc.bins + std::min<uint32_t>(value >> acc.histogramShift, lastBin)];
+            if (++channel == acc.channels)
+                channel = 0;
+        }
+    }
+
+    inline void _AccumulateScalar16(const uint16_t* samples, size_t count, _StatisticsAccumulator& acc)
+    {
+        _AccumulateScalar(samples, count, acc);
+    }
+
+    // The SIMD kernels load vectors of laneCount samples. With 3 channels a channel does not stay in the same
+    // lane from one vector to the next, so the vectors of a period of 3 are kept apart as phases.
+    // Lane j of phase p holds samples of channel (p * laneCount + j) % channels.
+    inline uint32_t _PhaseCount(uint32_t channels)
+    {
+        return (3 == channels) ? 3 : 1;
+    }
+
+    inline uint32_t _LaneChannel(uint32_t phase, uint32_t lane, uint32_t laneCount, uint32_t channels)
+    {
+        return (phase * laneCount + lane) % channels;
+    }
+
+    // The offset of the histogram a lane counts into
+    inline void _LaneHistogramOffsets(uint32_t laneCount, const _StatisticsAccumulator& acc, uint32_t offsets[_MaxSimdPhases][_MaxSimdLanes])
+    {
+        for (uint32_t phase = 0; phase < _PhaseCount(acc.channels); ++phase)
+        {
+            for (uint32_t lane = 0; lane < laneCount; ++lane)
+                offsets[phase][lane] = ((lane % _HistogramLanes) * acc.channels + _LaneChannel(phase, lane, laneCount, acc.channels)) * acc.bins;
+        }
+    }
+
+    /// Adds the lane results of one phase to the channel statistics.
+    /// sums holds the 32 bit lane sums in lane order. squareQuarters holds four groups of laneCount / 4 sums of
+    /// squares: the even and the odd lanes of the lower half of the lanes, then the same for the upper half.
+    inline void _ReduceLanes(const uint16_t* minimum, const uint16_t* maximum, const uint32_t* sums, const uint64_t* squareQuarters,
+        uint32_t laneCount, uint32_t phase, _StatisticsAccumulator& acc)
+    {
+        const uint32_t quarter = laneCount / 4;
+        for (uint32_t lane = 0; lane < laneCount; ++lane)
+        {
+            uint32_t channel = _LaneChannel(phase, lane, laneCount, acc.channels);
+            acc.minimum[channel] = std::min<uint32_t>(acc.minimum[channel], minimum[lane]);
+            acc.maximum[channel] = std::max<uint32_t>(acc.maximum[channel], maximum[lane]);
+            acc.sum[channel] += sums[lane];
+        }
+        for (uint32_t group = 0; group < 4; ++group)
+        {
+            for (uint32_t i = 0; i < quarter; ++i)
+            {
+                uint32_t lane = ((group >= 2) ? laneCount / 2 : 0) + 2 * i + (group & 1);
+                acc.sumOfSquares[_LaneChannel(phase, lane, laneCount, acc.channels)] += squareQuarters[group * quarter + i];
+            }
+        }
+    }
+
+#if defined(IMAGE_STATISTICS_X86)
+    /// Counts the bins of 8 lanes. The bins are extracted from the register, because loading them back
+    /// after storing the whole vector would stall on store forwarding for the upper parts of wide vectors.
+    IMAGE_STATISTICS_TARGET("sse4.1")
+    inline void _ScatterHistogram(__m128i bins, const uint32_t* laneOffsets, uint32_t* histogram)
+    {
+        uint32_t pair = static_cast<uint32_t>(_mm_cvtsi128_si32(bins));
+        ++histogram[laneOffsets[0] + (pair & 0xffff)];
+        ++histogram[laneOffsets[1] + (pair >> 16)];
+        pair = static_cast<uint32_t>(_mm_extract_epi32(bins, 1));
+        ++histogram[laneOffsets[2] + (pair & 0xffff)];
+        ++histogram[laneOffsets[3] + (pair >> 16)];
+        pair = static_cast<uint32_t>(_mm_extract_epi32(bins, 2));
+        ++histogram[laneOffsets[4] + (pair & 0xffff)];
+        ++histogram[laneOffsets[5] + (pair >> 16)];
+        pair = static_cast<uint32_t>(_mm_extract_epi32(bins, 3));
+        ++histogram[laneOffsets[6] + (pair & 0xffff)];
+        ++histogram[laneOffsets[7] + (pair >> 16)];
+    }
+
+    IMAGE_STATISTICS_TARGET("sse4.1")
+    inline void _AccumulateSse41(const uint16_t* samples, size_t count, _StatisticsAccumulator& acc)
+    {
+        const uint32_t laneCount = 8;
+        const uint32_t phaseCount = _PhaseCount(acc.channels);
+        const size_t period = laneCount * phaseCount;
+        const size_t vectorized = count - count % period;
+
+        uint32_t laneOffsets[_MaxSimdPhases][_MaxSimdLanes];
+        _LaneHistogramOffsets(laneCount, acc, laneOffsets);
+
+        __m128i minimum[_MaxSimdPhases], maximum[_MaxSimdPhases], sumLow[_MaxSimdPhases], sumHigh[_MaxSimdPhases], squares[_MaxSimdPhases][4];
+        for (uint32_t p = 0; p < phaseCount; ++p)
+        {
+            minimum[p] = _mm_set1_epi16(-1);
+            maximum[p] = sumLow[p] = sumHigh[p] = _mm_setzero_si128();
+            for (auto& item : squares[p])
+                item = _mm_setzero_si128();
+        }
+        const __m128i shift = _mm_cvtsi32_si128(static_cast<int>(acc.histogramShift));
+        const __m128i lastBin = _mm_set1_epi16(static_cast<short>(acc.bins - 1));
+
+        for (size_t i = 0; i < vectorized; i += period)
+        {
+            for (uint32_t p = 0; p < phaseCount; ++p)
+            {
+                __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + i + p * laneCount));
+                minimum[p] = _mm_min_epu16(minimum[p], value);
+                maximum[p] = _mm_max_epu16(maximum[p], value);
+                __m128i low = _mm_cvtepu16_epi32(value);
+                __m128i high = _mm_cvtepu16_epi32(_mm_srli_si128(value, 8));
+                sumLow[p] = _mm_add_epi32(sumLow[p], low);
+                sumHigh[p] = _mm_add_epi32(sumHigh[p], high);
+                __m128i lowOdd = _mm_srli_epi64(low, 32);
+                __m128i highOdd = _mm_srli_epi64(high, 32);
+                squares[p][0] = _mm_add_epi64(squares[p][0], _mm_mul_epu32(low, low));
+                squares[p][1] = _mm_add_epi64(squares[p][1], _mm_mul_epu32(lowOdd, lowOdd));
+                squares[p][2] = _mm_add_epi64(squares[p][2], _mm_mul_epu32(high, high));
+                squares[p][3] = _mm_add_epi64(squares[p][3], _mm_mul_epu32(highOdd, highOdd));
+                _ScatterHistogram(_mm_min_epu16(_mm_srl_epi16(value, shift), lastBin), laneOffsets[p], acc.histogram);
+            }
+        }
+
+        if (vectorized > 0)
+        {
+            uint16_t laneMinimum[laneCount], laneMaximum[laneCount];
+            uint32_t laneSums[laneCount];
+            uint64_t squareQuarters[laneCount];
+            for (uint32_t p = 0; p < phaseCount; ++p)
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(laneMinimum), minimum[p]);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(laneMaximum), maximum[p]);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(laneSums), sumLow[p]);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(laneSums + laneCount / 2), sumHigh[p]);
+                for (uint32_t group = 0; group < 4; ++group)
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(squareQuarters + group * laneCount / 4), squares[p][group]);
+                _ReduceLanes(laneMinimum, laneMaximum, laneSums, squareQuarters, laneCount, p, acc);
+            }
+        }
+        _AccumulateScalar(samples + vectorized, count - vectorized, acc);
+    }
+
+    IMAGE_STATISTICS_TARGET("avx2")
+    inline void _AccumulateAvx2(const uint16_t* samples, size_t count, _StatisticsAccumulator& acc)
+    {
+        const uint32_t laneCount = 16;
+        const uint32_t phaseCount = _PhaseCount(acc.channels);
+        const size_t period = laneCount * phaseCount;
+        const size_t vectorized = count - count % period;
+
+        uint32_t laneOffsets[_MaxSimdPhases][_MaxSimdLanes];
+        _LaneHistogramOffsets(laneCount, acc, laneOffsets);
+
+        __m256i minimum[_MaxSimdPhases], maximum[_MaxSimdPhases], sumLow[_MaxSimdPhases], sumHigh[_MaxSimdPhases], squares[_MaxSimdPhases][4];
+        for (uint32_t p = 0; p < phaseCount; ++p)
+        {
+            minimum[p] = _mm256_set1_epi16(-1);
+            maximum[p] = sumLow[p] = sumHigh[p] = _mm256_setzero_si256();
+            for (auto& item : squares[p])
+                item = _mm256_setzero_si256();
+        }
+        const __m128i shift = _mm_cvtsi32_si128(static_cast<int>(acc.histogramShift));
+        const __m256i lastBin = _mm256_set1_epi16(static_cast<short>(acc.bins - 1));
+
+        for (size_t i = 0; i < vectorized; i += period)
+        {
+            for (uint32_t p = 0; p < phaseCount; ++p)
+            {
+                __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(samples + i + p * laneCount));
+                minimum[p] = _mm256_min_epu16(minimum[p], value);
+                maximum[p] = _mm256_max_epu16(maximum[p], value);
+                __m256i low = _mm256_cvtepu16_epi32(_mm256_castsi256_si128(value));
+                __m256i high = _mm256_cvtepu16_epi32(_mm256_extracti128_si256(value, 1));
+                sumLow[p] = _mm256_add_epi32(sumLow[p], low);
+                sumHigh[p] = _mm256_add_epi32(sumHigh[p], high);
+                __m256i lowOdd = _mm256_srli_epi64(low, 32);
+                __m256i highOdd = _mm256_srli_epi64(high, 32);
+                squares[p][0] = _mm256_add_epi64(squares[p][0], _mm256_mul_epu32(low, low));
+                squares[p][1] = _mm256_add_epi64(squares[p][1], _mm256_mul_epu32(lowOdd, lowOdd));
+                squares[p][2] = _mm256_add_epi64(squares[p][2], _mm256_mul_epu32(high, high));
+                squares[p][3] = _mm256_add_epi64(squares[p][3], _mm256_mul_epu32(highOdd, highOdd));
+                __m256i bins = _mm256_min_epu16(_mm256_srl_epi16(value, shift), lastBin);
+                _ScatterHistogram(_mm256_castsi256_si128(bins), laneOffsets[p], acc.histogram);
+                _ScatterHistogram(_mm256_extracti128_si256(bins, 1), laneOffsets[p] + 8, acc.histogram);
+            }
+        }
+
+        if (vectorized > 0)
+        {
+            uint16_t laneMinimum[laneCount], laneMaximum[laneCount];
+            uint32_t laneSums[laneCount];
+            uint64_t squareQuarters[laneCount];
+            for (uint32_t p = 0; p < phaseCount; ++p)
+            {
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(laneMinimum), minimum[p]);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(laneMaximum), maximum[p]);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(laneSums), sumLow[p]);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(laneSums + laneCount / 2), sumHigh[p]);
+                for (uint32_t group = 0; group < 4; ++group)
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(squareQuarters + group * laneCount / 4), squares[p][group]);
+                _ReduceLanes(laneMinimum, laneMaximum, laneSums, squareQuarters, laneCount, p, acc);
+            }
+        }
+        _AccumulateScalar(samples + vectorized, count - vectorized, acc);
+    }
+
+#  if defined(IMAGE_STATISTICS_AVX512)
+#    if defined(__GNUC__)
+// The GCC 12 AVX-512 headers start intrinsics from deliberately uninitialized vectors
+#      pragma GCC diagnostic push
+#      pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#    endif
+    IMAGE_STATISTICS_TARGET("avx512f,avx512bw")
+    inline void _AccumulateAvx512(const uint16_t* samples, size_t count, _StatisticsAccumulator& acc)
+    {
+        const uint32_t laneCount = 32;
+        const uint32_t phaseCount = _PhaseCount(acc.channels);
+        const size_t period = laneCount * phaseCount;
+        const size_t vectorized = count - count % period;
+
+        uint32_t laneOffsets[_MaxSimdPhases][_MaxSimdLanes];
+        _LaneHistogramOffsets(laneCount, acc, laneOffsets);
+
+        __m512i minimum[_MaxSimdPhases], maximum[_MaxSimdPhases], sumLow[_MaxSimdPhases], sumHigh[_MaxSimdPhases], squares[_MaxSimdPhases][4];
+        for (uint32_t p = 0; p < phaseCount; ++p)
+        {
+            minimum[p] = _mm512_set1_epi16(-1);
+            maximum[p] = sumLow[p] = sumHigh[p] = _mm512_setzero_si512();
+            for (auto& item : squares[p])
+                item = _mm512_setzero_si512();
+        }
+        const __m128i shift = _mm_cvtsi32_si128(static_cast<int>(acc.histogramShift));
+        const __m512i lastBin = _mm512_set1_epi16(static_cast<short>(acc.bins - 1));
+
+        for (size_t i = 0; i < vectorized; i += period)
+        {
+            for (uint32_t p = 0; p < phaseCount; ++p)
+            {
+                __m512i value = _mm512_loadu_si512(samples + i + p * laneCount);
+                minimum[p] = _mm512_min_epu16(minimum[p], value);
+                maximum[p] = _mm512_max_epu16(maximum[p], value);
+                __m512i low = _mm512_cvtepu16_epi32(_mm512_castsi512_si256(value));
+                __m512i high = _mm512_cvtepu16_epi32(_mm512_extracti64x4_epi64(value, 1));
+                sumLow[p] = _mm512_add_epi32(sumLow[p], low);
+                sumHigh[p] = _mm512_add_epi32(sumHigh[p], high);
+                __m512i lowOdd = _mm512_srli_epi64(low, 32);
+                __m512i highOdd = _mm512_srli_epi64(high, 32);
+                squares[p][0] = _mm512_add_epi64(squares[p][0], _mm512_mul_epu32(low, low));
+                squares[p][1] = _mm512_add_epi64(squares[p][1], _mm512_mul_epu32(lowOdd, lowOdd));
+                squares[p][2] = _mm512_add_epi64(squares[p][2], _mm512_mul_epu32(high, high));
+                squares[p][3] = _mm512_add_epi64(squares[p][3], _mm512_mul_epu32(highOdd, highOdd));
+                __m512i bins = _mm512_min_epu16(_mm512_srl_epi16(value, shift), lastBin);
+                _ScatterHistogram(_mm512_castsi512_si128(bins), laneOffsets[p], acc.histogram);
+                _ScatterHistogram(_mm512_extracti32x4_epi32(bins, 1), laneOffsets[p] + 8, acc.histogram);
+                _ScatterHistogram(_mm512_extracti32x4_epi32(bins, 2), laneOffsets[p] + 16, acc.histogram);
+                _ScatterHistogram(_mm512_extracti32x4_epi32(bins, 3), laneOffsets[p] + 24, acc.histogram);
+            }
+        }
+
+        if (vectorized > 0)
+        {
+            uint16_t laneMinimum[laneCount], laneMaximum[laneCount];
+            uint32_t laneSums[laneCount];
+            uint64_t squareQuarters[laneCount];
+            for (uint32_t p = 0; p < phaseCount; ++p)
+            {
+                _mm512_storeu_si512(laneMinimum, minimum[p]);
+                _mm512_storeu_si512(laneMaximum, maximum[p]);
+                _mm512_storeu_si512(laneSums, sumLow[p]);
+                _mm512_storeu_si512(laneSums + laneCount / 2, sumHigh[p]);
+                for (uint32_t group = 0; group < 4; ++group)
+                    _mm512_storeu_si512(squareQuarters + group * laneCount / 4, squares[p][group]);
+                _ReduceLanes(laneMinimum, laneMaximum, laneSums, squareQuarters, laneCount, p, acc);
+            }
+        }
+        _AccumulateScalar(samples + vectorized, count - vectorized, acc);
+    }
+#    if defined(__GNUC__)
+#      pragma GCC diagnostic pop
+#    endif
+#  endif // IMAGE_STATISTICS_AVX512
+#endif // IMAGE_STATISTICS_X86
+
+    inline _statistics_kernel_t _StatisticsKernel(SimdLevel level)
+    {
+        switch (level)
+        {
+#if defined(IMAGE_STATISTICS_X86)
+#  if defined(IMAGE_STATISTICS_AVX512)
+        case SimdLevel::AVX512:
+            return _AccumulateAvx512;
+#  endif
+        case SimdLevel::AVX2:
+            return _AccumulateAvx2;
+        case SimdLevel::SSE41:
+            return _AccumulateSse41;
+#endif
+        default:
+            return _AccumulateScalar16;
+        }
+    }
+} // end namespace internal
+
+    /// Summary:
+    ///     Histogram, minimum, maximum, mean, standard deviation and contrast of the channels of an image.
+    ///     Compute() runs the fastest kernels the processor supports (see supported_simd_level()) over a
+    ///     strided ImageView in a single pass. All kernels give exactly the same results as the scalar
+    ///     reference kernel, which can be selected to validate them.
+    ///     Only 16 bit samples have SIMD kernels, 8 bit samples always use the scalar kernel.
+    class ImageStatistics
+    {
+    public:
+        // The histogram resolution used unless a different one is requested. 12 bit samples get one bin per value.
+        static const uint32_t DefaultHistogramBits = 12;
+
+        ImageStatistics() : Channels(0), BitDepth(0), HistogramBits(0), Level(SimdLevel::Scalar)
+        {
+        }
+
+        uint32_t Channels;
+        uint32_t BitDepth;
+        uint32_t HistogramBits;             // The histogram has 2^HistogramBits bins per channel
+        SimdLevel Level;                    // The kernels that computed the statistics
+        ChannelStatistics Channel[4];
+        std::vector<uint32_t> Histogram;    // The bins of channel 0 followed by those of the other channels
+
+        uint32_t HistogramBins() const { return 1u << HistogramBits; }
+
+        const uint32_t* ChannelHistogram(uint32_t channel) const
+        {
+            return Histogram.data() + static_cast<size_t>(channel) * HistogramBins();
+        }
+
+        // The sample value of the first bin at which the given fraction of the samples of a channel is reached,
+        // e.g. 0.5 for the median. The resolution is one histogram bin.
+        uint32_t Percentile(uint32_t channel, double fraction) const
+        {
+            auto histogram = ChannelHistogram(channel);
+            auto target = static_cast<uint64_t>(std::ceil(fraction * Channel[channel].Count));
+            uint64_t seen = 0;
+            for (uint32_t bin = 0; bin < HistogramBins(); ++bin)
+            {
+                seen += histogram[bin];
+                if (seen >= target && seen > 0)
+                    return bin << (BitDepth - HistogramBits);
+            }
+            return Channel[channel].Maximum;
+        }
+
+        // The statistics of the samples of all channels together
+        ChannelStatistics Combined() const
+        {
+            ChannelStatistics combined;
+            combined.Minimum = Channels ? Channel[0].Minimum : 0;
+            for (uint32_t channel = 0; channel < Channels; ++channel)
+            {
+                combined.Count += Channel[channel].Count;
+                combined.Minimum = std::min<uint32_t>(combined.Minimum, Channel[channel].Minimum);
+                combined.Maximum = std::max<uint32_t>(combined.Maximum, Channel[channel].Maximum);
+                combined.Sum += Channel[channel].Sum;
+                combined.SumOfSquares += Channel[channel].SumOfSquares;
+            }
+            return combined;
+        }
+
+        double Mean() const { return Combined().Mean(); }
+        double StandardDeviation() const { return Combined().StandardDeviation(); }
+
+        // RMS contrast over all channels, a per frame measure to compare with the LiveImgContrast variable
+        double Contrast() const { return Combined().Contrast(); }
+
+        /// Summary:
+        ///     Computes the statistics of all samples of a view.
+        /// Arguments:
+        ///     view          - The pixels. Each pixel has view.Channels() interleaved samples (1 to 4).
+        ///     bitDepth      - The number of significant bits of a sample. Samples must not use higher bits.
+        ///     histogramBits - The resolution of the histogram. Limited to bitDepth.
+        ///     level         - The kernels to run. Limited to supported_simd_level().
+        /// Throws:
+        ///     invalid_argument if the bit depth does not fit the sample type or the view has too many channels
+        static ImageStatistics Compute(const ImageView<const uint16_t>& view, uint32_t bitDepth, uint32_t histogramBits = DefaultHistogramBits, SimdLevel level = supported_simd_level())
+        {
+            level = std::min<SimdLevel>(level, supported_simd_level());
+            return Accumulate(view, bitDepth, histogramBits, level, internal::_StatisticsKernel(level));
+        }
+
+        static ImageStatistics Compute(const ImageView<const uint8_t>& view, uint32_t bitDepth = 8, uint32_t histogramBits = DefaultHistogramBits)
+        {
+            return Accumulate(view, bitDepth, histogramBits, SimdLevel::Scalar, &internal::_AccumulateScalar<uint8_t>);
+        }
+
+        // Computes the statistics of a live frame in place, see Compute(const ImageView<const uint16_t>&, ...)
+        static ImageStatistics Compute(const LiveFrame& frame, uint32_t histogramBits = DefaultHistogramBits, SimdLevel level = supported_simd_level())
+        {
+            if (frame.BytesPerSample() == 1)
+                return Compute(frame.View<uint8_t>(), frame.BitDepth(), histogramBits);
+            return Compute(frame.View<uint16_t>(), frame.BitDepth(), histogramBits, level);
+        }
+
+    private:
+        template<typename T, typename Kernel>
+        static ImageStatistics Accumulate(const ImageView<const T>& view, uint32_t bitDepth, uint32_t histogramBits, SimdLevel level, Kernel kernel)
+        {
+            if (0 == bitDepth || bitDepth > 8 * sizeof(T))
+                throw std::invalid_argument(std::string("A bit depth of ").append(std::to_string(bitDepth)).append(" does not fit in the samples of the image view"));
+            if (0 == view.Channels() || view.Channels() > 4)
+                throw std::invalid_argument("Image statistics support 1 to 4 channels");
+
+            ImageStatistics result;
+            result.Channels = view.Channels();
+            result.BitDepth = bitDepth;
+            result.HistogramBits = std::min<uint32_t>(std::max<uint32_t>(histogramBits, 1), bitDepth);
+            result.Level = level;
+
+            internal::_StatisticsAccumulator acc;
+            acc.channels = result.Channels;
+            acc.histogramShift = bitDepth - result.HistogramBits;
+            acc.bins = result.HistogramBins();
+            std::vector<uint32_t> laneHistograms(static_cast<size_t>(internal::_HistogramLanes) * acc.channels * acc.bins);
+            acc.histogram = laneHistograms.data();
+            for (uint32_t channel = 0; channel < 4; ++channel)
+            {
+                acc.minimum[channel] = UINT32_MAX;
+                acc.maximum[channel] = 0;
+                acc.sum[channel] = 0;
+                acc.sumOfSquares[channel] = 0;
+            }
+
+            const size_t rowLength = view.RowLength();
+            for (uint32_t y = 0; y < view.Height(); ++y)
+            {
+                auto row = view.Row(y);
+                for (size_t offset = 0; offset < rowLength; offset += internal::_StatisticsChunkSamples)
+                    kernel(row + offset, std::min<size_t>(internal::_StatisticsChunkSamples, rowLength - offset), acc);
+            }
+
+            // Add up the histogram lanes
+            result.Histogram.assign(laneHistograms.begin(), laneHistograms.begin() + static_cast<size_t>(acc.channels) * acc.bins);
+            for (uint32_t lane = 1; lane < internal::_HistogramLanes; ++lane)
+            {
+                auto laneHistogram = laneHistograms.data() + static_cast<size_t>(lane) * acc.channels * acc.bins;
+                for (size_t bin = 0; bin < result.Histogram.size(); ++bin)
+                    result.Histogram[bin] += laneHistogram[bin];
+            }
+
+            const uint64_t count = static_cast<uint64_t>(view.Width()) * view.Height();
+            for (uint32_t channel = 0; channel < result.Channels; ++channel)
+            {
+                auto& stats = result.Channel[channel];
+                stats.Count = count;
+                stats.Minimum = count ? acc.minimum[channel] : 0;
+                stats.Maximum = acc.maximum[channel];
+                stats.Sum = acc.sum[channel];
+                stats.SumOfSquares = acc.sumOfSquares[channel];
+            }
+            return result;
+        }
+    };
+}
@@ -0,0 +1,279 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <stdexcept>
+#include <type_traits>
+#include <iterator>
+#include "SpotPlugin.h"
+#include "PluginHost.h"
+
+namespace HostInterop
+{
+    // The number of channel samples per pixel of a layout or zero if the layout is unknown
+    inline uint32_t channel_count(SpotPluginApi::channel_layout_t layout)
+    {
+        using namespace SpotPluginApi;
+        switch (layout)
+        {
+        case ChannelLayout::Mono:
+        case ChannelLayout::Bayer:
+            return 1;
+        case ChannelLayout::RGB:
+        case ChannelLayout::BGR:
+            return 3;
+        case ChannelLayout::RGBA:
+        case ChannelLayout::BGRA:
+            return 4;
+        default:
+            return 0;
+        }
+    }
+
+    // The number of bytes used to store one channel sample of the given bit depth
+    inline uint32_t bytes_per_sample(uint32_t bitDepth)
+    {
+        return (bitDepth <= 8) ? 1 : 2;
+    }
+
+    /// Summary:
+    ///     The samples of one image row, usable in a range-based for loop.
+    template<typename T>
+    class ImageRow
+    {
+        T* first;
+        T* last;
+
+    public:
+        typedef T value_type;
+        typedef T* iterator;
+
+        ImageRow(T* first, T* last) : first(first), last(last) {}
+
+        T* begin() const { return first; }
+        T* end() const { return last; }
+        size_t size() const { return last - first; }
+        T& operator[](size_t i) const { return first[i]; }
+    };
+
+    /// Summary:
+    ///     A typed view of pixels that are owned elsewhere, e.g. by a LiveFrame or an ImageLock.
+    ///     Rows are Stride() bytes apart, which may be more than Width() * Channels() samples, so always
+    ///     address pixels through Row() or At(). Channels are interleaved within a row.
+    ///     The view is only valid while the owner of the pixels keeps them in place. Use ImageView<const T>
+    ///     for read only access, a view of T converts to a view of const T.
+    /// Template Arguments:
+    ///     T - The sample type. uint8_t for a bit depth up to 8, otherwise uint16_t.
+    template<typename T>
+    class ImageView
+    {
+        T* pixels;
+        uint32_t width;
+        uint32_t height;
+        intptr_t stride;    // In bytes
+        uint32_t channels;
+
+        template<typename U> friend class ImageView;
+
+    public:
+        typedef T value_type;
+
+        /// Summary:
+        ///     Iterates over the rows of a view from top to bottom
+        class row_iterator : public std::iterator<std::forward_iterator_tag, ImageRow<T>>
+        {
+            const ImageView* view;
+            uint32_t y;
+
+        public:
+            row_iterator(const ImageView* view, uint32_t y) : view(view), y(y) {}
+
+            ImageRow<T> operator*() const { return view->RowSamples(y); }
+            row_iterator& operator++() { ++y; return *this; }
+            row_iterator operator++(int) { row_iterator previous(*this); ++y; return previous; }
+            bool operator==(const row_iterator& rhs) const { return y == rhs.y; }
+            bool operator!=(const row_iterator& rhs) const { return y != rhs.y; }
+        };
+
+        struct row_range
+        {
+            row_iterator first;
+            row_iterator last;
+            row_iterator begin() const { return first; }
+            row_iterator end() const { return last; }
+        };
+
+        ImageView() : pixels(nullptr), width(0), height(0), stride(0), channels(1)
+        {
+        }
+
+        ImageView(T* pixels, uint32_t width, uint32_t height, intptr_t stride, uint32_t channels = 1) :
+            pixels(pixels), width(width), height(height), stride(stride), channels(channels)
+        {
+        }
+
+        // A view of mutable samples converts to a view of const samples
+        template<typename U>
+        ImageView(const ImageView<U>& rhs, typename std::enable_if<std::is_convertible<U*, T*>::value>::type* = nullptr) :
+            pixels(rhs.pixels), width(rhs.width), height(rhs.height), stride(rhs.stride), channels(rhs.channels)
+        {
+        }
+
+        T* Data() const { return pixels; }
+        uint32_t Width() const { return width; }
+        uint32_t Height() const { return height; }
+        intptr_t Stride() const { return stride; }
+        uint32_t Channels() const { return channels; }
+        bool IsEmpty() const { return nullptr == pixels || 0 == width || 0 == height; }
+
+        // The number of samples in a row, excluding any padding up to the stride
+        size_t RowLength() const { return static_cast<size_t>(width) * channels; }
+
+        // The first sample of row y. The row is not range checked.
+        T* Row(uint32_t y) const
+        {
+            return reinterpret_cast<T*>(reinterpret_cast<typename std::conditional<std::is_const<T>::value, const uint8_t*, uint8_t*>::type>(pixels) + static_cast<intptr_t>(y) * stride);
+        }
+
+        ImageRow<T> RowSamples(uint32_t y) const
+        {
+            auto row = Row(y);
+            return ImageRow<T>(row, row + RowLength());
+        }
+
+        // The sample of a channel of pixel (x, y). The position is not range checked.
+        T& At(uint32_t x, uint32_t y, uint32_t channel = 0) const
+        {
+            return Row(y)[static_cast<size_t>(x) * channels + channel];
+        }
+
+        row_range Rows() const
+        {
+            row_range range = { row_iterator(this, 0), row_iterator(this, height) };
+            return range;
+        }
+
+        /// Summary:
+        ///     Returns a view of a rectangle of this view that shares the same pixels.
+        /// Throws:
+        ///     out_of_range if the rectangle is not inside this view
+        ImageView SubView(uint32_t x, uint32_t y, uint32_t subWidth, uint32_t subHeight) const
+        {
+            if (x > width || y > height || subWidth > width - x || subHeight > height - y)
+                throw std::out_of_range("The sub view rectangle is outside of the image view");
+            return ImageView(Row(y) + static_cast<size_t>(x) * channels, subWidth, subHeight, stride, channels);
+        }
+    };
+
+    /// Summary:
+    ///     Makes a typed view of a pixel buffer described by the host.
+    /// Throws:
+    ///     invalid_argument if T does not match the sample size of the bit depth
+    template<typename T, typename Pixels>
+    ImageView<T> make_image_view(Pixels* pixels, uint32_t width, uint32_t height, intptr_t stride, uint32_t bitDepth, SpotPluginApi::channel_layout_t layout)
+    {
+        if (sizeof(T) != bytes_per_sample(bitDepth))
+            throw std::invalid_argument(std::string("An image with a bit depth of ").append(std::to_string(bitDepth)).append(" can not be viewed with samples of ").append(std::to_string(sizeof(T))).append(" bytes"));
+        auto channels = channel_count(layout);
+        return ImageView<T>(static_cast<T*>(pixels), width, height, stride, channels ? channels : 1);
+    }
+
+    /// Summary:
+    ///     Borrows the pixel buffer of the image document that has focus, see msg_image_view_t.
+    ///     While the lock is held the host keeps the buffer in place and does not switch documents, so
+    ///     locks should be released as soon as the pixels are processed. The lock is released by Release()
+    ///     or the destructor, both of which must run on the host thread just like Acquire().
+    ///     Views returned by the lock are invalid after it is released.
+    class ImageLock
+    {
+        SpotPluginApi::msg_image_view_t message;
+        bool isLocked;
+
+        // no copies allowed. Each lock is released exactly once
+        ImageLock(const ImageLock&);
+        ImageLock& operator = (const ImageLock&);
+
+        ImageLock() : isLocked(false)
+        {
+        }
+
+    public:
+        /// Summary:
+        ///     Locks the pixels of the active image document.
+        /// Throws:
+        ///     runtime_error if no image document has focus or the access conflicts with a lock that is already held
+        static ImageLock Acquire(SpotPluginApi::image_view_access_t access = SpotPluginApi::ImageViewAccess::Read)
+        {
+            ImageLock lock;
+            lock.message.Access = access;
+            if (!PluginHost::DoAction(SpotPluginApi::HostActionRequest::AcquireImageView, 0, &lock.message))
+                throw std::runtime_error("Unable to acquire a view of the active image document");
+            lock.isLocked = true;
+            return lock;
+        }
+
+        ImageLock(ImageLock&& rhs) : message(rhs.message), isLocked(rhs.isLocked)
+        {
+            rhs.isLocked = false;
+        }
+
+        ImageLock& operator = (ImageLock&& rhs)
+        {
+            if (this != &rhs)
+            {
+                Release();
+                message = rhs.message;
+                isLocked = rhs.isLocked;
+                rhs.isLocked = false;
+            }
+            return *this;
+        }
+
+        ~ImageLock()
+        {
+            Release();
+        }
+
+        // Returns the pixels to the host. Does nothing if the lock has already been released.
+        void Release()
+        {
+            if (!isLocked)
+                return;
+            isLocked = false;
+            PluginHost::DoAction(SpotPluginApi::HostActionRequest::ReleaseImageView, 0, &message);
+        }
+
+        bool IsLocked() const { return isLocked; }
+        bool IsWritable() const { return isLocked && SpotPluginApi::ImageViewAccess::ReadWrite == message.Access; }
+
+        uint32_t Width() const { return message.Width; }
+        uint32_t Height() const { return message.Height; }
+        uint32_t BitDepth() const { return message.BitDepth; }
+        SpotPluginApi::channel_layout_t ChannelLayout() const { return message.ChannelLayout; }
+
+        /// Summary:
+        ///     Returns a read only view of the locked pixels.
+        /// Throws:
+        ///     logic_error if the lock has been released, invalid_argument if T does not match the bit depth
+        template<typename T>
+        ImageView<const T> View() const
+        {
+            if (!isLocked)
+                throw std::logic_error("The image view lock has been released");
+            return make_image_view<const T>(static_cast<const void*>(message.Pixels), message.Width, message.Height, message.Stride, message.BitDepth, message.ChannelLayout);
+        }
+
+        /// Summary:
+        ///     Returns a view that changes the locked pixels. The lock must have been acquired with ImageViewAccess::ReadWrite.
+        /// Throws:
+        ///     logic_error if the lock is not writable, invalid_argument if T does not match the bit depth
+        template<typename T>
+        ImageView<T> WritableView() const
+        {
+            if (!IsWritable())
+                throw std::logic_error("The image view lock was not acquired for writing");
+            return make_image_view<T>(message.Pixels, message.Width, message.Height, message.Stride, message.BitDepth, message.ChannelLayout);
+        }
+    };
+}
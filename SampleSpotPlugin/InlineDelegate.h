@@ -0,0 +1,139 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <new>
+#include <memory>
+#include <utility>
+#include <type_traits>
+#include "EventDelegate.h"
+
+// Identifies a delegate in a MulticastEventDelegate so it can be removed again
+typedef uintptr_t delegate_token_t;
+
+/// Summary:
+///     One delegate of a MulticastEventDelegate, stored by value so a list of them is a contiguous array.
+///     A callable of up to Capacity bytes is kept inside the object. A larger callable is kept on the heap
+///     and shared by the copies, as is an EventDelegate added by shared_ptr. Calling the delegate is a
+///     single indirect call through a function pointer kept next to the callable.
+///     Callables are copied when the list they are in changes, so state that must survive belongs
+///     outside of them (captured by pointer or reference).
+template<typename ArgType, size_t Capacity = 40>
+class InlineDelegate
+{
+    typedef typename std::aligned_storage<Capacity, sizeof(void*)>::type storage_t;
+    typedef void (*invoke_func_t)(const storage_t& storage, ArgType& args);
+
+    struct Operations
+    {
+        void (*Copy)(storage_t& target, const storage_t& source);
+        void (*Destroy)(storage_t& storage);
+    };
+
+    template<typename F>
+    struct OperationsOf
+    {
+        static void Invoke(const storage_t& storage, ArgType& args)
+        {
+            (*const_cast<F*>(reinterpret_cast<const F*>(&storage)))(args);
+        }
+
+        static void Copy(storage_t& target, const storage_t& source)
+        {
+            new (&target) F(*reinterpret_cast<const F*>(&source));
+        }
+
+        static void Destroy(storage_t& storage)
+        {
+            reinterpret_cast<F*>(&storage)->~F();
+        }
+
+        static const Operations* Table()
+        {
+            static const Operations table = { &Copy, &Destroy };
+            return &table;
+        }
+    };
+
+    // Calls a callable that does not fit inline. The copies of the delegate share it.
+    template<typename F>
+    struct HeapCall
+    {
+        std::shared_ptr<F> func;
+        void operator()(ArgType& args) const { (*func)(args); }
+    };
+
+    struct SharedDelegateCall
+    {
+        std::shared_ptr<EventDelegate<ArgType>> target;
+        void operator()(ArgType& args) const { (*target)(args); }
+    };
+
+    invoke_func_t invoke;
+    const Operations* operations;
+    delegate_token_t token;
+    storage_t storage;
+
+    // not assignable. A list of delegates is rebuilt by copying instead of being changed in place
+    InlineDelegate& operator = (const InlineDelegate&);
+
+    template<typename F>
+    void Store(F&& func, std::true_type /* fits inline */)
+    {
+        typedef typename std::decay<F>::type func_t;
+        new (&storage) func_t(std::forward<F>(func));
+        invoke = &OperationsOf<func_t>::Invoke;
+        operations = OperationsOf<func_t>::Table();
+    }
+
+    template<typename F>
+    void Store(F&& func, std::false_type /* fits inline */)
+    {
+        typedef typename std::decay<F>::type func_t;
+        HeapCall<func_t> call;
+        call.func = std::make_shared<func_t>(std::forward<F>(func));
+        Store(std::move(call), std::true_type());
+    }
+
+public:
+    static const size_t capacity = Capacity;
+
+    // Tells whether a callable of type F is kept inside the delegate
+    template<typename F>
+    struct fits_inline : public std::integral_constant<bool,
+        sizeof(F) <= Capacity && std::alignment_of<F>::value <= std::alignment_of<storage_t>::value>
+    {
+    };
+
+    template<typename F>
+    InlineDelegate(F&& func, delegate_token_t delegateToken) : token(delegateToken)
+    {
+        Store(std::forward<F>(func), fits_inline<typename std::decay<F>::type>());
+    }
+
+    // Calls an EventDelegate held by shared_ptr. The token is the address of the delegate.
+    explicit InlineDelegate(std::shared_ptr<EventDelegate<ArgType>> target) :
+        token(reinterpret_cast<delegate_token_t>(target.get()))
+    {
+        SharedDelegateCall call;
+        call.target = std::move(target);
+        Store(std::move(call), std::true_type());
+    }
+
+    InlineDelegate(const InlineDelegate& rhs) : invoke(rhs.invoke), operations(rhs.operations), token(rhs.token)
+    {
+        operations->Copy(storage, rhs.storage);
+    }
+
+    ~InlineDelegate()
+    {
+        operations->Destroy(storage);
+    }
+
+    delegate_token_t Token() const { return token; }
+
+    void operator()(ArgType& args) const
+    {
+        invoke(storage, args);
+    }
+};
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <stddef.h>
+#include <new>
+#include <utility>
+#include <type_traits>
+#include <functional>
+
+template<typename Signature, size_t Capacity = 32>
+class InplaceFunction;
+
+/// Summary:
+///     A copyable function object like std::function that stores the callable inside the object.
+///     It never allocates memory. Callables larger than Capacity bytes are rejected at compile time,
+///     so captures should be kept to a few pointers or values.
+template<typename R, typename... Args, size_t Capacity>
+class InplaceFunction<R(Args...), Capacity>
+{
+    typedef typename std::aligned_storage<Capacity>::type storage_t;
+
+    // One table of operations per stored callable type
+    struct Operations
+    {
+        R (*Invoke)(const storage_t& storage, Args... args);
+        void (*Copy)(storage_t& target, const storage_t& source);
+        void (*Move)(storage_t& target, storage_t& source);
+        void (*Destroy)(storage_t& storage);
+    };
+
+    template<typename F>
+    struct OperationsOf
+    {
+        static R Invoke(const storage_t& storage, Args... args)
+        {
+            return (*const_cast<F*>(reinterpret_cast<const F*>(&storage)))(std::forward<Args>(args)...);
+        }
+
+        static void Copy(storage_t& target, const storage_t& source)
+        {
+            new (&target) F(*reinterpret_cast<const F*>(&source));
+        }
+
+        static void Move(storage_t& target, storage_t& source)
+        {
+            new (&target) F(std::move(*reinterpret_cast<F*>(&source)));
+        }
+
+        static void Destroy(storage_t& storage)
+        {
+            reinterpret_cast<F*>(&storage)->~F();
+        }
+
+        static const Operations* Table()
+        {
+            static const Operations table = { &Invoke, &Copy, &Move, &Destroy };
+            return &table;
+        }
+    };
+
+    storage_t storage;
+    const Operations* operations;   // nullptr when empty
+
+    // A null function pointer makes an empty function, as it does for std::function
+    template<typename F>
+    static bool IsNull(const F& func, typename std::enable_if<std::is_pointer<F>::value || std::is_member_pointer<F>::value>::type* = nullptr)
+    {
+        return nullptr == func;
+    }
+
+    template<typename F>
+    static bool IsNull(const F&, typename std::enable_if<!std::is_pointer<F>::value && !std::is_member_pointer<F>::value>::type* = nullptr)
+    {
+        return false;
+    }
+
+public:
+    static const size_t capacity = Capacity;
+
+    InplaceFunction() : operations(nullptr)
+    {
+    }
+
+    InplaceFunction(std::nullptr_t) : operations(nullptr)
+    {
+    }
+
+    template<typename F>
+    InplaceFunction(F func, typename std::enable_if<!std::is_same<typename std::decay<F>::type, InplaceFunction>::value>::type* = nullptr) :
+        operations(nullptr)
+    {
+        static_assert(sizeof(F) <= Capacity, "The callable does not fit in the InplaceFunction. Capture less or raise the capacity.");
+        static_assert(std::alignment_of<F>::value <= std::alignment_of<storage_t>::value, "The callable needs a stronger alignment than InplaceFunction provides.");
+        if (IsNull(func))
+            return;
+        new (&storage) F(std::move(func));
+        operations = OperationsOf<F>::Table();
+    }
+
+    InplaceFunction(const InplaceFunction& rhs) : operations(rhs.operations)
+    {
+        if (operations)
+            operations->Copy(storage, rhs.storage);
+    }
+
+    InplaceFunction(InplaceFunction&& rhs) : operations(rhs.operations)
+    {
+        if (operations)
+            operations->Move(storage, rhs.storage);
+    }
+
+    ~InplaceFunction()
+    {
+        Reset();
+    }
+
+    InplaceFunction& operator = (const InplaceFunction& rhs)
+    {
+        if (this != &rhs)
+        {
+            Reset();
+            if (rhs.operations)
+                rhs.operations->Copy(storage, rhs.storage);
+            operations = rhs.operations;
+        }
+        return *this;
+    }
+
+    InplaceFunction& operator = (InplaceFunction&& rhs)
+    {
+        if (this != &rhs)
+        {
+            Reset();
+            if (rhs.operations)
+                rhs.operations->Move(storage, rhs.storage);
+            operations = rhs.operations;
+        }
+        return *this;
+    }
+
+    void Reset()
+    {
+        if (operations)
+            operations->Destroy(storage);
+        operations = nullptr;
+    }
+
+    explicit operator bool() const { return nullptr != operations; }
+
+    R operator()(Args... args) const
+    {
+        if (nullptr == operations)
+            throw std::bad_function_call();
+        return operations->Invoke(storage, std::forward<Args>(args)...);
+    }
+};
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <memory>
+#include <vector>
+#include <functional>
+#include "SpotPlugin.h"
+#include "EventDispatchQueue.h"
+#include "ImageView.h"
+
+namespace HostInterop
+{
+    /// Summary:
+    ///     A live image frame sent by the host with HostEvent::LiveFrameReady.
+    ///     The frame refers to the pixels of the host without copying them, so it may only be used while the
+    ///     event is handled. Call Detach() to keep a frame after that. Event sources that do not dispatch
+    ///     inline detach every frame they queue (see event_arg_storage<HostInterop::LiveFrame>).
+    class LiveFrame
+    {
+        SpotPluginApi::live_frame_t descriptor;
+        std::shared_ptr<const std::vector<uint8_t>> ownedPixels;  // Set when the frame holds its own copy of the pixels
+
+    public:
+        LiveFrame()
+        {
+        }
+
+        // Refers to the frame described by the host. A null descriptor gives an empty frame.
+        explicit LiveFrame(const SpotPluginApi::live_frame_t* hostFrame)
+        {
+            if (hostFrame)
+                descriptor = *hostFrame;
+        }
+
+        const SpotPluginApi::live_frame_t& Descriptor() const { return descriptor; }
+
+        int32_t Version() const { return descriptor.Version; }
+        const void* Pixels() const { return descriptor.Pixels; }
+        uint32_t Width() const { return descriptor.Width; }
+        uint32_t Height() const { return descriptor.Height; }
+        intptr_t Stride() const { return descriptor.Stride; }
+        uint32_t BitDepth() const { return descriptor.BitDepth; }
+        SpotPluginApi::channel_layout_t ChannelLayout() const { return descriptor.ChannelLayout; }
+        uint64_t FrameIndex() const { return descriptor.FrameIndex; }
+        uint64_t Timestamp() const { return descriptor.Timestamp; }
+
+        bool IsEmpty() const { return nullptr == descriptor.Pixels || 0 == descriptor.Width || 0 == descriptor.Height; }
+
+        // true if the pixels are owned by this frame and stay valid after the event
+        bool IsDetached() const { return nullptr != ownedPixels; }
+
+        // The number of channel samples per pixel or zero if the layout is unknown
+        uint32_t ChannelCount() const { return channel_count(descriptor.ChannelLayout); }
+
+        uint32_t BytesPerSample() const { return bytes_per_sample(descriptor.BitDepth); }
+        uint32_t BytesPerPixel() const { return ChannelCount() * BytesPerSample(); }
+
+        // The number of bytes of pixel data in a row, which may be less than the stride
+        size_t RowBytes() const
+        {
+            auto stride = static_cast<size_t>((descriptor.Stride < 0) ? -descriptor.Stride : descriptor.Stride);
+            return (0 == BytesPerPixel()) ? stride : static_cast<size_t>(descriptor.Width) * BytesPerPixel();
+        }
+
+        /// Summary:
+        ///     Returns the first sample of row y. T must match BytesPerSample(), e.g. uint8_t or uint16_t.
+        ///     Rows are stride apart, which is not necessarily Width() * BytesPerPixel().
+        template<typename T>
+        const T* Row(uint32_t y) const
+        {
+            return reinterpret_cast<const T*>(static_cast<const uint8_t*>(descriptor.Pixels) + static_cast<intptr_t>(y) * descriptor.Stride);
+        }
+
+        /// Summary:
+        ///     Returns a typed view of the pixels, valid as long as Row() is.
+        /// Throws:
+        ///     invalid_argument if T does not match BytesPerSample()
+        template<typename T>
+        ImageView<const T> View() const
+        {
+            return make_image_view<const T>(descriptor.Pixels, descriptor.Width, descriptor.Height, descriptor.Stride, descriptor.BitDepth, descriptor.ChannelLayout);
+        }
+
+        /// Summary:
+        ///     Returns a frame with a copy of the pixels that stays valid after the event.
+        ///     The copy is stored top-down without row padding. A detached frame is returned as is.
+        LiveFrame Detach() const
+        {
+            if (IsDetached() || IsEmpty())
+                return *this;
+
+            auto rowBytes = RowBytes();
+            std::shared_ptr<std::vector<uint8_t>> pixels(new std::vector<uint8_t>(rowBytes * descriptor.Height));
+            for (uint32_t y = 0; y < descriptor.Height; ++y)
+                memcpy(pixels->data() + y * rowBytes, Row<uint8_t>(y), rowBytes);
+
+            LiveFrame detached(*this);
+            detached.descriptor.Pixels = pixels->data();
+            detached.descriptor.Stride = static_cast<intptr_t>(rowBytes);
+            detached.ownedPixels = pixels;
+            return detached;
+        }
+    };
+}
+
+struct EventArgToLiveFrame : public std::unary_function<uintptr_t, HostInterop::LiveFrame>
+{
+    HostInterop::LiveFrame operator() (uintptr_t val) { return HostInterop::LiveFrame(reinterpret_cast<const SpotPluginApi::live_frame_t*>(val)); }
+};
+
+// The host owns the pixels of a live frame only until the event returns, so queued frames are copied
+template<>
+struct event_arg_storage<HostInterop::LiveFrame>
+{
+    typedef HostInterop::LiveFrame type;
+    static type Store(const HostInterop::LiveFrame& arg) { return arg.Detach(); }
+    static HostInterop::LiveFrame View(type& stored) { return stored; }
+};
@@ -0,0 +1,188 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#if defined(_WIN32)
+#  include <windows.h>
+#else
+#  include <sys/types.h>
+#  include <sys/stat.h>
+#  include <sys/mman.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif
+
+namespace HostInterop
+{
+    /// Summary:
+    ///     Maps a whole file into memory. The pages are loaded by the OS as they are touched, so a file is
+    ///     read without copying it into a buffer first. Open maps an existing file for reading and an empty
+    ///     file opens with a Size of zero and no Data. Create maps a new file for writing. Writes to the
+    ///     mapping reach the file even if the process crashes afterwards, Flush starts writing them to disk.
+    class MappedFile
+    {
+#if defined(_WIN32)
+        HANDLE file;
+        HANDLE mapping;
+#else
+        int file;
+#endif
+        uint8_t* data;
+        size_t size;
+
+        // no copies allowed. The object owns the mapping
+        MappedFile(const MappedFile&);
+        MappedFile& operator = (const MappedFile&);
+
+    public:
+        MappedFile() :
+#if defined(_WIN32)
+            file(INVALID_HANDLE_VALUE), mapping(nullptr),
+#else
+            file(-1),
+#endif
+            data(nullptr), size(0)
+        {
+        }
+
+        ~MappedFile()
+        {
+            Close();
+        }
+
+        /// Summary:
+        ///     Maps the file, closing the file mapped before.
+        /// Returns:
+        ///     false if the file does not exist or can not be mapped
+        bool Open(const std::string& fileName)
+        {
+            Close();
+#if defined(_WIN32)
+            file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            if (INVALID_HANDLE_VALUE == file)
+                return false;
+            LARGE_INTEGER fileSize;
+            if (!GetFileSizeEx(file, &fileSize) || static_cast<uint64_t>(fileSize.QuadPart) > SIZE_MAX)
+            {
+                Close();
+                return false;
+            }
+            size = static_cast<size_t>(fileSize.QuadPart);
+            if (0 == size)
+                return true;
+            mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (nullptr != mapping)
+                data = static_cast<uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+            file = open(fileName.c_str(), O_RDONLY);
+            if (file < 0)
+                return false;
+            struct stat status;
+            if (0 != fstat(file, &status))
+            {
+                Close();
+                return false;
+            }
+            size = static_cast<size_t>(status.st_size);
+            if (0 == size)
+                return true;
+            auto address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+            if (MAP_FAILED != address)
+                data = static_cast<uint8_t*>(address);
+#endif
+            if (nullptr == data)
+            {
+                Close();
+                return false;
+            }
+            return true;
+        }
+
+        /// Summary:
+        ///     Creates a file of fileSize zero bytes, replacing an existing file, and maps it for writing.
+        ///     The file mapped before is closed.
+        /// Returns:
+        ///     false if the file can not be created or mapped
+        bool Create(const std::string& fileName, size_t fileSize)
+        {
+            Close();
+            if (0 == fileSize)
+                return false;
+#if defined(_WIN32)
+            file = CreateFileA(fileName.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (INVALID_HANDLE_VALUE == file)
+                return false;
+            size = fileSize;
+            auto mappingSize = static_cast<uint64_t>(fileSize);
+            mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, static_cast<DWORD>(mappingSize >> 32), static_cast<DWORD>(mappingSize), nullptr);
+            if (nullptr != mapping)
+                data = static_cast<uint8_t*>(MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, 0));
+#else
+            file = open(fileName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+            if (file < 0)
+                return false;
+            if (0 != ftruncate(file, static_cast<off_t>(fileSize)))
+            {
+                Close();
+                return false;
+            }
+            size = fileSize;
+            auto address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+            if (MAP_FAILED != address)
+                data = static_cast<uint8_t*>(address);
+#endif
+            if (nullptr == data)
+            {
+                Close();
+                return false;
+            }
+            return true;
+        }
+
+        // Starts writing the changed pages of a mapping made by Create to disk without waiting for them
+        void Flush()
+        {
+            if (nullptr == data)
+                return;
+#if defined(_WIN32)
+            FlushViewOfFile(data, 0);
+#else
+            msync(data, size, MS_ASYNC);
+#endif
+        }
+
+        void Close()
+        {
+#if defined(_WIN32)
+            if (nullptr != data)
+                UnmapViewOfFile(data);
+            if (nullptr != mapping)
+                CloseHandle(mapping);
+            if (INVALID_HANDLE_VALUE != file)
+                CloseHandle(file);
+            mapping = nullptr;
+            file = INVALID_HANDLE_VALUE;
+#else
+            if (nullptr != data)
+                munmap(data, size);
+            if (file >= 0)
+                close(file);
+            file = -1;
+#endif
+            data = nullptr;
+            size = 0;
+        }
+
+        bool IsOpen() const
+        {
+#if defined(_WIN32)
+            return INVALID_HANDLE_VALUE != file;
+#else
+            return file >= 0;
+#endif
+        }
+
+        const uint8_t* Data() const { return data; }
+        uint8_t* Data() { return data; }
+        size_t Size() const { return size; }
+    };
+}
@@ -3,66 +3,223 @@
 #include <memory>
 #include <algorithm>
 #include <vector>
+#include <atomic>
+#include <mutex>
 #include "EventDelegate.h"
+#include "InlineDelegate.h"
 
+/// Summary:
+///     Invokes a list of delegates for every event.
+///     The list is published as an immutable snapshot. An event invokes the snapshot that was current when it
+///     started without taking a lock or touching the delegate reference counts. Adding or removing a delegate
+///     copies the list under a lock and publishes the copy, so both are safe from any thread and from inside a
+///     handler. A delegate removed during an event can still be called by events already in progress. It is
+///     destroyed once no event is in progress any more.
+///     The delegates are kept by value in one array (see InlineDelegate), so an event walks contiguous
+///     memory and makes one indirect call per delegate. Subscribe stores a callable in the array itself,
+///     AddDelegate stores a shared_ptr to an EventDelegate that is called through its virtual operator().
 template<typename ArgType>
 class MulticastEventDelegate : public EventDelegate<ArgType>
 {
+public:
+    typedef InlineDelegate<ArgType> delegate_type;
+
 private:
-    typedef std::vector<std::shared_ptr<EventDelegate<ArgType>>> delegate_container_t;
-    delegate_container_t delegates;
+    typedef std::vector<delegate_type> delegate_container_t;
+    typedef std::unique_ptr<const delegate_container_t> snapshot_ptr_t;
+
+    std::atomic<const delegate_container_t*> delegates;     // Current snapshot or nullptr when there are no delegates
+    std::atomic<unsigned> activeDispatchCount;               // Number of events in progress on any thread
+    std::mutex updateLock;                                   // Serializes writers and guards retiredSnapshots
+    std::vector<snapshot_ptr_t> retiredSnapshots;            // Replaced snapshots that events in progress may still be reading
+    delegate_token_t lastToken;                              // Guarded by updateLock
+
+    // no copies allowed. Events in progress refer to the snapshots owned by this object
+    MulticastEventDelegate(const MulticastEventDelegate&);
+    MulticastEventDelegate& operator = (const MulticastEventDelegate&);
+
+    // Publishes a new snapshot. Must be called with updateLock held.
+    void Publish(delegate_container_t* snapshot)
+    {
+        if (snapshot && snapshot->empty())
+        {
+            delete snapshot;
+            snapshot = nullptr;
+        }
+        auto replaced = delegates.exchange(snapshot);
+        if (replaced)
+            retiredSnapshots.push_back(snapshot_ptr_t(replaced));
+    }
+
+    // Publishes a snapshot with the delegate added before or after the others. Must be called with updateLock held.
+    void Add(delegate_type&& d, bool first, std::unique_lock<std::mutex>& lock)
+    {
+        auto current = delegates.load();
+        std::unique_ptr<delegate_container_t> snapshot(new delegate_container_t());
+        snapshot->reserve((current ? current->size() : 0) + 1);
+        if (first)
+            snapshot->push_back(std::move(d));
+        if (current)
+        {
+            for (auto& item : *current)
+                snapshot->push_back(item);
+        }
+        if (!first)
+            snapshot->push_back(std::move(d));
+        Publish(snapshot.release());
+        ReclaimRetiredSnapshots(lock);
+    }
+
+    // Publishes a snapshot without the delegate with the token. Must be called with updateLock held.
+    void Remove(delegate_token_t token, std::unique_lock<std::mutex>& lock)
+    {
+        auto current = delegates.load();
+        if (nullptr == current)
+            return;
+        auto isTarget = [=] (const delegate_type& item) { return item.Token() == token; };
+        if (std::none_of(current->begin(), current->end(), isTarget))
+            return;
+        auto snapshot = new delegate_container_t();
+        snapshot->reserve(current->size() - 1);
+        for (auto& item : *current)
+        {
+            if (!isTarget(item))
+                snapshot->push_back(item);
+        }
+        Publish(snapshot);
+        ReclaimRetiredSnapshots(lock);
+    }
+
+    // Frees the retired snapshots if no event is in progress. The delegates are released outside the lock
+    // because their destructors may add or remove delegates.
+    void ReclaimRetiredSnapshots(std::unique_lock<std::mutex>& lock)
+    {
+        std::vector<snapshot_ptr_t> reclaimed;
+        if (0 == activeDispatchCount.load())
+            reclaimed.swap(retiredSnapshots);
+        lock.unlock();
+    }
 
 public:
-    MulticastEventDelegate() : EventDelegate()
+    MulticastEventDelegate() : EventDelegate<ArgType>(), delegates(nullptr), activeDispatchCount(0), lastToken(0)
     {
     }
 
     virtual ~MulticastEventDelegate()
     {
+        delete delegates.load();
     }
 
-    MulticastEventDelegate(MulticastEventDelegate && rhs)
+    // Moving is not thread safe. No event may be in progress on either object.
+    MulticastEventDelegate(MulticastEventDelegate && rhs) : delegates(nullptr), activeDispatchCount(0), lastToken(rhs.lastToken)
     {
-        delegates = std::move(rhs.delegates);
+        delegates = rhs.delegates.exchange(nullptr);
+        retiredSnapshots = std::move(rhs.retiredSnapshots);
     }
 
     MulticastEventDelegate& operator=(MulticastEventDelegate && rhs)
     {
         if (this != &rhs)
         {
-            delegates.clear();
-            delegates = std::move(rhs.delegates);
+            delete delegates.exchange(rhs.delegates.exchange(nullptr));
+            retiredSnapshots = std::move(rhs.retiredSnapshots);
+            lastToken = std::max<delegate_token_t>(lastToken, rhs.lastToken);
         }
         return *this;
     }
 
     void AddDelegate(std::shared_ptr<EventDelegate<ArgType>> d)
     {
-        delegates.push_back(d);
+        delegate_type item(std::move(d));
+        std::unique_lock<std::mutex> lock(updateLock);
+        Add(std::move(item), false, lock);
+    }
+
+    // Adds a delegate that is called before all delegates added so far
+    void AddDelegateFirst(std::shared_ptr<EventDelegate<ArgType>> d)
+    {
+        delegate_type item(std::move(d));
+        std::unique_lock<std::mutex> lock(updateLock);
+        Add(std::move(item), true, lock);
     }
 
     void RemoveDelegate(std::shared_ptr<EventDelegate<ArgType>> d)
     {
-        delegates.erase(std::remove(delegates.begin(), delegates.end(), d), delegates.end());
+        RemoveDelegate(d.get());
     }
 
     void RemoveDelegate(const EventDelegate<ArgType>* d)
     {
-        auto exitingVal = std::find_if(delegates.begin(), delegates.end(), [=] (delegate_container_t::const_reference item)
-        {
-            return item.get() == d;
-        });
-        delegates.erase(exitingVal);
+        std::unique_lock<std::mutex> lock(updateLock);
+        Remove(reinterpret_cast<delegate_token_t>(d), lock);
+    }
+
+    /// Summary:
+    ///     Adds a callable that is called with ArgType& for every event. A callable of up to
+    ///     delegate_type::capacity bytes is stored in the delegate array without a heap allocation.
+    /// Returns:
+    ///     The token to pass to Unsubscribe
+    template<typename Func>
+    delegate_token_t Subscribe(Func&& func)
+    {
+        std::unique_lock<std::mutex> lock(updateLock);
+        // Odd numbers never match the address of an EventDelegate added with AddDelegate
+        lastToken += 2;
+        auto token = lastToken | 1;
+        Add(delegate_type(std::forward<Func>(func), token), false, lock);
+        return token;
+    }
+
+    void Unsubscribe(delegate_token_t token)
+    {
+        std::unique_lock<std::mutex> lock(updateLock);
+        Remove(token, lock);
     }
 
     void RemoveAllDelegates()
     {
-        delegates.clear();
+        std::unique_lock<std::mutex> lock(updateLock);
+        Publish(nullptr);
+        ReclaimRetiredSnapshots(lock);
+    }
+
+    size_t Count() const
+    {
+        auto current = delegates.load();
+        return current ? current->size() : 0;
     }
 
     virtual void operator()(ArgType& args)
     {
-        for (auto func : delegates)
-            (*func)(args);
+        // The count is raised before the snapshot is loaded. A writer that replaces the snapshot afterwards
+        // sees the event in progress and keeps the old snapshot alive until the count drops to zero.
+        ++activeDispatchCount;
+        auto current = delegates.load();
+        if (current)
+        {
+            try
+            {
+                for (auto& func : *current)
+                    func(args);
+            }
+            catch (...)
+            {
+                EndDispatch();
+                throw;
+            }
+        }
+        EndDispatch();
+    }
+
+private:
+    void EndDispatch()
+    {
+        if (0 != --activeDispatchCount)
+            return;
+        // Last event out frees the snapshots replaced while events were in progress. Events never wait
+        // for a writer, if the lock is taken they are freed by a later event or change instead.
+        std::unique_lock<std::mutex> lock(updateLock, std::try_to_lock);
+        if (lock.owns_lock() && !retiredSnapshots.empty())
+            ReclaimRetiredSnapshots(lock);
     }
-};
\ No newline at end of file
+};
@@ -2,4 +2,5 @@
 #include "PluginHost.h"
 
 SpotPluginApi::host_action_func_t PluginHost::ActionFunc = NULL;
-uintptr_t PluginHost::pluginHandle = 0;
\ No newline at end of file
+uintptr_t PluginHost::pluginHandle = 0;
+std::atomic<PluginHost::IHostActionObserver*> PluginHost::ActionObserver(nullptr);
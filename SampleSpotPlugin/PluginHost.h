@@ -1,14 +1,33 @@
 #pragma once
 
+#include <atomic>
 #include "SpotPlugin.h"
+#include "Utilities.h"
 
 namespace PluginHost
 {
+    /// Summary:
+    ///     Receives every host action after it returns. See HostActionProfiler.
+    class IHostActionObserver
+    {
+    public:
+        virtual ~IHostActionObserver() {}
+        virtual void OnHostAction(SpotPluginApi::host_action_t action, const void *data, uint64_t elapsedTicks, bool succeeded) = 0;
+    };
+
     extern SpotPluginApi::host_action_func_t ActionFunc;
     extern uintptr_t pluginHandle;
+    extern std::atomic<IHostActionObserver*> ActionObserver;  // nullptr unless host actions are being measured
 
     inline bool DoAction(SpotPluginApi::host_action_t action, uintptr_t info, void *data)
     {
-        return ActionFunc(pluginHandle, action, info, data);
+        auto observer = ActionObserver.load(std::memory_order_acquire);
+        if (nullptr == observer)
+            return ActionFunc(pluginHandle, action, info, data);
+
+        auto start = performance_counter();
+        bool succeeded = ActionFunc(pluginHandle, action, info, data);
+        observer->OnHostAction(action, data, performance_counter() - start, succeeded);
+        return succeeded;
     }
 };
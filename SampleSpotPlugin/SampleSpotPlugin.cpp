@@ -46,10 +46,7 @@ void SPOTPLUGINAPI OnApplicationClosing(host_event_t hostEvent, uintptr_t args,
 
 void SPOTPLUGINAPI DispatchEvent(host_event_t hostEvent, uintptr_t args, uintptr_t userData)
 {
-    ostringstream logMessage;
-    logMessage << "Dispatching event: " << hostEvent << " with argument: " << args << endl;
-    auto str = logMessage.str();
-    OutputDebugStringA(str.c_str());
+    EventLog::Instance().WriteHostEvent(hostEvent, args);
     switch(hostEvent)
     {
     case HostEvent::ApplicationClosing:
@@ -64,10 +61,118 @@ void SPOTPLUGINAPI DispatchEvent(host_event_t hostEvent, uintptr_t args, uintptr
 }
 
 CallbackDispatcher dispatcher;
+VariableJournal journal;
+VariableWatcher watcher;
+
+// Writes the names of the variables the host did not accept to the debugger output
+void ReportFailedWrites(const vector<VariableValue>& failed)
+{
+    for (auto& value : failed)
+        OutputDebugStringA(string("Unable to set the variable ").append(value.Target->Name()).append("\n").c_str());
+}
+
+// Returns false if any of the values could not be read
+bool ReportFailedReads(const vector<VariableValue>& values)
+{
+    bool allValid = true;
+    for (auto& value : values)
+    {
+        if (value.IsValid())
+            continue;
+        OutputDebugStringA(string("Unable to get the variable ").append(value.Target->Name()).append("\n").c_str());
+        allValid = false;
+    }
+    return allValid;
+}
 
 void OnUnloadingPlugin()
 {
     OutputDebugString(_T("Plug-in is unloading\n"));
+    watcher.Stop();
+    ReportFailedWrites(VariableManager::StandardVars().DisableWriteBehind());
+    IdleScheduler::Instance().Stop();
+    // Marks the journal as closed cleanly, so it is not replayed on the next start
+    journal.Close();
+    VariableManager::StandardVars().DisableCaching();
+    // Unbind the host events, the host must not call into the library once it is unloaded.
+    // This also delivers the queued events and stops the dispatch threads of the host events.
+    HostEvents::Hub().Shutdown();
+    // Worker threads must be stopped before the library is unloaded
+    TaskScheduler::Instance().Shutdown();
+    // Includes the threads of event sources with EventDispatchMode::DedicatedThread
+    EventWorkerPool::ShutdownAll();
+    EventLog::Instance().Close();
+}
+
+string TempFolder()
+{
+    char tempPath[MAX_PATH];
+    auto length = GetTempPathA(MAX_PATH, tempPath);
+    return (length > 0 && length < MAX_PATH) ? string(tempPath, length) : string();
+}
+
+// Starts the event log in the temp folder. The records are echoed to the debugger output as well.
+void OpenEventLog()
+{
+    auto tempFolder = TempFolder();
+    if (!tempFolder.empty())
+        EventLog::Instance().Open(tempFolder + "SampleSpotPlugin.elog", 4 * 1024 * 1024, 4, true);
+}
+
+// Captures the changed variables into the journal on the first Idle event a second from now
+void CaptureVariableJournal()
+{
+    IdleScheduler::Instance().PostAfter("Variable journal", chrono::seconds(1), [] (const IdleBudget&) -> bool
+    {
+        if (!journal.IsOpen())
+            return false;
+        try
+        {
+            journal.Capture(VariableManager::StandardVars());
+        }
+        catch (runtime_error&)
+        {
+            OutputDebugString(_T("Unable to update the variable journal\n"));
+        }
+        // Runs again in a second instead of taking a slice of every tick
+        CaptureVariableJournal();
+        return false;
+    }, IdlePriority::Low);
+}
+
+// Journals the changed variables once a second from a low priority idle task. The values journaled by a session
+// that ended without closing the journal, e.g. a crash, are set again on the first Idle event.
+void StartVariableJournal()
+{
+    auto tempFolder = TempFolder();
+    if (tempFolder.empty())
+        return;
+    try
+    {
+        journal.Open(tempFolder + "SampleSpotPlugin.journal");
+    }
+    catch (runtime_error&)
+    {
+        OutputDebugString(_T("Unable to open the variable journal\n"));
+        return;
+    }
+
+    if (!journal.WasClean())
+    {
+        IdleScheduler::Instance().Post("Variable journal replay", [] (const IdleBudget&) -> bool
+        {
+            try
+            {
+                journal.Replay(VariableManager::StandardVars());
+            }
+            catch (runtime_error&)
+            {
+                OutputDebugString(_T("Unable to replay the variable journal\n"));
+            }
+            return false;
+        }, IdlePriority::Low);
+    }
+    CaptureVariableJournal();
 }
 
 /// Summary:
@@ -97,6 +202,28 @@ struct DummyFunc : public EventDelegate<read_string_event_t::arg_type>
     }
 };
 
+// Writes every new value of a watched variable to the event log
+template<typename T>
+void LogChanges(VariableWatch<T>& watch)
+{
+    auto nameId = EventLog::Instance().RegisterName(watch.Target().Name() + " changed");
+    std::function<void(VariableChange<T>)> onChange = [nameId] (VariableChange<T> change)
+    {
+        EventLog::Instance().Write(nameId, change.Value);
+    };
+    watch.AddDelegate(make_event_delegate(onChange));
+}
+
+// Host state that used to be polled and compared on every Idle event. The sensor temperature is read
+// at least every 2 seconds, the others at least every 10 seconds while they do not change.
+void WatchHostState()
+{
+    LogChanges(watcher.Watch(StdVar<StdVarId::CurSensorTemp>(), chrono::milliseconds(250), chrono::seconds(2)));
+    LogChanges(watcher.Watch(StdVar<StdVarId::LiveImgRunning>()));
+    LogChanges(watcher.Watch(StdVar<StdVarId::NumImgDocWindows>()));
+    watcher.Start();
+}
+
 void SetStandardEventHandlers()
 {
     add_logger_to_event( HostInterop::HostEvents::ApplicationClosing(), "Application closing");
@@ -129,6 +256,7 @@ bool SPOTPLUGINAPI SPOTPLUGIN_INIT_FUNC(host_action_func_t hostActionFunc, uintp
     // This following items must be initialized before anything else can be done. They are required for all plug-ins
     PluginHost::ActionFunc = hostActionFunc;
     PluginHost::pluginHandle = handle;
+    OpenEventLog();
 
 #ifdef USE_SIMPLE_FUNCTION_BASED_EXAMPLE
     // Set the callback function to handle requests from the host.
@@ -163,21 +291,99 @@ bool SPOTPLUGINAPI SPOTPLUGIN_INIT_FUNC(host_action_func_t hostActionFunc, uintp
     // This callback handles all callback requests
     *pluginCallbackFunc = CallbackDispatcher::master_callback_func;
     *userData = reinterpret_cast<uintptr_t>(&dispatcher);
+    dispatcher.SetUnloadAction(OnUnloadingPlugin);
     
     // assign actions to the associated action id.
     dispatcher.SetAction(1, []()
     {
-        if(!GetBoolVariable("LiveImgRunning"))
+        if(!StandardVariables::Instance().LiveImgRunning.Value())
             PluginHost::DoAction(HostActionRequest::StartLive, 0, nullptr);
     });
 
     dispatcher.SetAction(10, []()
     {
-        auto stdVars = VariableManager::StandardVars();
-        auto argT1 = stdVars.GetByName<TextVariable>("_argT1");
-        auto argT2 = stdVars.GetByName<TextVariable>("_argT2");
-        auto argN1 = stdVars.GetByName<IntegerVariable>("LiveImgCount");
-        stdVars.SetValue("_argT3", argT1.Value() + argT2.Value() + argN1.ToString());
+        auto& stdVars = VariableManager::StandardVars();
+        // Read all the arguments with one host call instead of one call per variable
+        IVariable* args[] = { &stdVars.GetByName("_argT1"), &stdVars.GetByName("_argT2"), &stdVars.GetByName("LiveImgCount") };
+        auto values = stdVars.Fetch(std::vector<IVariable*>(std::begin(args), std::end(args)));
+        if (!ReportFailedReads(values))
+            return;
+        stdVars.SetValue("_argT3", values[0].TextValue + values[1].TextValue + std::to_string(static_cast<int>(values[2].NumericValue)));
+    });
+
+    // Measuring every host call is off unless the plug-in is built with PROFILE_HOST_ACTIONS or action 15 turns it on.
+    // Action 11 writes the report into the text variable named by _argT1.
+#ifdef PROFILE_HOST_ACTIONS
+    HostActionProfiler::Enable(true);
+#endif
+    dispatcher.SetAction(11, []()
+    {
+        HostActionProfiler::Instance().ExportToVariable(StdVar<StdVarId::_argT1>().Value());
+    });
+
+    // Action 12 writes the mean sample value of the active image into _argN1 and its contrast into _argN2.
+    // The pixels are read in place.
+    dispatcher.SetAction(12, []()
+    {
+        auto lock = ImageLock::Acquire();
+        auto statistics = (lock.BitDepth() <= 8)
+            ? ImageStatistics::Compute(lock.View<uint8_t>(), lock.BitDepth())
+            : ImageStatistics::Compute(lock.View<uint16_t>(), lock.BitDepth());
+        lock.Release(); // let the host continue before talking to it again
+        StdVar<StdVarId::_argN1>().Value(statistics.Mean());
+        StdVar<StdVarId::_argN2>().Value(statistics.Contrast());
+    });
+
+    // Action 13 measures every frame of the active image sequence and writes "index,mean,contrast" lines into _argT1.
+    // Frames are measured on worker threads while the host thread reads the next frames.
+    dispatcher.SetAction(13, []()
+    {
+        string report;
+        SequenceProcessor<ImageStatistics> sequence(
+            [](const SequenceFrame& frame)
+            {
+                return (frame.BitDepth <= 8)
+                    ? ImageStatistics::Compute(frame.View<uint8_t>(), frame.BitDepth)
+                    : ImageStatistics::Compute(frame.View<uint16_t>(), frame.BitDepth);
+            },
+            [&report](const SequenceFrame& frame, ImageStatistics& statistics)
+            {
+                report.append(to_string(frame.Index)).append(",").append(to_string(statistics.Mean())).append(",").append(to_string(statistics.Contrast())).append("\n");
+            });
+        sequence.Run();
+        StdVar<StdVarId::_argT1>().Value(report);
+    });
+
+    // Action 14 writes "name=value" lines of all standard variables into _argT1. Each value is a host call,
+    // so the report is built a few variables at a time while the host is idle.
+    dispatcher.SetAction(14, []()
+    {
+        auto report = make_shared<string>();
+        IdleScheduler::Instance().PostLoop("Standard variable report", static_cast<size_t>(StdVarId::Count),
+            [report] (size_t i)
+            {
+                auto& variable = StandardVariables::Instance()[static_cast<StdVarId>(i)];
+                report->append(variable.Name()).append("=");
+                try
+                {
+                    report->append(variable.ToString());
+                }
+                catch (runtime_error&)
+                {
+                    report->append("?");
+                }
+                report->append("\n");
+            },
+            [report] ()
+            {
+                StdVar<StdVarId::_argT1>().Value(*report);
+            });
+    });
+
+    // Action 15 starts measuring host calls if _argB1 is true and stops if it is false. The counters are kept.
+    dispatcher.SetAction(15, []()
+    {
+        HostActionProfiler::Enable(StdVar<StdVarId::_argB1>().Value());
     });
 
     //===============================
@@ -198,16 +404,56 @@ bool SPOTPLUGINAPI SPOTPLUGIN_INIT_FUNC(host_action_func_t hostActionFunc, uintp
     // };
     // cameraEventSource->AddDelegate(make_event_delegate(testcode));
     // cameraEventSource->AddDelegate(make_shared<DummyFunc>());
+    //// slow delegates can be moved off the host thread on a source of their own. They must not call the host,
+    //// so the delegates above that set variables stay inline. Only the newest camera name is kept if they fall behind.
+    // auto cameraHistorySource = new read_string_event_t(HostEvent::CameraInitialized);
+    // auto cameraNameId = EventLog::Instance().RegisterName("Camera history");
+    // std::function<void(const char*)> recordCamera = [=](const char* val)
+    // {
+    //     EventLog::Instance().Write(cameraNameId, val);
+    // };
+    // cameraHistorySource->AddDelegate(make_event_delegate(recordCamera));
+    // cameraHistorySource->SetDispatchPolicy(EventDispatchPolicy(EventDispatchMode::WorkerPool, 1, QueueOverflowPolicy::CoalesceLatest));
 
+    //// live frames arrive once per frame instead of polling LiveImgCount on Idle. The pixels are read in place.
+    // auto centerSampleName = EventLog::Instance().RegisterName("Live frame center sample");
+    // std::function<void(LiveFrame)> onFrame = [=](LiveFrame frame)
+    // {
+    //     auto centerRow = frame.Row<uint8_t>(frame.Height() / 2);
+    //     EventLog::Instance().WriteInteger(centerSampleName, centerRow[frame.RowBytes() / 2]);
+    // };
+    // HostEvents::LiveFrameReady().AddDelegate(make_event_delegate(onFrame));
+
+    // The host events the handlers below need are bound with a single host action by ResumeBinding
+    HostEvents::Hub().SuspendBinding();
     SetStandardEventHandlers();
 
+    // Serve repeated reads of image, camera and application state variables from memory.
+    // The cached values are flushed by the ImageDocChanged, CameraInitialized and Idle events.
+    // Readings such as CurSensorTemp and LiveImgContrast are volatile and always read from the host.
+    VariableManager::StandardVars().EnableCaching();
+
+    // Handlers often set the same _arg and TextVar variables many times. Only the last value of each is sent
+    // to the host, with a single host action when the action code returns or on the next Idle event.
+    VariableManager::StandardVars().EnableWriteBehind();
+    dispatcher.SetCompletionAction([]()
+    {
+        ReportFailedWrites(VariableManager::StandardVars().Flush());
+    });
+
     std::function<void(HostEvents::application_closing_t::arg_type)> backupOnExit = [] (HostEvents::application_closing_t::arg_type)
     {
-        string path = VariableManager::StandardVars().GetByName<TextVariable>("PrefsFilePath").Value();
+        string path = StdVar<StdVarId::PrefsFilePath>().Value();
         VariableManager::StandardVars().SaveAll(path + "\\BackupVars");
     };
     HostEvents::ApplicationClosing().AddDelegate(make_event_delegate(backupOnExit));
 
+    // Deferred work runs in slices of at most 2 ms per Idle event
+    IdleScheduler::Instance().Start();
+    StartVariableJournal();
+    WatchHostState();
+    HostEvents::Hub().ResumeBinding();
+
 #endif // USE_SIMPLE_FUNCTION_BASED_EVENTS
 
     return true; // Tell the host that we want to load
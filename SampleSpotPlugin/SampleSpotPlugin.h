@@ -9,6 +9,14 @@
 #include "EventSourceTypes.h"
 #include "HostEvents.h"
 #include "CallbackDispatcher.h"
+#include "HostActionProfiler.h"
+#include "ImageView.h"
+#include "ImageStatistics.h"
+#include "TaskScheduler.h"
+#include "SequenceProcessor.h"
+#include "VariableJournal.h"
+#include "VariableWatcher.h"
+#include "IdleScheduler.h"
 
 void DoActionCode(int code);
 void OnIdleEvent();
@@ -0,0 +1,327 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "SpotPlugin.h"
+#include "PluginHost.h"
+#include "HostVariables.h"
+#include "ImageView.h"
+#include "TaskScheduler.h"
+
+namespace HostInterop
+{
+    /// Summary:
+    ///     A frame of an image sequence copied from the host, so it can be processed on any thread.
+    ///     Metadata holds the values of the metadata variables of the SequenceProcessor in the same order.
+    ///     Their Target pointers may be compared but the variables must not be read on a worker thread.
+    struct SequenceFrame
+    {
+        SequenceFrame() : Index(0), Width(0), Height(0), BitDepth(0), ChannelLayout(SpotPluginApi::ChannelLayout::Unknown)
+        {
+        }
+
+        uint32_t Index;                         // The zero based position in the sequence
+        uint32_t Width;
+        uint32_t Height;
+        uint32_t BitDepth;
+        SpotPluginApi::channel_layout_t ChannelLayout;
+        std::vector<uint8_t> Pixels;            // Top-down rows without padding
+        std::vector<VariableValue> Metadata;
+
+        size_t RowBytes() const
+        {
+            auto channels = channel_count(ChannelLayout);
+            return static_cast<size_t>(Width) * (channels ? channels : 1) * bytes_per_sample(BitDepth);
+        }
+
+        /// Summary:
+        ///     Returns a typed view of the pixels.
+        /// Throws:
+        ///     invalid_argument if T does not match the bit depth
+        template<typename T>
+        ImageView<const T> View() const
+        {
+            return make_image_view<const T>(static_cast<const void*>(Pixels.data()), Width, Height, static_cast<intptr_t>(RowBytes()), BitDepth, ChannelLayout);
+        }
+    };
+
+    struct SequenceStats
+    {
+        SequenceStats() : Fetched(0), Delivered(0), FetchMicroseconds(0), WaitMicroseconds(0)
+        { }
+
+        uint32_t Fetched;                       // Frames read from the host
+        uint32_t Delivered;                     // Results passed to the deliver function
+        uint64_t FetchMicroseconds;             // Time the host thread spent showing, reading and copying frames
+        uint64_t WaitMicroseconds;              // Time Run spent waiting for the oldest frame to be processed
+    };
+
+    /// Summary:
+    ///     Walks the frames of the active image sequence with a look-ahead window. The host thread shows
+    ///     each frame with HostActionRequest::ShowSequenceFrame, reads its metadata variables with a single
+    ///     bulk action and copies its pixels. The frame is then processed on the threads of a TaskScheduler
+    ///     while the host thread goes on to read the next frames, up to lookAhead frames in flight.
+    ///     The results are delivered on the host thread in sequence order.
+    ///     Run processes the sequence to the end. To keep the UI responsive call Start once and Step from
+    ///     HostEvents::Idle instead; Step never waits for a worker. The frame the host showed before Start
+    ///     is shown again when the sequence is done or cancelled.
+    /// Template Arguments:
+    ///     Result - The result of processing a frame. Must be default constructible.
+    template<typename Result>
+    class SequenceProcessor
+    {
+    public:
+        // Called on a worker thread. Must not call the host.
+        typedef std::function<Result(const SequenceFrame&)> process_func_t;
+
+        // Called on the host thread in sequence order. The result may be moved from.
+        typedef std::function<void(const SequenceFrame&, Result&)> deliver_func_t;
+
+    private:
+        typedef std::chrono::steady_clock clock_t;
+
+        struct Slot
+        {
+            Slot() : done(false) { }
+
+            SequenceFrame frame;
+            Result result;
+            std::exception_ptr error;
+            std::atomic<bool> done;             // Set by the worker after result or error
+        };
+
+        process_func_t process;
+        deliver_func_t deliver;
+        size_t lookAhead;
+        TaskScheduler* scheduler;
+        std::vector<IVariable*> metadata;
+        std::deque<std::shared_ptr<Slot>> inFlight;     // Oldest frame first
+        std::unique_ptr<TaskGroup> group;
+        uint32_t nextIndex;
+        uint32_t endIndex;
+        int shownIndex;                         // The frame shown before Start
+        bool running;
+        SequenceStats stats;
+
+        // no copies allowed. Queued tasks refer to this object
+        SequenceProcessor(const SequenceProcessor&);
+        SequenceProcessor& operator = (const SequenceProcessor&);
+
+        static uint64_t MicrosecondsSince(clock_t::time_point start)
+        {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(clock_t::now() - start).count());
+        }
+
+        // Showing a frame changes ImgSeqIdx and the image metadata variables, so their cached values are dropped
+        static bool ShowSequenceFrame(uint32_t index)
+        {
+            bool shown = PluginHost::DoAction(SpotPluginApi::HostActionRequest::ShowSequenceFrame, index, nullptr);
+            auto cache = VariableManager::StandardVars().Cache();
+            if (nullptr != cache)
+                cache->Invalidate(ScopeFlags::ImageMetaData);
+            return shown;
+        }
+
+        static void ShowFrame(uint32_t index)
+        {
+            if (!ShowSequenceFrame(index))
+                throw std::runtime_error(std::string("Unable to show frame ").append(std::to_string(index)).append(" of the image sequence"));
+        }
+
+        template<typename T>
+        static void CopyRows(const ImageView<const T>& view, uint8_t* destination, size_t rowBytes)
+        {
+            for (uint32_t y = 0; y < view.Height(); ++y)
+                memcpy(destination + y * rowBytes, view.Row(y), rowBytes);
+        }
+
+        std::shared_ptr<Slot> Fetch(uint32_t index)
+        {
+            auto start = clock_t::now();
+            std::shared_ptr<Slot> slot(new Slot());
+            auto& frame = slot->frame;
+            frame.Index = index;
+            ShowFrame(index);
+            if (!metadata.empty())
+                frame.Metadata = VariableManager::StandardVars().Fetch(metadata);
+            {
+                auto lock = ImageLock::Acquire();
+                frame.Width = lock.Width();
+                frame.Height = lock.Height();
+                frame.BitDepth = lock.BitDepth();
+                frame.ChannelLayout = lock.ChannelLayout();
+                auto rowBytes = frame.RowBytes();
+                frame.Pixels.resize(rowBytes * frame.Height);
+                if (frame.BitDepth <= 8)
+                    CopyRows(lock.View<uint8_t>(), frame.Pixels.data(), rowBytes);
+                else
+                    CopyRows(lock.View<uint16_t>(), frame.Pixels.data(), rowBytes);
+            }
+            ++stats.Fetched;
+            stats.FetchMicroseconds += MicrosecondsSince(start);
+            return slot;
+        }
+
+        void Submit(const std::shared_ptr<Slot>& slot)
+        {
+            inFlight.push_back(slot);
+            scheduler->Run(*group, [this, slot]
+            {
+                try
+                {
+                    slot->result = process(slot->frame);
+                }
+                catch (...)
+                {
+                    slot->error = std::current_exception();
+                }
+                slot->done = true;
+            });
+        }
+
+        void DeliverReady()
+        {
+            while (!inFlight.empty() && inFlight.front()->done)
+            {
+                auto slot = inFlight.front();
+                inFlight.pop_front();
+                if (slot->error)
+                {
+                    Cancel();
+                    std::rethrow_exception(slot->error);
+                }
+                ++stats.Delivered;
+                deliver(slot->frame, slot->result);
+            }
+        }
+
+        void Finish()
+        {
+            running = false;
+            group.reset();
+            if (shownIndex >= 0)
+                ShowSequenceFrame(static_cast<uint32_t>(shownIndex));
+        }
+
+    public:
+        /// Arguments:
+        ///     processFunc - Processes a frame on a worker thread
+        ///     deliverFunc - Receives the results on the host thread in sequence order
+        ///     lookAhead   - The most frames read ahead of the oldest frame that has not been delivered
+        ///     taskScheduler - The threads that process the frames
+        SequenceProcessor(process_func_t processFunc, deliver_func_t deliverFunc, size_t lookAhead = 4, TaskScheduler& taskScheduler = TaskScheduler::Instance()) :
+            process(processFunc), deliver(deliverFunc), lookAhead(std::max<size_t>(1, lookAhead)), scheduler(&taskScheduler),
+            nextIndex(0), endIndex(0), shownIndex(-1), running(false)
+        {
+        }
+
+        // Waits for the frames in flight without delivering them. Must be called on the host thread.
+        ~SequenceProcessor()
+        {
+            if (running)
+                Cancel();
+        }
+
+        // Variables read with every frame, usually variables with ScopeFlags::ImageMetaData
+        void SetMetadata(const std::vector<IVariable*>& variables) { metadata = variables; }
+
+        bool IsRunning() const { return running; }
+        const SequenceStats& Stats() const { return stats; }
+
+        // The number of frames read and not yet delivered
+        size_t FramesInFlight() const { return inFlight.size(); }
+
+        /// Summary:
+        ///     Starts processing count frames from index first, or the rest of the sequence. Call Step to process them.
+        /// Throws:
+        ///     logic_error if the processor is already running
+        void Start(uint32_t first = 0, uint32_t count = UINT32_MAX)
+        {
+            if (running)
+                throw std::logic_error("The image sequence is already being processed");
+            auto length = static_cast<uint32_t>(std::max<int>(0, StdVar<StdVarId::ImgSeqLen>().Value()));
+            shownIndex = StdVar<StdVarId::ImgSeqIdx>().Value();
+            nextIndex = std::min<uint32_t>(first, length);
+            endIndex = nextIndex + std::min<uint32_t>(count, length - nextIndex);
+            stats = SequenceStats();
+            group.reset(new TaskGroup(*scheduler));
+            running = true;
+        }
+
+        /// Summary:
+        ///     Delivers the processed frames that are next in order and reads frames until the look-ahead
+        ///     window is full. Does not wait for the workers.
+        /// Returns:
+        ///     false once all frames have been delivered
+        /// Throws:
+        ///     runtime_error if the host can not show or lend a frame. An exception thrown by the process
+        ///     function is passed on when its frame is next in order. Processing is cancelled in both cases.
+        bool Step()
+        {
+            if (!running)
+                return false;
+            DeliverReady();
+            try
+            {
+                while (inFlight.size() < lookAhead && nextIndex < endIndex)
+                    Submit(Fetch(nextIndex++));
+            }
+            catch (...)
+            {
+                Cancel();
+                throw;
+            }
+            if (inFlight.empty())
+                Finish();
+            return running;
+        }
+
+        /// Summary:
+        ///     Processes the frames and delivers all results before returning. While the oldest frame is
+        ///     being processed the host thread helps the workers. See Start and Step.
+        void Run(uint32_t first = 0, uint32_t count = UINT32_MAX)
+        {
+            Start(first, count);
+            while (Step())
+            {
+                auto start = clock_t::now();
+                while (!inFlight.front()->done)
+                {
+                    if (!scheduler->RunPendingTask())
+                        std::this_thread::yield();
+                }
+                stats.WaitMicroseconds += MicrosecondsSince(start);
+            }
+        }
+
+        // Stops reading frames, waits for the frames in flight and discards their results
+        void Cancel()
+        {
+            if (!running)
+                return;
+            endIndex = nextIndex;
+            group->Cancel();
+            try
+            {
+                scheduler->Wait(*group);
+            }
+            catch (...)
+            {
+                // The frames are discarded anyway
+            }
+            inFlight.clear();
+            Finish();
+        }
+    };
+}
@@ -10,6 +10,7 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <string.h>
 #include <string>
 
 namespace SpotPluginApi
@@ -30,13 +31,20 @@ namespace HostActionRequest
    const host_action_t   BindEventHandler         = 1;   // Use msg_event_handler_binding_t
    const host_action_t   UnbindEventHandler       = 2;   // Use msg_event_handler_binding_t
    const host_action_t   GetVariable              = 10;  // Use msg_get_set_variable_t
+   const host_action_t   GetVariables             = 11;  // Use msg_get_set_variable_list_t
+   const host_action_t   ResolveVariable          = 12;  // Use msg_get_set_variable_t (version 2 or later)
    const host_action_t   SetVariable              = 20;  // Use msg_get_set_variable_t
+   const host_action_t   SetVariables             = 21;  // Use msg_get_set_variable_list_t
    const host_action_t   SaveVariable             = 24;  // Use msg_save_recall_variable_t
    const host_action_t   RecallVariable           = 25;  // Use msg_save_recall_variable_t
    const host_action_t   AcqSingleImage           = 30;
    const host_action_t   StartLive                = 40;
    const host_action_t   PauseLive                = 41;
    const host_action_t   EndLive                  = 42;
+   const host_action_t   AcquireImageView         = 50;  // Use msg_image_view_t
+   const host_action_t   ReleaseImageView         = 51;  // Use msg_image_view_t
+   const host_action_t   ShowSequenceFrame        = 52;  // info is the zero based frame index. Shows that frame of the active image sequence,
+                                                          // ImgSeqIdx and the image metadata variables follow. Fails while an image view is held.
 }
 
 typedef uint32_t host_event_t;
@@ -46,6 +54,7 @@ namespace HostEvent
    const host_event_t  ApplicationClosing         = 1;  // The application is about to close 
    const host_event_t  ImageDocChanged            = 10; // A new image document has focus
    const host_event_t  CameraInitialized          = 11; 
+   const host_event_t  LiveFrameReady             = 12; // A live image frame was acquired. The args point to a live_frame_t.
 }
 
 
@@ -178,11 +187,39 @@ struct msg_event_handler_binding_t
 };
 
 
-struct msg_get_set_variable_t
+// Values of msg_get_set_variable_t::Version. A plug-in sets the version of the features it uses in a message.
+namespace GetSetVariableVersion
+{
+   const int32_t   Initial                        = 0;
+   // Reading a Text value reports the full length of the value in TextValue.Length, which may be larger than the
+   // supplied buffer. The host still writes no more than the original TextValue.Length characters plus a null terminator.
+   // If TextValue.Text is NULL nothing is written and only the length is reported.
+   // A list entry whose value did not fit gets a status of VariableStatus::Truncated.
+   const int32_t   TextLength                     = 1;
+   // Adds the Handle field. ResolveVariable sets Handle to an opaque non-zero value that identifies the variable
+   // named by VariableName and DialogName. A handle stays valid until the plug-in is unloaded.
+   // Get/Set messages with a non-zero Handle are served without looking up the variable by name.
+   // The elements of a list have no Handle field, see GetSetVariableListVersion::HandleList.
+   // Includes the features of all earlier versions.
+   const int32_t   Handle                         = 2;
+}
+
+// Values of msg_get_set_variable_list_t::Version.
+namespace GetSetVariableListVersion
+{
+   const int32_t   Initial                        = 0;
+   // Adds the HandleList field. An element uses its handle only if its own Version is GetSetVariableVersion::Handle or later.
+   // Hosts without this version ignore the field and look up every element by name.
+   const int32_t   HandleList                     = 1;
+}
+
+// The fields of a variable shared by msg_get_set_variable_t and the elements of msg_get_set_variable_list_t.
+// Its layout must not change, because hosts of every version step through VariableList with its size.
+struct msg_get_set_variable_entry_t
 {
    enum VariableType { Unknown = 0, Text =  1, Numeric = 2, Bool = 4 };
 
-   msg_get_set_variable_t() :
+   msg_get_set_variable_entry_t() :
       Version(0),
       Reserved(0),
       VariableName(NULL),
@@ -207,6 +244,52 @@ struct msg_get_set_variable_t
    };
 };
 
+struct msg_get_set_variable_t : public msg_get_set_variable_entry_t
+{
+   msg_get_set_variable_t() :
+      Handle(0)
+   {  }
+
+   uintptr_t Handle;            // Version 2 or later: the handle returned by ResolveVariable or zero to look up the variable by name
+};
+
+
+typedef uint32_t variable_status_t;
+namespace VariableStatus
+{
+   const variable_status_t   Ok                   = 0;  // The value was read or written
+   const variable_status_t   Failed               = 1;  // The entry was not processed or failed for an unspecified reason
+   const variable_status_t   NotFound             = 2;  // No variable with the name exists
+   const variable_status_t   TypeMismatch         = 3;  // The DataType does not match the type of the variable
+   const variable_status_t   ReadOnly             = 4;  // The variable can not be written
+   const variable_status_t   Truncated            = 5;  // The text value did not fit in the supplied buffer
+}
+
+// Transfers many variables in a single host action (GetVariables or SetVariables).
+// Each element of VariableList is handled exactly as a single GetVariable/SetVariable message would be
+// and the outcome is written to the element with the same index in StatusList.
+// The host returns false only if it could not process the list at all (e.g. an older host without bulk support),
+// in which case the plug-in should fall back to one message per variable.
+// The elements carry no handle, the handles of a list are passed in the parallel HandleList instead.
+struct msg_get_set_variable_list_t
+{
+   msg_get_set_variable_list_t() :
+      Version(0),
+      Reserved(0),
+      VariableListLength(0),
+      VariableList(NULL),
+      StatusList(NULL),
+      HandleList(NULL)
+   {  }
+
+   int32_t                       Version;             // Read only
+   uint32_t                      Reserved;
+   size_t                        VariableListLength;  // The number of elements in the following arrays
+   msg_get_set_variable_entry_t  *VariableList;       // The variables to get or set
+   variable_status_t             *StatusList;         // Set by the host to a VariableStatus value for each element of VariableList
+   const uintptr_t               *HandleList;         // Version 1 or later: NULL or the handle of each element of VariableList, zero to look it up by name
+};
+
 
 struct msg_save_recall_variable_t
 {
@@ -225,6 +308,92 @@ struct msg_save_recall_variable_t
    const char *FilePath;
 };
 
+typedef uint32_t channel_layout_t;
+namespace ChannelLayout
+{
+   const channel_layout_t   Unknown              = 0;
+   const channel_layout_t   Mono                 = 1;  // One channel per pixel
+   const channel_layout_t   RGB                  = 2;  // Three interleaved channels per pixel in red, green, blue order
+   const channel_layout_t   BGR                  = 3;  // Three interleaved channels per pixel in blue, green, red order
+   const channel_layout_t   RGBA                 = 4;  // Four interleaved channels per pixel, the last channel is alpha or unused
+   const channel_layout_t   BGRA                 = 5;  // Four interleaved channels per pixel, the last channel is alpha or unused
+   const channel_layout_t   Bayer                = 6;  // One raw sensor sample per pixel of a color filter array
+}
+
+// Values of live_frame_t::Version. The host sets the version of the fields it filled in.
+namespace LiveFrameVersion
+{
+   const int32_t   Initial                        = 0;
+}
+
+// The event args of HostEvent::LiveFrameReady point to this descriptor.
+// The descriptor and the pixels it points to are owned by the host and are only valid until the event handler returns.
+// Samples are stored in 8 bits if BitDepth is 8 or less, otherwise in 16 bits.
+struct live_frame_t
+{
+   live_frame_t() :
+      Version(0),
+      Reserved(0),
+      Pixels(NULL),
+      Width(0),
+      Height(0),
+      Stride(0),
+      BitDepth(0),
+      ChannelLayout(ChannelLayout::Unknown),
+      FrameIndex(0),
+      Timestamp(0)
+   {  }
+
+   int32_t           Version;       // Read only
+   uint32_t          Reserved;
+   const void        *Pixels;       // The first pixel of the top row
+   uint32_t          Width;         // In pixels
+   uint32_t          Height;        // In pixels
+   intptr_t          Stride;        // The distance in bytes from the start of one row to the start of the next. Negative for bottom-up images.
+   uint32_t          BitDepth;      // Significant bits per channel sample
+   channel_layout_t  ChannelLayout;
+   uint64_t          FrameIndex;    // Zero based count of the frames acquired since live mode was started
+   uint64_t          Timestamp;     // Acquisition time in microseconds since live mode was started
+};
+
+typedef uint32_t image_view_access_t;
+namespace ImageViewAccess
+{
+   const image_view_access_t   Read             = 1;  // The pixels may only be read. Any number of read views can be held at once.
+   const image_view_access_t   ReadWrite        = 3;  // The pixels may be changed. No other view of the document can be held at the same time.
+}
+
+// Borrows the pixel buffer of the image document that has focus (see HostEvent::ImageDocChanged).
+// AcquireImageView fills in the buffer fields and Token. The host keeps the buffer in place and does not
+// change it, close the document or switch focus away from it until ReleaseImageView is sent with the same Token.
+// Views are acquired and released on the host thread, the pixels may be accessed from any thread in between.
+// The host returns false from AcquireImageView if no image document has focus or the access conflicts with a view
+// that is already held. Changes made through a ReadWrite view are shown when the view is released.
+struct msg_image_view_t
+{
+   msg_image_view_t() :
+      Version(0),
+      Access(ImageViewAccess::Read),
+      Token(0),
+      Pixels(NULL),
+      Width(0),
+      Height(0),
+      Stride(0),
+      BitDepth(0),
+      ChannelLayout(ChannelLayout::Unknown)
+   {  }
+
+   int32_t              Version;       // Read only
+   image_view_access_t  Access;        // Set by the plug-in
+   uintptr_t            Token;         // Set by AcquireImageView and passed back to ReleaseImageView
+   void                 *Pixels;       // The first pixel of the top row
+   uint32_t             Width;         // In pixels
+   uint32_t             Height;        // In pixels
+   intptr_t             Stride;        // The distance in bytes from the start of one row to the start of the next
+   uint32_t             BitDepth;      // Significant bits per channel sample. Samples use 8 bits up to a depth of 8, otherwise 16 bits.
+   channel_layout_t     ChannelLayout;
+};
+
 #pragma pack(pop) // restore original packing
 
 } // end namespace SpotPluginApi
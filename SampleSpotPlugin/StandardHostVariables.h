@@ -1,160 +1,271 @@
 #pragma once
 
-namespace internal
-{
-    // 
-    struct var_script_item_t  {bool readonly; const char* szName; VariableType type; ScopeFlags scope; };
-
-    var_script_item_t std_vars_build_script[] = {
-        {false, "TextVar1",                     VariableType::Text,     ScopeFlags::Unknown},   
-        {false, "TextVar2",                     VariableType::Text,     ScopeFlags::Unknown},   
-        {false, "TextVar3",                     VariableType::Text,     ScopeFlags::Unknown},   
-        {false, "TextVar4",                     VariableType::Text,     ScopeFlags::Unknown},   
-        {false, "TextVar5",                     VariableType::Text,     ScopeFlags::Unknown},   
-        {false, "_argT1",                       VariableType::Text,     ScopeFlags::Unknown},   
-        {false, "_argT2",                       VariableType::Text,     ScopeFlags::Unknown},   
-        {false, "_argT3",                       VariableType::Text,     ScopeFlags::Unknown},   
-        {false, "_argT4",                       VariableType::Text,     ScopeFlags::Unknown},   
-        {false, "_argT5",                       VariableType::Text,     ScopeFlags::Unknown},   
-        {false, "NumVar1",                      VariableType::Numeric,  ScopeFlags::Unknown},   
-        {false, "NumVar2",                      VariableType::Numeric,  ScopeFlags::Unknown},   
-        {false, "NumVar3",                      VariableType::Numeric,  ScopeFlags::Unknown},   
-        {false, "NumVar4",                      VariableType::Numeric,  ScopeFlags::Unknown},   
-        {false, "NumVar5",                      VariableType::Numeric,  ScopeFlags::Unknown},   
-        {false, "_argN1",                       VariableType::Numeric,  ScopeFlags::Unknown},   
-        {false, "_argN2",                       VariableType::Numeric,  ScopeFlags::Unknown},   
-        {false, "_argN3",                       VariableType::Numeric,  ScopeFlags::Unknown},   
-        {false, "_argN4",                       VariableType::Numeric,  ScopeFlags::Unknown},   
-        {false, "_argN5",                       VariableType::Numeric,  ScopeFlags::Unknown},   
-        {false, "BoolVar1",                     VariableType::Bool,     ScopeFlags::Unknown},   
-        {false, "BoolVar2",                     VariableType::Bool,     ScopeFlags::Unknown},   
-        {false, "BoolVar3",                     VariableType::Bool,     ScopeFlags::Unknown},   
-        {false, "BoolVar4",                     VariableType::Bool,     ScopeFlags::Unknown},   
-        {false, "BoolVar5",                     VariableType::Bool,     ScopeFlags::Unknown},   
-        {false, "_argB1",                       VariableType::Bool,     ScopeFlags::Unknown},   
-        {false, "_argB2",                       VariableType::Bool,     ScopeFlags::Unknown},   
-        {false, "_argB3",                       VariableType::Bool,     ScopeFlags::Unknown},   
-        {false, "_argB4",                       VariableType::Bool,     ScopeFlags::Unknown},   
-        {false, "_argB5",                       VariableType::Bool,     ScopeFlags::Unknown},   
-      //{false, "Timestamp1",                   VariableType::_TS,      ScopeFlags::Unknown},
-      //{false, "Timestamp2",                   VariableType::_TS,      ScopeFlags::Unknown},
-      //{false, "Timestamp3",                   VariableType::_TS,      ScopeFlags::Unknown},
-      //{false, "Timestamp4",                   VariableType::_TS,      ScopeFlags::Unknown},
-      //{false, "Timestamp5",                   VariableType::_TS,      ScopeFlags::Unknown},
-        {true,  "CameraSerialNum",              VariableType::Text,     ScopeFlags::CameraSetting},
-        {true,  "CameraName",                   VariableType::Text,     ScopeFlags::CameraSetting},  
-        {true,  "CurUserName",                  VariableType::Text,     ScopeFlags::UserSetting},     
-        {true,  "CurSensorTemp",                VariableType::Numeric,  ScopeFlags::CameraSetting},   
-        {true,  "CurImgSetupName",              VariableType::Text,     ScopeFlags::CameraSetting},   
-        {true,  "ImgUserName",                  VariableType::Text,     ScopeFlags::ImageMetaData},   
-        {true,  "ImgTitle",                     VariableType::Text,     ScopeFlags::ImageMetaData|ScopeFlags::FilePath},
-        {true,  "ImgMemo",                      VariableType::Text,     ScopeFlags::ImageMetaData},
-        {true,  "DBRecID",                      VariableType::Integer,  ScopeFlags::ImageMetaData},
-        {true,  "ImgSeqLen",                    VariableType::Integer,  ScopeFlags::ImageMetaData},
-        {true,  "ImgSeqIdx",                    VariableType::Integer,  ScopeFlags::ImageMetaData},
-        {true,  "ImgElapsedTime",               VariableType::Text,     ScopeFlags::ImageMetaData},
-        {true,  "ImgSetupName",                 VariableType::Text,     ScopeFlags::ImageMetaData},
-        {true,  "ImgSensorTemp",                VariableType::Numeric,  ScopeFlags::ImageMetaData},
-        {true,  "MacroLoopNum",                 VariableType::Integer,  ScopeFlags::Unknown},
-        {true,  "MacroCmdCanceled",             VariableType::Bool,     ScopeFlags::Unknown},
-        {true,  "MacroCmdFailed",               VariableType::Bool,     ScopeFlags::Unknown},
-      //{true,  "ImgDate",                      VariableType::_DATE ,   ScopeFlags::Unknown},
-      //{true,  "ImgTime",                      VariableType::_TIME ,   ScopeFlags::Unknown},
-      //{true,  "RptDate",                      VariableType::_DATE ,   ScopeFlags::Unknown},
-      //{true,  "RptTime",                      VariableType::_TIME ,   ScopeFlags::Unknown},
-      //{true,  "ImgTimestamp",                 VariableType::_TS,      ScopeFlags::Unknown|ScopeFlags::ImageMetaData},
-        {true,  "RptPageNum",                   VariableType::Integer,  ScopeFlags::Reporting}, 
-        {true,  "RptPageCount",                 VariableType::Integer,  ScopeFlags::Reporting},
-        {true,  "RptRecNum",                    VariableType::Integer,  ScopeFlags::Reporting}, 
-        {true,  "RptRecCount",                  VariableType::Integer,  ScopeFlags::Reporting},
-        {true,  "RunTimeText",                  VariableType::Text,     ScopeFlags::Reporting},
-        {true,  "MinExposure",                  VariableType::Numeric,  ScopeFlags::CameraSetting},
-        {true,  "MaxExposure",                  VariableType::Numeric,  ScopeFlags::CameraSetting},
-        {true,  "LiveImgOpen",                  VariableType::Bool,     ScopeFlags::ApplicationState},
-        {true,  "LiveImgRunning",               VariableType::Bool,     ScopeFlags::ApplicationState},
-        {true,  "LiveImgCount",                 VariableType::Integer,  ScopeFlags::ApplicationState},
-        {true,  "LiveImgContrast",              VariableType::Numeric,  ScopeFlags::ImageMetaData},
-        {true,  "OperationMode",                VariableType::Text,     ScopeFlags::ApplicationState},
-        {true,  "ImgMeasWidth",                 VariableType::Numeric,  ScopeFlags::Measurment|ScopeFlags::ApplicationState},
-        {true,  "ImgMeasLength",                VariableType::Numeric,  ScopeFlags::Measurment|ScopeFlags::ApplicationState},
-        {true,  "ImgMeasArea",                  VariableType::Numeric,  ScopeFlags::ImageMetaData|ScopeFlags::Measurment},
-        {true,  "ImgMeasPerimeter",             VariableType::Numeric,  ScopeFlags::ImageMetaData|ScopeFlags::Measurment},
-        {true,  "ImgMeasAngle",                 VariableType::Numeric,  ScopeFlags::ImageMetaData|ScopeFlags::Measurment},
-        {true,  "ImgMeasRadius",                VariableType::Numeric,  ScopeFlags::ImageMetaData|ScopeFlags::Measurment},
-        {true,  "ImgMeasDiameter",              VariableType::Numeric,  ScopeFlags::ImageMetaData|ScopeFlags::Measurment},
-        {true,  "ImgMeasCircumference",         VariableType::Numeric,  ScopeFlags::ImageMetaData|ScopeFlags::Measurment},
-        {true,  "ImgMeasMajorAxis",             VariableType::Numeric,  ScopeFlags::ImageMetaData|ScopeFlags::Measurment},
-        {true,  "ImgMeasMinorAxis",             VariableType::Numeric,  ScopeFlags::ImageMetaData|ScopeFlags::Measurment},
-        {true,  "PICSLinkDataTransferDir",      VariableType::Text,     ScopeFlags::ApplicationState|ScopeFlags::FilePath},
-      //{true,  "TwainMode",                    VariableType::Bool,     ScopeFlags::ApplicationState},
-        {true,  "NumDocWindows",                VariableType::Integer,  ScopeFlags::ApplicationState},
-        {true,  "NumImgDocWindows",             VariableType::Integer,  ScopeFlags::ApplicationState},
-        {true,  "NumImgSeqDocWindows",          VariableType::Integer,  ScopeFlags::ApplicationState},
-        {true,  "NumThumbnailDocWindows",       VariableType::Integer,  ScopeFlags::ApplicationState},
-        {true,  "NumRptTemplateDocWindows",     VariableType::Integer,  ScopeFlags::ApplicationState},
-        {true,  "NumDlgDesignDocWindows",       VariableType::Integer,  ScopeFlags::ApplicationState},
-        {true,  "DocWindowType",                VariableType::Integer,  ScopeFlags::ApplicationState},
-        {true,  "DocWindowMode",                VariableType::Integer,  ScopeFlags::ApplicationState},
-        {true,  "DocNewOrModified",             VariableType::Bool,     ScopeFlags::ApplicationState},
-        {true,  "PrefsFilePath",                VariableType::Text,     ScopeFlags::ApplicationState|ScopeFlags::FilePath},
-        {true,  "UserDesktopPath",              VariableType::Text,     ScopeFlags::ApplicationState|ScopeFlags::FilePath},
-        {true,  "CommonDesktopPath",            VariableType::Text,     ScopeFlags::ApplicationState|ScopeFlags::FilePath},
-        {true,  "OpenImgFilePath",              VariableType::Text,     ScopeFlags::ApplicationState|ScopeFlags::FilePath},
-        {true,  "SaveImgFilePath",              VariableType::Text,     ScopeFlags::ApplicationState|ScopeFlags::FilePath},
-        {true,  "OpenImgSeqFilePath",           VariableType::Text,     ScopeFlags::ApplicationState|ScopeFlags::FilePath},
-        {true,  "SaveImgSeqFilePath",           VariableType::Text,     ScopeFlags::ApplicationState|ScopeFlags::FilePath},
-        {true,  "OpenRptFilePath",              VariableType::Text,     ScopeFlags::ApplicationState|ScopeFlags::FilePath},
-        {true,  "SaveRptFilePath",              VariableType::Text,     ScopeFlags::ApplicationState|ScopeFlags::FilePath},
-        {true,  "MacroFilePath",                VariableType::Text,     ScopeFlags::ApplicationState|ScopeFlags::FilePath},
-        {true,  "MovieExportFilePath",          VariableType::Text,     ScopeFlags::ApplicationState|ScopeFlags::FilePath},
-        {true,  "BaseMacroFilePath",            VariableType::Text,     ScopeFlags::ApplicationState|ScopeFlags::FilePath},
-        {true,  "BaseDialogFilePath",           VariableType::Text,     ScopeFlags::ApplicationState|ScopeFlags::FilePath},
-        {true,  "BaseRptFilePath",              VariableType::Text,     ScopeFlags::ApplicationState|ScopeFlags::FilePath},
-        {true,  "BaseObjImgFilePath",           VariableType::Text,     ScopeFlags::ApplicationState|ScopeFlags::FilePath},
-        {true,  "AppVisible",                   VariableType::Bool,     ScopeFlags::ApplicationState},
-        {true,  "AppActive",                    VariableType::Bool,     ScopeFlags::ApplicationState},
-        {false, "CalMarkOrientation",           VariableType::Numeric,  ScopeFlags::UserSetting},
-        {false, "CalMarkColor",                 VariableType::Numeric,  ScopeFlags::UserSetting},
-        {false, "CalMarkLineThickness",         VariableType::Numeric,  ScopeFlags::UserSetting},
-        {false, "CalMarkLineEndLength",         VariableType::Numeric,  ScopeFlags::UserSetting},
-        {false, "CalMarkShowText",              VariableType::Bool,     ScopeFlags::UserSetting},
-        {false, "CalMarkTextFontName",          VariableType::Text,     ScopeFlags::UserSetting},
-        {false, "CalMarkTextFontSize",          VariableType::Numeric,  ScopeFlags::UserSetting},
-        {false, "CalMarkTextRotation",          VariableType::Numeric,  ScopeFlags::UserSetting},
-        {false, "CalMarkDecimals",              VariableType::Numeric,  ScopeFlags::UserSetting},
-        {false, "MeasurementColor",             VariableType::Numeric,  ScopeFlags::UserSetting},
-        {false, "MeasurementLineThickness",     VariableType::Numeric,  ScopeFlags::UserSetting},
-        {false, "MeasurementTextFontName",      VariableType::Text,     ScopeFlags::UserSetting},
-        {false, "MeasurementTextFontSize",      VariableType::Numeric,  ScopeFlags::UserSetting},
-        {false, "MeasurementTextRotation",      VariableType::Numeric,  ScopeFlags::UserSetting},
-        {false, "MeasurementDecimals",          VariableType::Integer,  ScopeFlags::UserSetting},
-        {false, "MeasurementShowCircleArea",    VariableType::Bool,     ScopeFlags::UserSetting},
-        {false, "MeasurementShowCircleRadius",  VariableType::Bool,     ScopeFlags::UserSetting},
-        {false, "MeasurementShowCircleDiameter",VariableType::Bool,     ScopeFlags::UserSetting},
-        {false, "MeasurementShowCircleCircum",  VariableType::Bool,     ScopeFlags::UserSetting},
-        {false, "MeasurementShowRectArea",      VariableType::Bool,     ScopeFlags::UserSetting},
-        {false, "MeasurementShowRectLength",    VariableType::Bool,     ScopeFlags::UserSetting},
-        {false, "MeasurementShowRectWidth",     VariableType::Bool,     ScopeFlags::UserSetting},
-        {false, "MeasurementShowRectPerim",     VariableType::Bool,     ScopeFlags::UserSetting},
-        {false, "MeasurementShowEllipseArea",   VariableType::Bool,     ScopeFlags::UserSetting},
-        {false, "MeasurementShowEllipseMajAxis",VariableType::Bool,     ScopeFlags::UserSetting},
-        {false, "MeasurementShowEllipseMinAxis",VariableType::Bool,     ScopeFlags::UserSetting},
-        {false, "MeasurementShowEllipsePerim",  VariableType::Bool,     ScopeFlags::UserSetting},
-        {false, "MeasurementShowRegionArea",    VariableType::Bool,     ScopeFlags::UserSetting},
-        {false, "MeasurementShowRegionPerim",   VariableType::Bool,     ScopeFlags::UserSetting},
-        {false, "AnnotLineBorderThickness",     VariableType::Numeric,  ScopeFlags::UserSetting},
-        {false, "AnnotTextLineColor",           VariableType::Numeric,  ScopeFlags::UserSetting},
-        {false, "AnnotBkgdFillColor",           VariableType::Numeric,  ScopeFlags::UserSetting},
-        {false, "AnnotTextFontName",            VariableType::Text,     ScopeFlags::UserSetting},
-        {false, "AnnotTextFontSize",            VariableType::Numeric,  ScopeFlags::UserSetting},
-        {false, "AnnotTextRotation",            VariableType::Numeric,  ScopeFlags::UserSetting},
-        {false, "AnnotTextJustification",       VariableType::Numeric,  ScopeFlags::UserSetting},
-        {false, "AnnotTextBackgroundMode",      VariableType::Numeric,  ScopeFlags::UserSetting},
-        {false, "AnnotFillObject",              VariableType::Bool,     ScopeFlags::UserSetting},
-        {false, "AnnotArrowHeadSize",           VariableType::Numeric,  ScopeFlags::UserSetting},
-        {false, "MagnifierWindowWidth",         VariableType::Numeric,  ScopeFlags::UserSetting},
-        {false, "MagnifierWindowHeight",        VariableType::Numeric,  ScopeFlags::UserSetting},
-        {false, "MagnifierMagnificationFactor", VariableType::Numeric,  ScopeFlags::UserSetting}
+// This file is included by HostVariables.h inside the HostInterop namespace after the variable classes are defined.
+
+/// Summary:
+///     The standard variables of the host application as an X-macro list.
+///     SPOT_STD_VAR(readonly, name, varType, scope) is expanded once per variable where
+///         readonly - true if the plug-in can not change the value
+///         name     - the name of the variable (a C++ identifier)
+///         varType  - Bool, Text, Numeric or Integer; selects the <varType>Variable class
+///         scope    - the ScopeFlags of the variable
+#define SPOT_STANDARD_VARIABLES(SPOT_STD_VAR) \
+       SPOT_STD_VAR(false, TextVar1,                      Text,    ScopeFlags::Unknown)                                 \
+       SPOT_STD_VAR(false, TextVar2,                      Text,    ScopeFlags::Unknown)                                 \
+       SPOT_STD_VAR(false, TextVar3,                      Text,    ScopeFlags::Unknown)                                 \
+       SPOT_STD_VAR(false, TextVar4,                      Text,    ScopeFlags::Unknown)                                 \
+       SPOT_STD_VAR(false, TextVar5,                      Text,    ScopeFlags::Unknown)                                 \
+       SPOT_STD_VAR(false, _argT1,                        Text,    ScopeFlags::Unknown)                                 \
+       SPOT_STD_VAR(false, _argT2,                        Text,    ScopeFlags::Unknown)                                 \
+       SPOT_STD_VAR(false, _argT3,                        Text,    ScopeFlags::Unknown)                                 \
+       SPOT_STD_VAR(false, _argT4,                        Text,    ScopeFlags::Unknown)                                 \
+       SPOT_STD_VAR(false, _argT5,                        Text,    ScopeFlags::Unknown)                                 \
+       SPOT_STD_VAR(false, NumVar1,                       Numeric, ScopeFlags::Unknown)                                 \
+       SPOT_STD_VAR(false, NumVar2,                       Numeric, ScopeFlags::Unknown)                                 \
+       SPOT_STD_VAR(false, NumVar3,                       Numeric, ScopeFlags::Unknown)                                 \
+       SPOT_STD_VAR(false, NumVar4,                       Numeric, ScopeFlags::Unknown)                                 \
+       SPOT_STD_VAR(false, NumVar5,                       Numeric, ScopeFlags::Unknown)                                 \
+       SPOT_STD_VAR(false, _argN1,                        Numeric, ScopeFlags::Unknown)                                 \
+       SPOT_STD_VAR(false, _argN2,                        Numeric, ScopeFlags::Unknown)                                 \
+       SPOT_STD_VAR(false, _argN3,                        Numeric, ScopeFlags::Unknown)                                 \
+       SPOT_STD_VAR(false, _argN4,                        Numeric, ScopeFlags::Unknown)                                 \
+       SPOT_STD_VAR(false, _argN5,                        Numeric, ScopeFlags::Unknown)                                 \
+       SPOT_STD_VAR(false, BoolVar1,                      Bool,    ScopeFlags::Unknown)                                 \
+       SPOT_STD_VAR(false, BoolVar2,                      Bool,    ScopeFlags::Unknown)                                 \
+       SPOT_STD_VAR(false, BoolVar3,                      Bool,    ScopeFlags::Unknown)                                 \
+       SPOT_STD_VAR(false, BoolVar4,                      Bool,    ScopeFlags::Unknown)                                 \
+       SPOT_STD_VAR(false, BoolVar5,                      Bool,    ScopeFlags::Unknown)                                 \
+       SPOT_STD_VAR(false, _argB1,                        Bool,    ScopeFlags::Unknown)                                 \
+       SPOT_STD_VAR(false, _argB2,                        Bool,    ScopeFlags::Unknown)                                 \
+       SPOT_STD_VAR(false, _argB3,                        Bool,    ScopeFlags::Unknown)                                 \
+       SPOT_STD_VAR(false, _argB4,                        Bool,    ScopeFlags::Unknown)                                 \
+       SPOT_STD_VAR(false, _argB5,                        Bool,    ScopeFlags::Unknown)                                 \
+    /* SPOT_STD_VAR(false, Timestamp1,                    _TS,     ScopeFlags::Unknown) */                              \
+    /* SPOT_STD_VAR(false, Timestamp2,                    _TS,     ScopeFlags::Unknown) */                              \
+    /* SPOT_STD_VAR(false, Timestamp3,                    _TS,     ScopeFlags::Unknown) */                              \
+    /* SPOT_STD_VAR(false, Timestamp4,                    _TS,     ScopeFlags::Unknown) */                              \
+    /* SPOT_STD_VAR(false, Timestamp5,                    _TS,     ScopeFlags::Unknown) */                              \
+       SPOT_STD_VAR(true,  CameraSerialNum,               Text,    ScopeFlags::CameraSetting)                           \
+       SPOT_STD_VAR(true,  CameraName,                    Text,    ScopeFlags::CameraSetting)                           \
+       SPOT_STD_VAR(true,  CurUserName,                   Text,    ScopeFlags::UserSetting)                             \
+       SPOT_STD_VAR(true,  CurSensorTemp,                 Numeric, ScopeFlags::CameraSetting)                           \
+       SPOT_STD_VAR(true,  CurImgSetupName,               Text,    ScopeFlags::CameraSetting)                           \
+       SPOT_STD_VAR(true,  ImgUserName,                   Text,    ScopeFlags::ImageMetaData)                           \
+       SPOT_STD_VAR(true,  ImgTitle,                      Text,    ScopeFlags::ImageMetaData|ScopeFlags::FilePath)      \
+       SPOT_STD_VAR(true,  ImgMemo,                       Text,    ScopeFlags::ImageMetaData)                           \
+       SPOT_STD_VAR(true,  DBRecID,                       Integer, ScopeFlags::ImageMetaData)                           \
+       SPOT_STD_VAR(true,  ImgSeqLen,                     Integer, ScopeFlags::ImageMetaData)                           \
+       SPOT_STD_VAR(true,  ImgSeqIdx,                     Integer, ScopeFlags::ImageMetaData)                           \
+       SPOT_STD_VAR(true,  ImgElapsedTime,                Text,    ScopeFlags::ImageMetaData)                           \
+       SPOT_STD_VAR(true,  ImgSetupName,                  Text,    ScopeFlags::ImageMetaData)                           \
+       SPOT_STD_VAR(true,  ImgSensorTemp,                 Numeric, ScopeFlags::ImageMetaData)                           \
+       SPOT_STD_VAR(true,  MacroLoopNum,                  Integer, ScopeFlags::Unknown)                                 \
+       SPOT_STD_VAR(true,  MacroCmdCanceled,              Bool,    ScopeFlags::Unknown)                                 \
+       SPOT_STD_VAR(true,  MacroCmdFailed,                Bool,    ScopeFlags::Unknown)                                 \
+    /* SPOT_STD_VAR(true,  ImgTimestamp,                  _TS,     ScopeFlags::Unknown|ScopeFlags::ImageMetaData) */    \
+       SPOT_STD_VAR(true,  RptPageNum,                    Integer, ScopeFlags::Reporting)                               \
+       SPOT_STD_VAR(true,  RptPageCount,                  Integer, ScopeFlags::Reporting)                               \
+       SPOT_STD_VAR(true,  RptRecNum,                     Integer, ScopeFlags::Reporting)                               \
+       SPOT_STD_VAR(true,  RptRecCount,                   Integer, ScopeFlags::Reporting)                               \
+       SPOT_STD_VAR(true,  RunTimeText,                   Text,    ScopeFlags::Reporting)                               \
+       SPOT_STD_VAR(true,  MinExposure,                   Numeric, ScopeFlags::CameraSetting)                           \
+       SPOT_STD_VAR(true,  MaxExposure,                   Numeric, ScopeFlags::CameraSetting)                           \
+       SPOT_STD_VAR(true,  LiveImgOpen,                   Bool,    ScopeFlags::ApplicationState)                        \
+       SPOT_STD_VAR(true,  LiveImgRunning,                Bool,    ScopeFlags::ApplicationState)                        \
+       SPOT_STD_VAR(true,  LiveImgCount,                  Integer, ScopeFlags::ApplicationState)                        \
+       SPOT_STD_VAR(true,  LiveImgContrast,               Numeric, ScopeFlags::ImageMetaData)                           \
+       SPOT_STD_VAR(true,  OperationMode,                 Text,    ScopeFlags::ApplicationState)                        \
+       SPOT_STD_VAR(true,  ImgMeasWidth,                  Numeric, ScopeFlags::Measurment|ScopeFlags::ApplicationState) \
+       SPOT_STD_VAR(true,  ImgMeasLength,                 Numeric, ScopeFlags::Measurment|ScopeFlags::ApplicationState) \
+       SPOT_STD_VAR(true,  ImgMeasArea,                   Numeric, ScopeFlags::ImageMetaData|ScopeFlags::Measurment)    \
+       SPOT_STD_VAR(true,  ImgMeasPerimeter,              Numeric, ScopeFlags::ImageMetaData|ScopeFlags::Measurment)    \
+       SPOT_STD_VAR(true,  ImgMeasAngle,                  Numeric, ScopeFlags::ImageMetaData|ScopeFlags::Measurment)    \
+       SPOT_STD_VAR(true,  ImgMeasRadius,                 Numeric, ScopeFlags::ImageMetaData|ScopeFlags::Measurment)    \
+       SPOT_STD_VAR(true,  ImgMeasDiameter,               Numeric, ScopeFlags::ImageMetaData|ScopeFlags::Measurment)    \
+       SPOT_STD_VAR(true,  ImgMeasCircumference,          Numeric, ScopeFlags::ImageMetaData|ScopeFlags::Measurment)    \
+       SPOT_STD_VAR(true,  ImgMeasMajorAxis,              Numeric, ScopeFlags::ImageMetaData|ScopeFlags::Measurment)    \
+       SPOT_STD_VAR(true,  ImgMeasMinorAxis,              Numeric, ScopeFlags::ImageMetaData|ScopeFlags::Measurment)    \
+       SPOT_STD_VAR(true,  PICSLinkDataTransferDir,       Text,    ScopeFlags::ApplicationState|ScopeFlags::FilePath)   \
+    /* SPOT_STD_VAR(true,  TwainMode,                     Bool,    ScopeFlags::ApplicationState) */                     \
+       SPOT_STD_VAR(true,  NumDocWindows,                 Integer, ScopeFlags::ApplicationState)                        \
+       SPOT_STD_VAR(true,  NumImgDocWindows,              Integer, ScopeFlags::ApplicationState)                        \
+       SPOT_STD_VAR(true,  NumImgSeqDocWindows,           Integer, ScopeFlags::ApplicationState)                        \
+       SPOT_STD_VAR(true,  NumThumbnailDocWindows,        Integer, ScopeFlags::ApplicationState)                        \
+       SPOT_STD_VAR(true,  NumRptTemplateDocWindows,      Integer, ScopeFlags::ApplicationState)                        \
+       SPOT_STD_VAR(true,  NumDlgDesignDocWindows,        Integer, ScopeFlags::ApplicationState)                        \
+       SPOT_STD_VAR(true,  DocWindowType,                 Integer, ScopeFlags::ApplicationState)                        \
+       SPOT_STD_VAR(true,  DocWindowMode,                 Integer, ScopeFlags::ApplicationState)                        \
+       SPOT_STD_VAR(true,  DocNewOrModified,              Bool,    ScopeFlags::ApplicationState)                        \
+       SPOT_STD_VAR(true,  PrefsFilePath,                 Text,    ScopeFlags::ApplicationState|ScopeFlags::FilePath)   \
+       SPOT_STD_VAR(true,  UserDesktopPath,               Text,    ScopeFlags::ApplicationState|ScopeFlags::FilePath)   \
+       SPOT_STD_VAR(true,  CommonDesktopPath,             Text,    ScopeFlags::ApplicationState|ScopeFlags::FilePath)   \
+       SPOT_STD_VAR(true,  OpenImgFilePath,               Text,    ScopeFlags::ApplicationState|ScopeFlags::FilePath)   \
+       SPOT_STD_VAR(true,  SaveImgFilePath,               Text,    ScopeFlags::ApplicationState|ScopeFlags::FilePath)   \
+       SPOT_STD_VAR(true,  OpenImgSeqFilePath,            Text,    ScopeFlags::ApplicationState|ScopeFlags::FilePath)   \
+       SPOT_STD_VAR(true,  SaveImgSeqFilePath,            Text,    ScopeFlags::ApplicationState|ScopeFlags::FilePath)   \
+       SPOT_STD_VAR(true,  OpenRptFilePath,               Text,    ScopeFlags::ApplicationState|ScopeFlags::FilePath)   \
+       SPOT_STD_VAR(true,  SaveRptFilePath,               Text,    ScopeFlags::ApplicationState|ScopeFlags::FilePath)   \
+       SPOT_STD_VAR(true,  MacroFilePath,                 Text,    ScopeFlags::ApplicationState|ScopeFlags::FilePath)   \
+       SPOT_STD_VAR(true,  MovieExportFilePath,           Text,    ScopeFlags::ApplicationState|ScopeFlags::FilePath)   \
+       SPOT_STD_VAR(true,  BaseMacroFilePath,             Text,    ScopeFlags::ApplicationState|ScopeFlags::FilePath)   \
+       SPOT_STD_VAR(true,  BaseDialogFilePath,            Text,    ScopeFlags::ApplicationState|ScopeFlags::FilePath)   \
+       SPOT_STD_VAR(true,  BaseRptFilePath,               Text,    ScopeFlags::ApplicationState|ScopeFlags::FilePath)   \
+       SPOT_STD_VAR(true,  BaseObjImgFilePath,            Text,    ScopeFlags::ApplicationState|ScopeFlags::FilePath)   \
+       SPOT_STD_VAR(true,  AppVisible,                    Bool,    ScopeFlags::ApplicationState)                        \
+       SPOT_STD_VAR(true,  AppActive,                     Bool,    ScopeFlags::ApplicationState)                        \
+       SPOT_STD_VAR(false, CalMarkOrientation,            Numeric, ScopeFlags::UserSetting)                             \
+       SPOT_STD_VAR(false, CalMarkColor,                  Numeric, ScopeFlags::UserSetting)                             \
+       SPOT_STD_VAR(false, CalMarkLineThickness,          Numeric, ScopeFlags::UserSetting)                             \
+       SPOT_STD_VAR(false, CalMarkLineEndLength,          Numeric, ScopeFlags::UserSetting)                             \
+       SPOT_STD_VAR(false, CalMarkShowText,               Bool,    ScopeFlags::UserSetting)                             \
+       SPOT_STD_VAR(false, CalMarkTextFontName,           Text,    ScopeFlags::UserSetting)                             \
+       SPOT_STD_VAR(false, CalMarkTextFontSize,           Numeric, ScopeFlags::UserSetting)                             \
+       SPOT_STD_VAR(false, CalMarkTextRotation,           Numeric, ScopeFlags::UserSetting)                             \
+       SPOT_STD_VAR(false, CalMarkDecimals,               Numeric, ScopeFlags::UserSetting)                             \
+       SPOT_STD_VAR(false, MeasurementColor,              Numeric, ScopeFlags::UserSetting)                             \
+       SPOT_STD_VAR(false, MeasurementLineThickness,      Numeric, ScopeFlags::UserSetting)                             \
+       SPOT_STD_VAR(false, MeasurementTextFontName,       Text,    ScopeFlags::UserSetting)                             \
+       SPOT_STD_VAR(false, MeasurementTextFontSize,       Numeric, ScopeFlags::UserSetting)                             \
+       SPOT_STD_VAR(false, MeasurementTextRotation,       Numeric, ScopeFlags::UserSetting)                             \
+       SPOT_STD_VAR(false, MeasurementDecimals,           Integer, ScopeFlags::UserSetting)                             \
+       SPOT_STD_VAR(false, MeasurementShowCircleArea,     Bool,    ScopeFlags::UserSetting)                             \
+       SPOT_STD_VAR(false, MeasurementShowCircleRadius,   Bool,    ScopeFlags::UserSetting)                             \
+       SPOT_STD_VAR(false, MeasurementShowCircleDiameter, Bool,    ScopeFlags::UserSetting)                             \
+       SPOT_STD_VAR(false, MeasurementShowCircleCircum,   Bool,    ScopeFlags::UserSetting)                             \
+       SPOT_STD_VAR(false, MeasurementShowRectArea,       Bool,    ScopeFlags::UserSetting)                             \
+       SPOT_STD_VAR(false, MeasurementShowRectLength,     Bool,    ScopeFlags::UserSetting)                             \
+       SPOT_STD_VAR(false, MeasurementShowRectWidth,      Bool,    ScopeFlags::UserSetting)                             \
+       SPOT_STD_VAR(false, MeasurementShowRectPerim,      Bool,    ScopeFlags::UserSetting)                             \
+       SPOT_STD_VAR(false, MeasurementShowEllipseArea,    Bool,    ScopeFlags::UserSetting)                             \
+       SPOT_STD_VAR(false, MeasurementShowEllipseMajAxis, Bool,    ScopeFlags::UserSetting)                             \
+       SPOT_STD_VAR(false, MeasurementShowEllipseMinAxis, Bool,    ScopeFlags::UserSetting)                             \
+       SPOT_STD_VAR(false, MeasurementShowEllipsePerim,   Bool,    ScopeFlags::UserSetting)                             \
+       SPOT_STD_VAR(false, MeasurementShowRegionArea,     Bool,    ScopeFlags::UserSetting)                             \
+       SPOT_STD_VAR(false, MeasurementShowRegionPerim,    Bool,    ScopeFlags::UserSetting)                             \
+       SPOT_STD_VAR(false, AnnotLineBorderThickness,      Numeric, ScopeFlags::UserSetting)                             \
+       SPOT_STD_VAR(false, AnnotTextLineColor,            Numeric, ScopeFlags::UserSetting)                             \
+       SPOT_STD_VAR(false, AnnotBkgdFillColor,            Numeric, ScopeFlags::UserSetting)                             \
+       SPOT_STD_VAR(false, AnnotTextFontName,             Text,    ScopeFlags::UserSetting)                             \
+       SPOT_STD_VAR(false, AnnotTextFontSize,             Numeric, ScopeFlags::UserSetting)                             \
+       SPOT_STD_VAR(false, AnnotTextRotation,             Numeric, ScopeFlags::UserSetting)                             \
+       SPOT_STD_VAR(false, AnnotTextJustification,        Numeric, ScopeFlags::UserSetting)                             \
+       SPOT_STD_VAR(false, AnnotTextBackgroundMode,       Numeric, ScopeFlags::UserSetting)                             \
+       SPOT_STD_VAR(false, AnnotFillObject,               Bool,    ScopeFlags::UserSetting)                             \
+       SPOT_STD_VAR(false, AnnotArrowHeadSize,            Numeric, ScopeFlags::UserSetting)                             \
+       SPOT_STD_VAR(false, MagnifierWindowWidth,          Numeric, ScopeFlags::UserSetting)                             \
+       SPOT_STD_VAR(false, MagnifierWindowHeight,         Numeric, ScopeFlags::UserSetting)                             \
+       SPOT_STD_VAR(false, MagnifierMagnificationFactor,  Numeric, ScopeFlags::UserSetting)
+
+
+    /// Summary:
+    ///     Compile time identifiers of the standard variables. See StdVar().
+    enum class StdVarId
+    {
+#define SPOT_STD_VAR(readonly, name, varType, scope) name,
+        SPOT_STANDARD_VARIABLES(SPOT_STD_VAR)
+#undef SPOT_STD_VAR
+        Count
+    };
+
+    /// Summary:
+    ///     All standard variables of the host application as typed members of a single object.
+    ///     The variables are constructed once in static storage and accessed without any lookup,
+    ///     e.g. StandardVariables::Instance().LiveImgCount.Value()
+    ///     Use VariableManager::StandardVars() to look them up by name instead.
+    class StandardVariables
+    {
+        struct NameEntry
+        {
+            const char* varName;
+            StdVarId id;
+
+            bool operator<(const NameEntry& rhs) const { return strcmp(varName, rhs.varName) < 0; }
+        };
+
+        IVariable* variables[static_cast<size_t>(StdVarId::Count)];
+        NameEntry byName[static_cast<size_t>(StdVarId::Count)];   // sorted by name
+
+    public:
+        typedef IVariable* const* const_iterator;
+
+        static StandardVariables& Instance()
+        {
+            static StandardVariables instance;
+            return instance;
+        }
+
+#define SPOT_STD_VAR(readonly, name, varType, scope) varType##Variable name;
+        SPOT_STANDARD_VARIABLES(SPOT_STD_VAR)
+#undef SPOT_STD_VAR
+
+        IVariable& operator[](StdVarId id) const { return *variables[static_cast<size_t>(id)]; }
+
+        const_iterator begin() const { return variables; }
+        const_iterator end() const { return variables + static_cast<size_t>(StdVarId::Count); }
+        size_t size() const { return static_cast<size_t>(StdVarId::Count); }
+
+        /// Summary:
+        ///     Finds a standard variable by name with a binary search over a fixed table. Does not allocate memory.
+        /// Returns:
+        ///     true and the id of the variable in id if name is the name of a standard variable
+        bool Find(const char* name, StdVarId& id) const
+        {
+            NameEntry key = { name, StdVarId::Count };
+            auto end = byName + static_cast<size_t>(StdVarId::Count);
+            auto entry = std::lower_bound(byName, end, key);
+            if (end == entry || 0 != strcmp(entry->varName, name))
+                return false;
+            id = entry->id;
+            return true;
+        }
+
+    private:
+        // Private constructor because this is a singleton object. Use Instance() function for access to the object.
+        StandardVariables() :
+            variables(), byName()
+#define SPOT_STD_VAR(readonly, name, varType, scope) , name(#name, scope, readonly)
+            SPOT_STANDARD_VARIABLES(SPOT_STD_VAR)
+#undef SPOT_STD_VAR
+        {
+#define SPOT_STD_VAR(readonly, name, varType, scope) \
+            variables[static_cast<size_t>(StdVarId::name)] = &name; \
+            byName[static_cast<size_t>(StdVarId::name)].varName = #name; \
+            byName[static_cast<size_t>(StdVarId::name)].id = StdVarId::name;
+            SPOT_STANDARD_VARIABLES(SPOT_STD_VAR)
+#undef SPOT_STD_VAR
+            std::sort(byName, byName + static_cast<size_t>(StdVarId::Count));
+            // Readings that change all the time. No event flushes their scopes when they do.
+            CurSensorTemp.SetVolatile(true);
+            LiveImgCount.SetVolatile(true);
+            LiveImgContrast.SetVolatile(true);
+        }
+
+        // no copies allowed
+        StandardVariables(const StandardVariables&);
+        StandardVariables& operator = (const StandardVariables&);
+    };
+
+    /// Summary:
+    ///     Compile time properties of a standard variable.
+    ///         type - The variable class (BoolVariable, TextVariable, NumericVariable or IntegerVariable)
+    ///         Get  - Returns the variable object from StandardVariables
+    template<StdVarId Id>
+    struct std_var_traits;
+
+#define SPOT_STD_VAR(readonly, name, varType, scope) \
+    template<> struct std_var_traits<StdVarId::name> \
+    { \
+        typedef varType##Variable type; \
+        static type& Get(StandardVariables& vars) { return vars.name; } \
     };
+    SPOT_STANDARD_VARIABLES(SPOT_STD_VAR)
+#undef SPOT_STD_VAR
 
-} // end namespace internal
\ No newline at end of file
+    /// Summary:
+    ///     Returns a standard variable with its concrete type resolved at compile time.
+    ///     e.g. int count = StdVar<StdVarId::LiveImgCount>().Value();
+    template<StdVarId Id>
+    typename std_var_traits<Id>::type& StdVar()
+    {
+        return std_var_traits<Id>::Get(StandardVariables::Instance());
+    }
@@ -0,0 +1,442 @@
+#pragma once
+
+#include <stdint.h>
+#include <cmath>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include <exception>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "ImageView.h"
+
+class TaskScheduler;
+
+/// Summary:
+///     A set of tasks started with TaskScheduler::Run that can be waited for together.
+///     The destructor waits for the tasks that are still running, so a group can never be
+///     destroyed while one of its tasks refers to it.
+class TaskGroup
+{
+    friend class TaskScheduler;
+
+    TaskScheduler* scheduler;
+    std::atomic<size_t> pending;        // Tasks started and not yet finished
+    std::atomic<bool> cancelled;
+    std::mutex lock;                    // Guards error
+    std::exception_ptr error;           // The first exception thrown by a task
+
+    // no copies allowed. Queued tasks refer to this object
+    TaskGroup(const TaskGroup&);
+    TaskGroup& operator = (const TaskGroup&);
+
+    void Fail(std::exception_ptr exception)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (!error)
+            error = exception;
+        cancelled = true;
+    }
+
+public:
+    // A group of tasks of TaskScheduler::Instance()
+    TaskGroup();
+
+    explicit TaskGroup(TaskScheduler& scheduler) : scheduler(&scheduler), pending(0), cancelled(false)
+    {
+    }
+
+    ~TaskGroup();
+
+    TaskScheduler& Scheduler() const { return *scheduler; }
+
+    bool IsDone() const { return 0 == pending.load(); }
+
+    // Asks tasks that check IsCancelled() to skip their work. Set as well when a task throws.
+    void Cancel() { cancelled = true; }
+    bool IsCancelled() const { return cancelled.load(); }
+};
+
+/// Summary:
+///     A work-stealing task scheduler for data parallel work such as processing an image in tiles.
+///     Each worker thread has its own queue of tasks. It runs its newest task first and takes the oldest
+///     tasks from the queues of the other workers when its own queue is empty, so tasks that split their
+///     work into more tasks spread over the threads without a shared queue. A thread that waits for a
+///     group runs queued tasks instead of blocking, so tasks may start and wait for nested groups.
+///     The threads are started by the first Run call, never while the host loads the plug-in.
+///     Shutdown must be called before the plug-in library is unloaded because threads cannot be joined
+///     while the loader lock is held. After Shutdown tasks run on the calling thread.
+class TaskScheduler
+{
+    struct Task
+    {
+        Task() : group(nullptr) { }
+        Task(TaskGroup* group, std::function<void()>&& function) : group(group), function(std::move(function)) { }
+
+        TaskGroup* group;
+        std::function<void()> function;
+    };
+
+    struct Worker
+    {
+        std::thread thread;
+        std::thread::id id;
+        std::mutex lock;                // Guards tasks
+        std::deque<Task> tasks;         // The owner works at the back, other threads steal from the front
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;   // Not changed after the workers have been started
+    std::deque<Task> injected;                      // Tasks started by threads that are not workers, guarded by lock
+    std::mutex lock;
+    std::condition_variable workAvailable;
+    std::atomic<size_t> queuedTasks;                // Tasks in all queues, so idle workers can sleep without missing one
+    std::atomic<size_t> sleepingWorkers;
+    std::atomic<bool> started;
+    std::atomic<bool> stopping;
+    size_t workerCount;
+
+    // no copies allowed. The threads refer to this object
+    TaskScheduler(const TaskScheduler&);
+    TaskScheduler& operator = (const TaskScheduler&);
+
+    void Start()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (started || stopping)
+            return;
+        for (size_t i = 0; i < workerCount; ++i)
+            workers.push_back(std::unique_ptr<Worker>(new Worker()));
+        for (auto& worker : workers)
+        {
+            worker->thread = std::thread(&TaskScheduler::WorkerMain, this, worker.get());
+            worker->id = worker->thread.get_id();
+        }
+        started = true;
+    }
+
+    // The worker running on the calling thread or nullptr
+    Worker* CurrentWorker() const
+    {
+        if (!started)
+            return nullptr;
+        auto id = std::this_thread::get_id();
+        for (auto& worker : workers)
+        {
+            if (worker->id == id)
+                return worker.get();
+        }
+        return nullptr;
+    }
+
+    // Takes the newest task of the own queue, else the oldest injected task, else the oldest task of another worker
+    bool FindTask(Worker* self, Task& task)
+    {
+        if (0 == queuedTasks)
+            return false;
+        if (self)
+        {
+            std::lock_guard<std::mutex> guard(self->lock);
+            if (!self->tasks.empty())
+            {
+                task = std::move(self->tasks.back());
+                self->tasks.pop_back();
+                --queuedTasks;
+                return true;
+            }
+        }
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (!injected.empty())
+            {
+                task = std::move(injected.front());
+                injected.pop_front();
+                --queuedTasks;
+                return true;
+            }
+        }
+        if (!started)
+            return false;
+        // Start with the worker after this one so thieves do not all go for the same queue
+        size_t first = self ? static_cast<size_t>(std::find_if(workers.begin(), workers.end(), [self] (const std::unique_ptr<Worker>& worker) { return worker.get() == self; }) - workers.begin()) + 1 : 0;
+        for (size_t i = 0; i < workers.size(); ++i)
+        {
+            auto victim = workers[(first + i) % workers.size()].get();
+            if (victim == self)
+                continue;
+            std::lock_guard<std::mutex> guard(victim->lock);
+            if (!victim->tasks.empty())
+            {
+                task = std::move(victim->tasks.front());
+                victim->tasks.pop_front();
+                --queuedTasks;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static void Execute(Task& task)
+    {
+        auto group = task.group;
+        try
+        {
+            task.function();
+        }
+        catch (...)
+        {
+            group->Fail(std::current_exception());
+        }
+        // The group may be destroyed as soon as its last task is counted off, so release the captures first
+        task.function = nullptr;
+        --group->pending;
+    }
+
+    void WorkerMain(Worker* self)
+    {
+        {
+            // Wait until Start has published the worker list
+            std::lock_guard<std::mutex> guard(lock);
+        }
+        while (!stopping)
+        {
+            Task task;
+            if (FindTask(self, task))
+            {
+                Execute(task);
+                continue;
+            }
+            std::unique_lock<std::mutex> guard(lock);
+            ++sleepingWorkers;
+            workAvailable.wait(guard, [this] { return stopping || queuedTasks > 0; });
+            --sleepingWorkers;
+        }
+    }
+
+public:
+    // Uses workerCount threads in addition to the threads that wait for groups. Zero runs every task inline.
+    explicit TaskScheduler(size_t workerCount) :
+        queuedTasks(0), sleepingWorkers(0), started(false), stopping(false), workerCount(workerCount)
+    {
+    }
+
+    ~TaskScheduler()
+    {
+        Shutdown();
+    }
+
+    /// Summary:
+    ///     The scheduler of the plug-in. It has a worker for every hardware thread but one, because the
+    ///     thread waiting for the tasks (usually the host thread) runs tasks as well.
+    static TaskScheduler& Instance()
+    {
+        static TaskScheduler instance(std::max<unsigned>(1, std::thread::hardware_concurrency()) - 1);
+        return instance;
+    }
+
+    size_t WorkerCount() const { return workerCount; }
+
+    // true once Shutdown has been called. Long running tasks should check this and finish early.
+    bool IsStopping() const { return stopping.load(); }
+
+    /// Summary:
+    ///     Starts a task of a group. The task runs on the calling thread right away if the scheduler has
+    ///     no workers or has been shut down. Exceptions thrown by the task are passed on by Wait.
+    void Run(TaskGroup& group, std::function<void()> function)
+    {
+        ++group.pending;
+        Task task(&group, std::move(function));
+        if (stopping || 0 == workerCount)
+        {
+            Execute(task);
+            return;
+        }
+        if (!started)
+            Start();
+
+        auto self = CurrentWorker();
+        if (self)
+        {
+            std::lock_guard<std::mutex> guard(self->lock);
+            self->tasks.push_back(std::move(task));
+        }
+        else
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            injected.push_back(std::move(task));
+        }
+        ++queuedTasks;
+        if (sleepingWorkers > 0)
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            workAvailable.notify_one();
+        }
+    }
+
+    /// Summary:
+    ///     Runs queued tasks on the calling thread until all tasks of the group have finished.
+    /// Throws:
+    ///     The first exception thrown by a task of the group. It is only thrown once.
+    void Wait(TaskGroup& group)
+    {
+        auto self = CurrentWorker();
+        while (!group.IsDone())
+        {
+            Task task;
+            if (FindTask(self, task))
+                Execute(task);
+            else
+                std::this_thread::yield();
+        }
+
+        std::exception_ptr error;
+        {
+            std::lock_guard<std::mutex> guard(group.lock);
+            std::swap(error, group.error);
+        }
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+    /// Summary:
+    ///     Runs one queued task on the calling thread, e.g. while waiting for a result that is not tracked by a group.
+    /// Returns:
+    ///     false if no task was queued
+    bool RunPendingTask()
+    {
+        Task task;
+        if (!FindTask(CurrentWorker(), task))
+            return false;
+        Execute(task);
+        return true;
+    }
+
+    // Lets the running tasks finish, stops the threads and runs the tasks still queued on the calling thread.
+    // Later tasks run on the thread that starts them.
+    void Shutdown()
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+            workAvailable.notify_all();
+        }
+        for (auto& worker : workers)
+        {
+            if (worker->thread.joinable())
+                worker->thread.join();
+        }
+        Task task;
+        while (FindTask(nullptr, task))
+            Execute(task);
+    }
+};
+
+inline TaskGroup::TaskGroup() : scheduler(&TaskScheduler::Instance()), pending(0), cancelled(false)
+{
+}
+
+inline TaskGroup::~TaskGroup()
+{
+    try
+    {
+        scheduler->Wait(*this);
+    }
+    catch (...)
+    {
+        // Errors are only reported by an explicit Wait
+    }
+}
+
+namespace HostInterop
+{
+    // The edge length of square tiles of about 64 KB, which fit the level 2 cache together with their results
+    template<typename T>
+    uint32_t cache_sized_tile(const ImageView<T>& view)
+    {
+        const size_t tileBytes = 64 * 1024;
+        auto pixelBytes = static_cast<size_t>(view.Channels()) * sizeof(T);
+        auto edge = static_cast<uint32_t>(std::sqrt(static_cast<double>(tileBytes / pixelBytes)));
+        // Whole cache lines per tile row
+        return std::max<uint32_t>(16, edge & ~15u);
+    }
+
+namespace internal // implementation specific namespace not for general usage
+{
+    template<typename T, typename Function>
+    struct _TileLoop
+    {
+        const ImageView<T>* view;
+        Function* function;
+        TaskGroup* group;
+        std::atomic<bool>* skipped;
+        uint32_t tileSize;
+        uint32_t tilesAcross;
+
+        // Splits the range of tiles in halves, leaving one half to other threads, until a single tile is left
+        void Run(uint32_t first, uint32_t last) const
+        {
+            while (last - first > 1)
+            {
+                uint32_t middle = first + (last - first) / 2;
+                _TileLoop right(*this);
+                group->Scheduler().Run(*group, [right, middle, last] { right.Run(middle, last); });
+                last = middle;
+            }
+            if (group->IsCancelled() || group->Scheduler().IsStopping())
+            {
+                *skipped = true;
+                return;
+            }
+            uint32_t x = (first % tilesAcross) * tileSize;
+            uint32_t y = (first / tilesAcross) * tileSize;
+            (*function)(view->SubView(x, y, std::min<uint32_t>(tileSize, view->Width() - x), std::min<uint32_t>(tileSize, view->Height() - y)), x, y);
+        }
+    };
+} // end namespace internal
+
+    /// Summary:
+    ///     Calls function(tile, x, y) for square tiles of a view on the threads of a TaskScheduler and
+    ///     returns when all tiles are done. tile is the SubView at pixel (x, y). Tiles at the right and
+    ///     bottom edges are smaller. The function is called concurrently, so it must only write to its own
+    ///     tile or synchronize, e.g. by accumulating into a result per tile.
+    /// Arguments:
+    ///     scheduler - The scheduler to run the tiles on, TaskScheduler::Instance() if not given
+    ///     view      - The pixels, which must stay valid until the call returns
+    ///     tileSize  - The edge length of a tile in pixels. Zero picks cache_sized_tile(view).
+    /// Returns:
+    ///     false if tiles were skipped because the scheduler is shutting down
+    /// Throws:
+    ///     The first exception thrown by the function. The tiles not started yet are skipped.
+    template<typename T, typename Function>
+    bool parallel_for_tiles(TaskScheduler& scheduler, const ImageView<T>& view, uint32_t tileSize, Function function)
+    {
+        if (view.IsEmpty())
+            return true;
+        if (0 == tileSize)
+            tileSize = cache_sized_tile(view);
+
+        TaskGroup group(scheduler);
+        std::atomic<bool> skipped(false);
+        internal::_TileLoop<T, Function> loop;
+        loop.view = &view;
+        loop.function = &function;
+        loop.group = &group;
+        loop.skipped = &skipped;
+        loop.tileSize = tileSize;
+        loop.tilesAcross = (view.Width() + tileSize - 1) / tileSize;
+        uint32_t tilesDown = (view.Height() + tileSize - 1) / tileSize;
+
+        scheduler.Run(group, [&loop, tilesDown] { loop.Run(0, loop.tilesAcross * tilesDown); });
+        scheduler.Wait(group);
+        return !skipped;
+    }
+
+    template<typename T, typename Function>
+    bool parallel_for_tiles(const ImageView<T>& view, uint32_t tileSize, Function function)
+    {
+        return parallel_for_tiles(TaskScheduler::Instance(), view, tileSize, function);
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string.h>
+#include <string>
+#include <algorithm>
+
+/// Summary:
+///     A read only view of characters owned by someone else, such as a string the host passes with an event.
+///     Nothing is copied or allocated, so a view is only valid as long as the characters it refers to.
+///     A null pointer gives an empty view. The characters are not necessarily followed by a zero.
+class TextView
+{
+    const char* data;
+    size_t length;
+
+public:
+    TextView() : data(""), length(0)
+    {
+    }
+
+    TextView(const char* text) : data(text ? text : ""), length(text ? strlen(text) : 0)
+    {
+    }
+
+    TextView(const char* text, size_t textLength) : data(text ? text : ""), length(text ? textLength : 0)
+    {
+    }
+
+    TextView(const std::string& text) : data(text.data()), length(text.size())
+    {
+    }
+
+    const char* Data() const { return data; }
+    size_t Size() const { return length; }
+    bool Empty() const { return 0 == length; }
+
+    const char* begin() const { return data; }
+    const char* end() const { return data + length; }
+
+    char operator[](size_t position) const { return data[position]; }
+
+    // The characters from position on, at most count of them
+    TextView Substring(size_t position, size_t count = std::string::npos) const
+    {
+        position = std::min<size_t>(position, length);
+        return TextView(data + position, std::min<size_t>(count, length - position));
+    }
+
+    // Copies the characters into a string that owns them
+    std::string ToString() const { return std::string(data, length); }
+
+    bool operator == (const TextView& other) const
+    {
+        return length == other.length && 0 == memcmp(data, other.data, length);
+    }
+
+    bool operator != (const TextView& other) const
+    {
+        return !(*this == other);
+    }
+};
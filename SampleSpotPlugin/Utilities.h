@@ -1,5 +1,14 @@
 #pragma once
 #include <cmath>
+#include <stdint.h>
+#if defined(_MSC_VER)
+#  include <intrin.h>
+#endif
+#if defined(_WIN32)
+#  include <windows.h>
+#else
+#  include <chrono>
+#endif
 
 /// Summary
 ///   Rounds floating point numbers to nearest integer, where ties round away from zero
@@ -23,3 +32,61 @@ FloatType round_to_nearest_awayzero(FloatType value )
       ceil( value - static_cast<FloatType>(0.5) ) :
       floor( value + static_cast<FloatType>(0.5) );
 }
+
+
+/// Summary
+///   Returns the number of bits that are set in a 64 bit value.
+inline unsigned count_set_bits(uint64_t value)
+{
+#if defined(__GNUC__)
+   return static_cast<unsigned>(__builtin_popcountll(value));
+#else
+   value = value - ((value >> 1) & 0x5555555555555555ull);
+   value = (value & 0x3333333333333333ull) + ((value >> 2) & 0x3333333333333333ull);
+   value = (value + (value >> 4)) & 0x0f0f0f0f0f0f0f0full;
+   return static_cast<unsigned>((value * 0x0101010101010101ull) >> 56);
+#endif
+}
+
+/// Summary
+///   Returns the zero based index of the lowest bit that is set in a 64 bit value.
+///   The result is undefined if value is zero.
+inline unsigned index_of_lowest_set_bit(uint64_t value)
+{
+#if defined(_MSC_VER)
+   unsigned long index;
+   if (_BitScanForward(&index, static_cast<unsigned long>(value)))
+      return index;
+   _BitScanForward(&index, static_cast<unsigned long>(value >> 32));
+   return index + 32;
+#else
+   return static_cast<unsigned>(__builtin_ctzll(value));
+#endif
+}
+
+/// Summary
+///   Returns the current value of the high resolution performance counter.
+///   Use performance_counter_frequency to convert differences to seconds.
+inline uint64_t performance_counter()
+{
+#if defined(_WIN32)
+   LARGE_INTEGER counter;
+   QueryPerformanceCounter(&counter);
+   return static_cast<uint64_t>(counter.QuadPart);
+#else
+   return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+/// Summary
+///   Returns the number of performance counter ticks per second.
+inline uint64_t performance_counter_frequency()
+{
+#if defined(_WIN32)
+   LARGE_INTEGER frequency;
+   QueryPerformanceFrequency(&frequency);
+   return static_cast<uint64_t>(frequency.QuadPart);
+#else
+   return static_cast<uint64_t>(std::chrono::steady_clock::period::den / std::chrono::steady_clock::period::num);
+#endif
+}
@@ -0,0 +1,296 @@
+#pragma once
+
+// This file is included by HostVariables.h inside the HostInterop namespace after the variable classes are defined.
+
+    /// Summary:
+    ///     A condition on the variables of a VariableIndex.
+    ///     Scope masks hold the bits of ScopeFlags. A mask of zero places no condition on the scope.
+    struct VariableQuery
+    {
+        VariableQuery() :
+            anyScopes(0), requiredScopes(0), excludedScopes(0), partition(-1), mutability(-1)
+        { }
+
+        uint32_t anyScopes;       // The variable has at least one of these scope bits
+        uint32_t requiredScopes;  // The variable has all of these scope bits
+        uint32_t excludedScopes;  // The variable has none of these scope bits
+        int partition;            // The VariableIndex::Partition the variable must be in, -1 for any or PartitionCount for none
+        int mutability;           // 1 for writable variables only, 0 for read only variables only, -1 for either
+    };
+
+    /// Summary:
+    ///     Secondary indices over a dense array of variable slots.
+    ///     Every index is a bitmap with one bit per slot, so a query is evaluated 64 variables at a time
+    ///     by combining the words of the bitmaps it needs. No per-variable type checks are done when querying the indexed classes,
+    ///     the class partitions are determined with dynamic_cast once when a variable is added.
+    class VariableIndex
+    {
+    public:
+        enum Partition
+        {
+            BoolValue,              // Variable<bool>
+            TextValue,              // Variable<std::string>
+            NumericValue,           // Variable<double>
+            IntegerValue,           // Variable<int>
+            BoolClass,              // BoolVariable
+            TextClass,              // TextVariable
+            NumericClass,           // NumericVariable
+            IntegerClass,           // IntegerVariable
+            BoolType,               // IVariable::Type() == VariableType::Bool
+            TextType,               // IVariable::Type() == VariableType::Text
+            NumericType,            // IVariable::Type() == VariableType::Numeric
+            IntegerType,            // IVariable::Type() == VariableType::Integer
+            PartitionCount
+        };
+
+        static const size_t bits_per_word = 64;
+
+    private:
+        enum Bitmap
+        {
+            FirstScopeBitmap    = 0,
+            FirstPartitionBitmap = FirstScopeBitmap + VariableCache::scope_bit_count,
+            MutableBitmap       = FirstPartitionBitmap + PartitionCount,
+            OccupiedBitmap,
+            BitmapCount
+        };
+
+        std::vector<IVariable*> slots;
+        std::vector<uint64_t> bitmaps[BitmapCount];
+
+        void SetBit(size_t bitmap, size_t slot, bool value)
+        {
+            uint64_t mask = uint64_t(1) << (slot % bits_per_word);
+            auto& word = bitmaps[bitmap][slot / bits_per_word];
+            word = value ? (word | mask) : (word & ~mask);
+        }
+
+        static bool IsPartitionOf(Partition partition, IVariable* variable)
+        {
+            switch (partition)
+            {
+            case BoolValue:     return nullptr != dynamic_cast<Variable<bool>*>(variable);
+            case TextValue:     return nullptr != dynamic_cast<Variable<std::string>*>(variable);
+            case NumericValue:  return nullptr != dynamic_cast<Variable<double>*>(variable);
+            case IntegerValue:  return nullptr != dynamic_cast<Variable<int>*>(variable);
+            case BoolClass:     return nullptr != dynamic_cast<BoolVariable*>(variable);
+            case TextClass:     return nullptr != dynamic_cast<TextVariable*>(variable);
+            case NumericClass:  return nullptr != dynamic_cast<NumericVariable*>(variable);
+            case IntegerClass:  return nullptr != dynamic_cast<IntegerVariable*>(variable);
+            case BoolType:      return VariableType::Bool == variable->Type();
+            case TextType:      return VariableType::Text == variable->Type();
+            case NumericType:   return VariableType::Numeric == variable->Type();
+            case IntegerType:   return VariableType::Integer == variable->Type();
+            default:            return false;
+            }
+        }
+
+    public:
+        static Partition PartitionOf(VariableType type)
+        {
+            switch (type)
+            {
+            case VariableType::Bool:    return BoolType;
+            case VariableType::Text:    return TextType;
+            case VariableType::Numeric: return NumericType;
+            default:                    return IntegerType;
+            }
+        }
+
+        size_t SlotCount() const { return slots.size(); }
+        size_t WordCount() const { return bitmaps[OccupiedBitmap].size(); }
+        IVariable* At(size_t slot) const { return slots[slot]; }
+
+        // Allocates room for slotCount slots at once
+        void Reserve(size_t slotCount)
+        {
+            slots.reserve(slotCount);
+            size_t wordCount = (slotCount + bits_per_word - 1) / bits_per_word;
+            for (auto& bitmap : bitmaps)
+                bitmap.reserve(wordCount);
+        }
+
+        // Stores a variable in a slot and indexes it. A nullptr variable empties the slot.
+        void Set(size_t slot, IVariable* variable)
+        {
+            if (slot >= slots.size())
+            {
+                slots.resize(slot + 1, nullptr);
+                size_t wordCount = (slots.size() + bits_per_word - 1) / bits_per_word;
+                for (auto& bitmap : bitmaps)
+                    bitmap.resize(wordCount, 0);
+            }
+            slots[slot] = variable;
+
+            auto scopeBits = (nullptr == variable) ? 0u : static_cast<uint32_t>(variable->Scope());
+            for (size_t i = 0; i < VariableCache::scope_bit_count; ++i)
+                SetBit(FirstScopeBitmap + i, slot, 0 != (scopeBits & (1u << i)));
+            for (int i = 0; i < PartitionCount; ++i)
+                SetBit(FirstPartitionBitmap + i, slot, nullptr != variable && IsPartitionOf(static_cast<Partition>(i), variable));
+            SetBit(MutableBitmap, slot, nullptr != variable && !variable->IsReadOnly());
+            SetBit(OccupiedBitmap, slot, nullptr != variable);
+        }
+
+        // Returns the bits of the slots in word wordIndex that match the query
+        uint64_t Word(const VariableQuery& query, size_t wordIndex) const
+        {
+            uint64_t word = bitmaps[OccupiedBitmap][wordIndex];
+            if (0 != query.anyScopes)
+            {
+                uint64_t any = 0;
+                for (size_t i = 0; i < VariableCache::scope_bit_count; ++i)
+                {
+                    if (query.anyScopes & (1u << i))
+                        any |= bitmaps[FirstScopeBitmap + i][wordIndex];
+                }
+                word &= any;
+            }
+            for (size_t i = 0; i < VariableCache::scope_bit_count; ++i)
+            {
+                if (query.requiredScopes & (1u << i))
+                    word &= bitmaps[FirstScopeBitmap + i][wordIndex];
+                else if (query.excludedScopes & (1u << i))
+                    word &= ~bitmaps[FirstScopeBitmap + i][wordIndex];
+            }
+            if (query.partition >= PartitionCount)
+                return 0;
+            if (query.partition >= 0)
+                word &= bitmaps[FirstPartitionBitmap + query.partition][wordIndex];
+            if (1 == query.mutability)
+                word &= bitmaps[MutableBitmap][wordIndex];
+            else if (0 == query.mutability)
+                word &= ~bitmaps[MutableBitmap][wordIndex];
+            return word;
+        }
+    };
+
+    /// Summary:
+    ///     The VariableIndex partition that holds exactly the variables that can be used as a T.
+    ///     Only the standard variable classes and Variable<T> of the standard value types are indexed.
+    ///     Queries for any other class scan all variables and keep those that are a T while iterating (see VariableRange).
+    template<typename T> struct variable_partition { static const int value = -1; };
+    template<> struct variable_partition<IVariable>              { static const int value = -1; };
+    template<> struct variable_partition<Variable<bool>>         { static const int value = VariableIndex::BoolValue; };
+    template<> struct variable_partition<Variable<std::string>>  { static const int value = VariableIndex::TextValue; };
+    template<> struct variable_partition<Variable<double>>       { static const int value = VariableIndex::NumericValue; };
+    template<> struct variable_partition<Variable<int>>          { static const int value = VariableIndex::IntegerValue; };
+    template<> struct variable_partition<BoolVariable>           { static const int value = VariableIndex::BoolClass; };
+    template<> struct variable_partition<TextVariable>           { static const int value = VariableIndex::TextClass; };
+    template<> struct variable_partition<NumericVariable>        { static const int value = VariableIndex::NumericClass; };
+    template<> struct variable_partition<IntegerVariable>        { static const int value = VariableIndex::IntegerClass; };
+
+    /// Summary:
+    ///     The variables of a VariableIndex that match a query, evaluated lazily while iterating.
+    ///     Iterating does not allocate memory. The range is invalidated when variables are added to the index.
+    template<typename T>
+    class VariableRange
+    {
+        // Classes without a partition of their own are found with dynamic_cast
+        typedef std::integral_constant<bool, (variable_partition<T>::value < 0 && !std::is_same<T, IVariable>::value)> is_scanned;
+
+        const VariableIndex* index;
+        VariableQuery query;
+
+        static T* Cast(IVariable* variable, std::false_type) { return static_cast<T*>(variable); }
+        static T* Cast(IVariable* variable, std::true_type) { return dynamic_cast<T*>(variable); }
+
+    public:
+        class const_iterator
+        {
+            const VariableIndex* index;
+            VariableQuery query;   // a copy, the iterator may outlive the range
+            size_t wordIndex;
+            uint64_t bits;   // matching slots of the current word that have not been visited yet
+
+            IVariable* Current() const
+            {
+                return index->At(wordIndex * VariableIndex::bits_per_word + index_of_lowest_set_bit(bits));
+            }
+
+            void SkipEmptyWords()
+            {
+                while (0 == bits && ++wordIndex < index->WordCount())
+                    bits = index->Word(query, wordIndex);
+            }
+
+            // Moves to the next matching slot that holds a T
+            void SkipMismatches()
+            {
+                SkipEmptyWords();
+                while (is_scanned::value && 0 != bits && nullptr == Cast(Current(), is_scanned()))
+                {
+                    bits &= bits - 1;
+                    SkipEmptyWords();
+                }
+            }
+
+        public:
+            typedef std::forward_iterator_tag iterator_category;
+            typedef T* value_type;
+            typedef ptrdiff_t difference_type;
+            typedef T* const* pointer;
+            typedef T* reference;
+
+            const_iterator(const VariableIndex* index, const VariableQuery& query, size_t wordIndex) :
+                index(index), query(query), wordIndex(wordIndex), bits(0)
+            {
+                if (wordIndex < index->WordCount())
+                {
+                    bits = index->Word(query, wordIndex);
+                    SkipMismatches();
+                }
+            }
+
+            T* operator*() const
+            {
+                return Cast(Current(), is_scanned());
+            }
+
+            const_iterator& operator++()
+            {
+                bits &= bits - 1; // clear the lowest set bit
+                SkipMismatches();
+                return *this;
+            }
+
+            const_iterator operator++(int)
+            {
+                const_iterator previous(*this);
+                ++(*this);
+                return previous;
+            }
+
+            bool operator==(const const_iterator& rhs) const { return wordIndex == rhs.wordIndex && bits == rhs.bits; }
+            bool operator!=(const const_iterator& rhs) const { return !(*this == rhs); }
+        };
+
+        typedef const_iterator iterator;
+
+        VariableRange(const VariableIndex& index, const VariableQuery& query) :
+            index(&index), query(query)
+        { }
+
+        const_iterator begin() const { return const_iterator(index, query, 0); }
+        const_iterator end() const { return const_iterator(index, query, index->WordCount()); }
+
+        bool empty() const { return begin() == end(); }
+
+        size_t size() const
+        {
+            if (is_scanned::value)
+                return static_cast<size_t>(std::distance(begin(), end()));
+            size_t count = 0;
+            for (size_t i = 0; i < index->WordCount(); ++i)
+                count += count_set_bits(index->Word(query, i));
+            return count;
+        }
+
+        // Copies the matching variables to a vector
+        std::vector<T*> ToVector() const
+        {
+            std::vector<T*> result;
+            result.reserve(size());
+            result.assign(begin(), end());
+            return result;
+        }
+    };
@@ -0,0 +1,538 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include "HostVariables.h"
+#include "MappedFile.h"
+#include "TaskScheduler.h"
+
+namespace HostInterop
+{
+namespace internal // implementation specific namespace not for general usage
+{
+    const uint32_t _JournalMagic = 0x4A565053;     // "SPVJ" in a little endian file
+    const uint16_t _JournalVersion = 1;
+    const size_t _JournalAlignment = 8;
+
+    struct _JournalHeader
+    {
+        uint32_t Magic;
+        uint16_t Version;
+        uint16_t Clean;             // Set by VariableJournal::Close, zero while the journal is in use
+        uint64_t Generation;        // Incremented by every compaction
+        uint64_t Reserved[2];
+    };
+
+    // Followed by the name and the text value, padded to _JournalAlignment
+    struct _JournalRecord
+    {
+        uint32_t Size;              // The whole record with padding. Zero marks the end of the journal
+        uint32_t Checksum;          // CRC-32 of the record after this field
+        uint64_t Sequence;
+        double NumericValue;
+        uint32_t TextLength;
+        uint16_t NameLength;
+        uint8_t Type;               // VariableType
+        uint8_t BoolValue;
+    };
+
+    static_assert(sizeof(_JournalHeader) == 32, "The journal header is part of the file format");
+    static_assert(sizeof(_JournalRecord) == 32, "The journal record is part of the file format");
+
+    struct _JournalValue
+    {
+        _JournalValue() : Sequence(0), Type(VariableType::Numeric), NumericValue(0.0), BoolValue(false)
+        { }
+
+        uint64_t Sequence;
+        VariableType Type;
+        double NumericValue;
+        bool BoolValue;
+        std::string TextValue;
+    };
+
+    typedef std::unordered_map<std::string, _JournalValue> _JournalValues;
+
+    struct _Crc32Table
+    {
+        uint32_t entries[256];
+
+        _Crc32Table()
+        {
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+                uint32_t crc = i;
+                for (int bit = 0; bit < 8; ++bit)
+                    crc = (crc >> 1) ^ ((crc & 1) ? 0xEDB88320u : 0u);
+                entries[i] = crc;
+            }
+        }
+
+        // The table is built on first use, which VariableJournal makes sure happens on the host thread
+        static const uint32_t* Get()
+        {
+            static _Crc32Table table;
+            return table.entries;
+        }
+    };
+
+    static inline uint32_t _Crc32(const uint8_t* data, size_t length)
+    {
+        auto table = _Crc32Table::Get();
+        uint32_t crc = 0xFFFFFFFFu;
+        for (size_t i = 0; i < length; ++i)
+            crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        return ~crc;
+    }
+
+    static inline size_t _JournalRecordSize(size_t nameLength, size_t textLength)
+    {
+        auto size = sizeof(_JournalRecord) + nameLength + textLength;
+        return (size + _JournalAlignment - 1) & ~(_JournalAlignment - 1);
+    }
+
+    // Writes a record into zero filled memory of _JournalRecordSize bytes
+    static inline void _WriteJournalRecord(uint8_t* destination, const std::string& name, const _JournalValue& value)
+    {
+        _JournalRecord record;
+        record.Size = static_cast<uint32_t>(_JournalRecordSize(name.size(), value.TextValue.size()));
+        record.Checksum = 0;
+        record.Sequence = value.Sequence;
+        record.NumericValue = value.NumericValue;
+        record.TextLength = static_cast<uint32_t>(value.TextValue.size());
+        record.NameLength = static_cast<uint16_t>(name.size());
+        record.Type = static_cast<uint8_t>(value.Type);
+        record.BoolValue = value.BoolValue ? 1 : 0;
+        memcpy(destination, &record, sizeof(record));
+        memcpy(destination + sizeof(record), name.data(), name.size());
+        memcpy(destination + sizeof(record) + name.size(), value.TextValue.data(), value.TextValue.size());
+        const size_t checked = offsetof(_JournalRecord, Sequence);
+        record.Checksum = _Crc32(destination + checked, record.Size - checked);
+        memcpy(destination + offsetof(_JournalRecord, Checksum), &record.Checksum, sizeof(record.Checksum));
+    }
+
+    /// Summary:
+    ///     Adds the records of a journal file to values, keeping the record with the highest sequence number
+    ///     of each variable. Reading stops at the end of the journal or the first damaged record.
+    /// Returns:
+    ///     false if the file does not exist or is not a journal
+    static inline bool _ReadJournal(const std::string& fileName, _JournalValues& values, _JournalHeader& header)
+    {
+        MappedFile file;
+        if (!file.Open(fileName) || file.Size() < sizeof(header))
+            return false;
+        memcpy(&header, file.Data(), sizeof(header));
+        if (_JournalMagic != header.Magic || _JournalVersion != header.Version)
+            return false;
+
+        const size_t checked = offsetof(_JournalRecord, Sequence);
+        size_t offset = sizeof(header);
+        while (file.Size() - offset >= sizeof(_JournalRecord))
+        {
+            auto data = file.Data() + offset;
+            _JournalRecord record;
+            memcpy(&record, data, sizeof(record));
+            if (record.Size < sizeof(record) || record.Size > file.Size() - offset ||
+                _JournalRecordSize(record.NameLength, record.TextLength) != record.Size ||
+                record.Type > static_cast<uint8_t>(VariableType::Integer) ||
+                _Crc32(data + checked, record.Size - checked) != record.Checksum)
+                break;
+            offset += record.Size;
+
+            std::string name(reinterpret_cast<const char*>(data + sizeof(record)), record.NameLength);
+            auto& value = values[name];
+            if (value.Sequence > record.Sequence)
+                continue;
+            value.Sequence = record.Sequence;
+            value.Type = static_cast<VariableType>(record.Type);
+            value.NumericValue = record.NumericValue;
+            value.BoolValue = record.BoolValue != 0;
+            value.TextValue.assign(reinterpret_cast<const char*>(data + sizeof(record) + record.NameLength), record.TextLength);
+        }
+        return true;
+    }
+
+    static inline bool _SameJournalValue(const _JournalValue& journaled, const VariableValue& value, VariableType type)
+    {
+        if (journaled.Type != type)
+            return false;
+        switch (type)
+        {
+        case VariableType::Bool:
+            return journaled.BoolValue == value.BoolValue;
+        case VariableType::Text:
+            return journaled.TextValue == value.TextValue;
+        default:
+            return 0 == memcmp(&journaled.NumericValue, &value.NumericValue, sizeof(double));
+        }
+    }
+} // end namespace internal
+
+    struct JournalStats
+    {
+        JournalStats() : Records(0), Unchanged(0), Compactions(0), UsedBytes(0), Capacity(0)
+        { }
+
+        uint64_t Records;               // Records appended since Open
+        uint64_t Unchanged;             // Values passed to Record or Capture that were already journaled
+        uint64_t Compactions;           // Journals rewritten with only the latest value of each variable
+        size_t UsedBytes;               // Bytes of the active journal file in use
+        size_t Capacity;                // Size of the active journal file
+    };
+
+    /// Summary:
+    ///     Keeps the values of mutable variables in an append-only journal, so the state of a session
+    ///     survives a crash of the host. Each changed value is copied into a memory mapped file as one
+    ///     record with a sequence number and a CRC-32, which costs a memcpy and no file I/O.
+    ///     The OS writes the pages to disk, even when the process ends without closing the journal.
+    ///     When the file is three quarters full a compaction writes the latest value of each variable into
+    ///     a second file on a TaskScheduler thread while records are still appended to the first. The next
+    ///     Record switches to the second file and appends the values that changed in the meantime.
+    ///     Open reads both files and keeps the record with the highest sequence number of each variable,
+    ///     so the journal can be recovered at any point of a compaction. Replay sets the recovered values.
+    ///     All methods must be called on the host thread.
+    class VariableJournal
+    {
+        struct Compaction
+        {
+            Compaction() : sequence(0), generation(0), fileSize(0), usedBytes(0)
+            { }
+
+            std::vector<std::pair<std::string, internal::_JournalValue>> values;
+            uint64_t sequence;              // The last sequence number in values
+            uint64_t generation;
+            size_t fileSize;
+            size_t usedBytes;               // Set by the task
+        };
+
+        std::string basePath;
+        size_t minimumCapacity;
+        TaskScheduler* scheduler;
+        MappedFile files[2];
+        int active;                         // The file records are appended to
+        size_t writeOffset;
+        uint64_t generation;
+        uint64_t nextSequence;
+        bool wasClean;
+        internal::_JournalValues latest;    // The journaled value of each variable
+        std::shared_ptr<Compaction> compaction;
+        std::unique_ptr<TaskGroup> compactionGroup;
+        JournalStats stats;
+
+        // no copies allowed. The compaction task refers to this object
+        VariableJournal(const VariableJournal&);
+        VariableJournal& operator = (const VariableJournal&);
+
+        std::string FileName(int file) const
+        {
+            return basePath + (0 == file ? ".0" : ".1");
+        }
+
+        internal::_JournalHeader& ActiveHeader()
+        {
+            return *reinterpret_cast<internal::_JournalHeader*>(files[active].Data());
+        }
+
+        bool TryWrite(const std::string& name, const internal::_JournalValue& value)
+        {
+            auto size = internal::_JournalRecordSize(name.size(), value.TextValue.size());
+            if (files[active].Size() - writeOffset < size)
+                return false;
+            internal::_WriteJournalRecord(files[active].Data() + writeOffset, name, value);
+            writeOffset += size;
+            ++stats.Records;
+            return true;
+        }
+
+        std::shared_ptr<Compaction> NewCompaction(size_t extraBytes)
+        {
+            std::shared_ptr<Compaction> next(new Compaction());
+            next->values.reserve(latest.size());
+            size_t usedBytes = sizeof(internal::_JournalHeader);
+            for (auto& item : latest)
+            {
+                next->values.push_back(item);
+                usedBytes += internal::_JournalRecordSize(item.first.size(), item.second.TextValue.size());
+            }
+            next->sequence = nextSequence - 1;
+            next->generation = generation + 1;
+            // Leave at least as much room for new records as the latest values take
+            next->fileSize = std::max<size_t>(minimumCapacity, 2 * (usedBytes + extraBytes));
+            return next;
+        }
+
+        // Runs on a worker thread for background compactions. Only touches the file that is not active.
+        static void WriteCompaction(MappedFile& file, const std::string& fileName, Compaction& work)
+        {
+            if (!file.Create(fileName, work.fileSize))
+                throw std::runtime_error(std::string("Unable to create the variable journal ").append(fileName));
+            internal::_JournalHeader header;
+            memset(&header, 0, sizeof(header));
+            header.Magic = internal::_JournalMagic;
+            header.Version = internal::_JournalVersion;
+            header.Generation = work.generation;
+            memcpy(file.Data(), &header, sizeof(header));
+            size_t offset = sizeof(header);
+            for (auto& item : work.values)
+            {
+                internal::_WriteJournalRecord(file.Data() + offset, item.first, item.second);
+                offset += internal::_JournalRecordSize(item.first.size(), item.second.TextValue.size());
+            }
+            work.usedBytes = offset;
+        }
+
+        // Makes the file written by a compaction the active file
+        void Activate(const Compaction& work)
+        {
+            files[active].Close();
+            active = 1 - active;
+            writeOffset = work.usedBytes;
+            generation = work.generation;
+            ++stats.Compactions;
+        }
+
+        void StartCompaction()
+        {
+            auto work = NewCompaction(0);
+            auto target = 1 - active;
+            auto file = &files[target];
+            auto fileName = FileName(target);
+            compaction = work;
+            compactionGroup.reset(new TaskGroup(*scheduler));
+            scheduler->Run(*compactionGroup, [file, fileName, work]
+            {
+                WriteCompaction(*file, fileName, *work);
+            });
+        }
+
+        // Waits for the background compaction, switches to its file and appends the values changed since it started
+        void FinishCompaction()
+        {
+            auto work = compaction;
+            compaction.reset();
+            auto group = std::move(compactionGroup);
+            scheduler->Wait(*group);
+            Activate(*work);
+            for (auto& item : latest)
+            {
+                if (item.second.Sequence > work->sequence && !TryWrite(item.first, item.second))
+                {
+                    CompactNow(0);
+                    return;
+                }
+            }
+        }
+
+        // Rewrites the journal on the host thread, with room for extraBytes more
+        void CompactNow(size_t extraBytes)
+        {
+            if (compaction)
+            {
+                // The values of the running compaction are older than the ones written here
+                compaction.reset();
+                auto group = std::move(compactionGroup);
+                try
+                {
+                    scheduler->Wait(*group);
+                }
+                catch (...)
+                {
+                }
+            }
+            auto work = NewCompaction(extraBytes);
+            WriteCompaction(files[1 - active], FileName(1 - active), *work);
+            Activate(*work);
+        }
+
+        void Append(const std::string& name, VariableType type, const VariableValue& value)
+        {
+            if (name.size() > UINT16_MAX)
+                throw std::invalid_argument(std::string("The variable name is too long for the journal: ").append(name));
+            auto& journaled = latest[name];
+            journaled.Sequence = nextSequence++;
+            journaled.Type = type;
+            journaled.NumericValue = (VariableType::Bool == type || VariableType::Text == type) ? 0.0 : value.NumericValue;
+            journaled.BoolValue = VariableType::Bool == type && value.BoolValue;
+            if (VariableType::Text == type)
+                journaled.TextValue = value.TextValue;
+            else
+                journaled.TextValue.clear();
+
+            if (compaction && compactionGroup->IsDone())
+                FinishCompaction();
+            if (!TryWrite(name, journaled))
+            {
+                CompactNow(internal::_JournalRecordSize(name.size(), journaled.TextValue.size()));
+                return;
+            }
+            if (!compaction && writeOffset > files[active].Size() / 4 * 3)
+                StartCompaction();
+        }
+
+    public:
+        explicit VariableJournal(TaskScheduler& taskScheduler = TaskScheduler::Instance()) :
+            minimumCapacity(0), scheduler(&taskScheduler), active(0), writeOffset(0), generation(0), nextSequence(1), wasClean(true)
+        {
+            internal::_Crc32Table::Get();
+        }
+
+        ~VariableJournal()
+        {
+            try
+            {
+                Close();
+            }
+            catch (...)
+            {
+            }
+        }
+
+        /// Summary:
+        ///     Recovers the journal of basePath, or starts an empty one, and starts a new journal file with the
+        ///     recovered values. The files are basePath.0 and basePath.1. The journal open before is closed.
+        /// Arguments:
+        ///     basePath - The path of the journal files without extension
+        ///     capacity - The smallest size of a journal file. It grows when the latest values need more room.
+        /// Throws:
+        ///     runtime_error if the journal file can not be created
+        void Open(const std::string& basePath, size_t capacity = 1024 * 1024)
+        {
+            Close();
+            this->basePath = basePath;
+            minimumCapacity = std::max<size_t>(capacity, 4096);
+            latest.clear();
+            stats = JournalStats();
+
+            internal::_JournalHeader headers[2];
+            bool found[2];
+            for (int file = 0; file < 2; ++file)
+                found[file] = internal::_ReadJournal(FileName(file), latest, headers[file]);
+            int newest = (found[1] && (!found[0] || headers[1].Generation > headers[0].Generation)) ? 1 : 0;
+            wasClean = !found[newest] || 0 != headers[newest].Clean;
+            generation = found[newest] ? headers[newest].Generation : 0;
+            nextSequence = 1;
+            for (auto& item : latest)
+                nextSequence = std::max<uint64_t>(nextSequence, item.second.Sequence + 1);
+
+            // Write the recovered values over the older file, the newest one stays intact until that is done
+            active = newest;
+            CompactNow(0);
+            stats.Compactions = 0;
+        }
+
+        /// Summary:
+        ///     Waits for a running compaction, marks the journal as closed cleanly and closes its files.
+        ///     The journal keeps the values for the next Open.
+        void Close()
+        {
+            if (compaction)
+                FinishCompaction();
+            if (files[active].Data())
+            {
+                ActiveHeader().Clean = 1;
+                files[active].Flush();
+            }
+            files[0].Close();
+            files[1].Close();
+        }
+
+        bool IsOpen() const { return nullptr != files[active].Data(); }
+
+        // true if the journal found by Open was closed with Close, or there was none
+        bool WasClean() const { return wasClean; }
+
+        // The number of variables with a journaled value
+        size_t Size() const { return latest.size(); }
+
+        JournalStats Stats() const
+        {
+            auto current = stats;
+            current.UsedBytes = writeOffset;
+            current.Capacity = files[active].Size();
+            return current;
+        }
+
+        /// Summary:
+        ///     Journals a value read with VariableManager::Fetch if it differs from the journaled value.
+        ///     Values with a Status other than VariableStatus::Ok are ignored.
+        /// Returns:
+        ///     true if a record was appended
+        bool Record(const VariableValue& value)
+        {
+            if (!value.IsValid() || !IsOpen())
+                return false;
+            auto& name = value.Target->Name();
+            auto type = value.Target->Type();
+            auto journaled = latest.find(name);
+            if (latest.end() != journaled && internal::_SameJournalValue(journaled->second, value, type))
+            {
+                ++stats.Unchanged;
+                return false;
+            }
+            Append(name, type, value);
+            return true;
+        }
+
+        /// Summary:
+        ///     Reads the mutable variables of a manager with a single host action and journals the changed ones.
+        /// Returns:
+        ///     The number of records appended
+        size_t Capture(const VariableManager& manager)
+        {
+            if (!IsOpen())
+                return 0;
+            auto values = manager.Fetch(manager.AllMutable().ToVector());
+            size_t appended = 0;
+            for (auto& value : values)
+            {
+                if (Record(value))
+                    ++appended;
+            }
+            return appended;
+        }
+
+        /// Summary:
+        ///     Sets the mutable variables of a manager to their journaled values with a single host action.
+        ///     Variables that were journaled with a different type are skipped.
+        /// Returns:
+        ///     The number of variables set
+        /// Throws:
+        ///     runtime_error if a variable can not be set. The other variables are set.
+        size_t Replay(VariableManager& manager)
+        {
+            std::vector<VariableValue> values;
+            values.reserve(latest.size());
+            for (auto& item : latest)
+            {
+                if (!manager.ContainsVariable(item.first))
+                    continue;
+                auto& variable = manager.GetByName(item.first);
+                if (variable.IsReadOnly() || variable.Type() != item.second.Type)
+                    continue;
+                VariableValue value;
+                value.Target = &variable;
+                value.NumericValue = item.second.NumericValue;
+                value.BoolValue = item.second.BoolValue;
+                value.TextValue = item.second.TextValue;
+                values.push_back(std::move(value));
+            }
+            if (!manager.Store(values))
+            {
+                for (auto& value : values)
+                {
+                    if (!value.IsValid())
+                        throw std::runtime_error(std::string("Error replaying the journaled value of variable (").append(value.Target->Name()).append(")"));
+                }
+            }
+            return values.size();
+        }
+    };
+}
@@ -0,0 +1,260 @@
+#pragma once
+
+// This file is included by HostVariables.h inside the HostInterop namespace after VariableValue is defined.
+
+namespace internal // implementation specific namespace not for general usage
+{
+    const uint32_t _SnapshotMagic = 0x53565053;    // "SPVS" in a little endian file
+    const uint16_t _SnapshotVersion = 1;
+
+    struct _SnapshotHeader
+    {
+        uint32_t Magic;
+        uint16_t Version;
+        uint16_t EntrySize;         // Readers step through the entries by this size so fields can be appended
+        uint32_t EntryCount;
+        uint32_t StringBytes;       // The size of the string table that follows the entries
+    };
+
+    struct _SnapshotEntry
+    {
+        uint32_t NameOffset;        // Offsets are from the start of the string table
+        uint32_t NameLength;
+        uint32_t TextOffset;
+        uint32_t TextLength;
+        double NumericValue;
+        uint8_t Type;               // VariableType
+        uint8_t BoolValue;
+        uint8_t Reserved[6];
+    };
+
+    static_assert(sizeof(_SnapshotHeader) == 16, "The snapshot header is part of the file format");
+    static_assert(sizeof(_SnapshotEntry) == 32, "The snapshot entry is part of the file format");
+
+    static inline bool _IsSnapshotType(uint8_t type)
+    {
+        return type <= static_cast<uint8_t>(VariableType::Integer);
+    }
+} // end namespace internal
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    /// Summary:
+    ///     Builds a snapshot of variable values in memory and writes it to a file with a single write.
+    ///     The file holds a header, one fixed size entry per variable with its type and numeric or Boolean
+    ///     value, and a string table with the names and text values. Numbers are stored in the byte order
+    ///     of the machine, which is little endian on every platform the host runs on.
+    ///     The file is written next to the target and renamed over it, so a failed save leaves the previous snapshot.
+    class SnapshotWriter
+    {
+        std::vector<internal::_SnapshotEntry> entries;
+        std::string strings;
+
+        uint32_t AddString(const std::string& text)
+        {
+            if (strings.size() + text.size() > UINT32_MAX)
+                throw std::runtime_error("The variable snapshot is too large");
+            auto offset = static_cast<uint32_t>(strings.size());
+            strings.append(text);
+            return offset;
+        }
+
+    public:
+        void Reserve(size_t count)
+        {
+            entries.reserve(count);
+            strings.reserve(count * 32);
+        }
+
+        size_t Size() const { return entries.size(); }
+
+        void Clear()
+        {
+            entries.clear();
+            strings.clear();
+        }
+
+        /// Summary:
+        ///     Adds the value of a variable of the given type. Only the member of value that matches the type is stored.
+        void Add(const std::string& name, VariableType type, const VariableValue& value)
+        {
+            internal::_SnapshotEntry entry;
+            memset(&entry, 0, sizeof(entry));
+            entry.NameOffset = AddString(name);
+            entry.NameLength = static_cast<uint32_t>(name.size());
+            entry.Type = static_cast<uint8_t>(type);
+            switch (type)
+            {
+            case VariableType::Bool:
+                entry.BoolValue = value.BoolValue ? 1 : 0;
+                break;
+            case VariableType::Integer:
+            case VariableType::Numeric:
+                entry.NumericValue = value.NumericValue;
+                break;
+            case VariableType::Text:
+                entry.TextOffset = AddString(value.TextValue);
+                entry.TextLength = static_cast<uint32_t>(value.TextValue.size());
+                break;
+            }
+            entries.push_back(entry);
+        }
+
+        // Adds a value read by VariableManager::Fetch under the name and type of its target variable
+        void Add(const VariableValue& value)
+        {
+            Add(value.Target->Name(), value.Target->Type(), value);
+        }
+
+        // Returns the complete file contents
+        std::vector<uint8_t> ToBuffer() const
+        {
+            internal::_SnapshotHeader header;
+            header.Magic = internal::_SnapshotMagic;
+            header.Version = internal::_SnapshotVersion;
+            header.EntrySize = sizeof(internal::_SnapshotEntry);
+            header.EntryCount = static_cast<uint32_t>(entries.size());
+            header.StringBytes = static_cast<uint32_t>(strings.size());
+
+            auto entryBytes = entries.size() * sizeof(internal::_SnapshotEntry);
+            std::vector<uint8_t> buffer(sizeof(header) + entryBytes + strings.size());
+            memcpy(buffer.data(), &header, sizeof(header));
+            if (entryBytes)
+                memcpy(buffer.data() + sizeof(header), entries.data(), entryBytes);
+            if (!strings.empty())
+                memcpy(buffer.data() + sizeof(header) + entryBytes, strings.data(), strings.size());
+            return buffer;
+        }
+
+        /// Summary:
+        ///     Writes the snapshot to a file, replacing the file if it exists.
+        /// Throws:
+        ///     runtime_error if the file can not be written
+        void Save(const std::string& fileName) const
+        {
+            auto buffer = ToBuffer();
+            auto tempName = fileName + ".tmp";
+            auto file = fopen(tempName.c_str(), "wb");
+            if (nullptr == file)
+                throw std::runtime_error(std::string("Unable to create the variable snapshot file ").append(tempName));
+            bool written = fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+            written = (0 == fclose(file)) && written;
+#if defined(_WIN32)
+            written = written && 0 != MoveFileExA(tempName.c_str(), fileName.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+            written = written && 0 == rename(tempName.c_str(), fileName.c_str());
+#endif
+            if (!written)
+            {
+                remove(tempName.c_str());
+                throw std::runtime_error(std::string("Unable to write the variable snapshot file ").append(fileName));
+            }
+        }
+    };
+
+    /// Summary:
+    ///     Reads a file written by SnapshotWriter through a memory mapping. The whole file is validated
+    ///     by Open, after which the entries can be read in any order without further checks.
+    class SnapshotReader
+    {
+        MappedFile file;
+        internal::_SnapshotHeader header;
+        const uint8_t* entries;
+        const char* strings;
+
+        internal::_SnapshotEntry Entry(size_t position) const
+        {
+            if (position >= header.EntryCount)
+                throw std::out_of_range("The snapshot entry is out of range");
+            internal::_SnapshotEntry entry;
+            memcpy(&entry, entries + position * header.EntrySize, sizeof(entry));
+            return entry;
+        }
+
+        void Invalid(const std::string& fileName, const char* reason)
+        {
+            Close();
+            throw std::runtime_error(std::string("The variable snapshot file ").append(fileName).append(" is damaged: ").append(reason));
+        }
+
+    public:
+        SnapshotReader() : entries(nullptr), strings(nullptr)
+        {
+            memset(&header, 0, sizeof(header));
+        }
+
+        /// Summary:
+        ///     Maps and validates a snapshot file.
+        /// Returns:
+        ///     false if the file does not exist or is not a variable snapshot, for example a file written by the host
+        /// Throws:
+        ///     runtime_error if the file is a snapshot that is damaged or of a newer version
+        bool Open(const std::string& fileName)
+        {
+            Close();
+            if (!file.Open(fileName) || file.Size() < sizeof(header))
+            {
+                file.Close();
+                return false;
+            }
+            memcpy(&header, file.Data(), sizeof(header));
+            if (internal::_SnapshotMagic != header.Magic)
+            {
+                Close();
+                return false;
+            }
+            if (internal::_SnapshotVersion != header.Version)
+                Invalid(fileName, "unsupported version");
+            if (header.EntrySize < sizeof(internal::_SnapshotEntry))
+                Invalid(fileName, "bad entry size");
+            uint64_t requiredSize = sizeof(header) + static_cast<uint64_t>(header.EntryCount) * header.EntrySize + header.StringBytes;
+            if (requiredSize > file.Size())
+                Invalid(fileName, "truncated");
+
+            entries = file.Data() + sizeof(header);
+            strings = reinterpret_cast<const char*>(entries + static_cast<size_t>(header.EntryCount) * header.EntrySize);
+            for (size_t i = 0; i < header.EntryCount; ++i)
+            {
+                auto entry = Entry(i);
+                if (static_cast<uint64_t>(entry.NameOffset) + entry.NameLength > header.StringBytes ||
+                    static_cast<uint64_t>(entry.TextOffset) + entry.TextLength > header.StringBytes)
+                    Invalid(fileName, "string out of range");
+                if (!internal::_IsSnapshotType(entry.Type))
+                    Invalid(fileName, "unknown variable type");
+            }
+            return true;
+        }
+
+        void Close()
+        {
+            file.Close();
+            memset(&header, 0, sizeof(header));
+            entries = nullptr;
+            strings = nullptr;
+        }
+
+        bool IsOpen() const { return nullptr != entries; }
+
+        size_t Size() const { return header.EntryCount; }
+
+        std::string Name(size_t position) const
+        {
+            auto entry = Entry(position);
+            return std::string(strings + entry.NameOffset, entry.NameLength);
+        }
+
+        VariableType Type(size_t position) const
+        {
+            return static_cast<VariableType>(Entry(position).Type);
+        }
+
+        /// Summary:
+        ///     Copies the stored value of an entry into the member of value that matches its type.
+        ///     The Target and Status of value are not changed.
+        void ReadValue(size_t position, VariableValue& value) const
+        {
+            auto entry = Entry(position);
+            value.BoolValue = entry.BoolValue != 0;
+            value.NumericValue = entry.NumericValue;
+            value.TextValue.assign(strings + entry.TextOffset, entry.TextLength);
+        }
+    };
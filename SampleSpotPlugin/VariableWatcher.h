@@ -0,0 +1,341 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include "EventDelegate.h"
+#include "MulticastEventDelegate.h"
+#include "HostEvents.h"
+#include "HostVariables.h"
+
+namespace HostInterop
+{
+    /// Summary:
+    ///     The argument of the change event of a VariableWatch.
+    template<typename T>
+    struct VariableChange
+    {
+        VariableChange() : Source(nullptr), PreviousValue(), Value()
+        { }
+
+        Variable<T>* Source;
+        T PreviousValue;
+        T Value;
+    };
+
+namespace internal // implementation specific namespace not for general usage
+{
+    static inline void _WatchedValue(const VariableValue& value, bool& target) { target = value.BoolValue; }
+    static inline void _WatchedValue(const VariableValue& value, double& target) { target = value.NumericValue; }
+    static inline void _WatchedValue(const VariableValue& value, int& target) { target = static_cast<int>(round_to_nearest_awayzero(value.NumericValue)); }
+    static inline void _WatchedValue(const VariableValue& value, std::string& target) { target = value.TextValue; }
+} // end namespace internal
+
+    /// Summary:
+    ///     The sampling state of a variable registered with a VariableWatcher.
+    ///     The interval adapts to how often the variable changes: a sample that finds a new value halves it
+    ///     and a sample that finds the same value lengthens it by a quarter, always within the minimum and
+    ///     maximum interval. A variable that never changes is read once per maximum interval.
+    ///     A failed read lengthens the interval like an unchanged value, so a variable that can not be read
+    ///     is not read on every poll.
+    class IVariableWatch
+    {
+    public:
+        typedef std::chrono::steady_clock clock_t;
+
+    protected:
+        IVariable* target;
+        clock_t::duration minInterval;
+        clock_t::duration maxInterval;
+        clock_t::duration interval;
+        clock_t::time_point due;
+        uint64_t samples;
+        uint64_t changes;
+        uint64_t failures;
+        bool hasValue;
+
+        IVariableWatch(IVariable& variable, clock_t::duration minimum, clock_t::duration maximum) :
+            target(&variable), minInterval(minimum), maxInterval(std::max<clock_t::duration>(minimum, maximum)), interval(minimum),
+            due(), samples(0), changes(0), failures(0), hasValue(false)
+        {
+        }
+
+        void Lengthen(clock_t::time_point now)
+        {
+            interval = std::min<clock_t::duration>(maxInterval, interval + interval / 4 + clock_t::duration(1));
+            due = now + interval;
+        }
+
+        void Adapt(bool changed, clock_t::time_point now)
+        {
+            ++samples;
+            if (changed)
+            {
+                ++changes;
+                interval = std::max<clock_t::duration>(minInterval, interval / 2);
+                due = now + interval;
+            }
+            else
+                Lengthen(now);
+        }
+
+    private:
+        // no copies allowed. The watcher and the delegates refer to this object
+        IVariableWatch(const IVariableWatch&);
+        IVariableWatch& operator = (const IVariableWatch&);
+
+    public:
+        virtual ~IVariableWatch() {}
+
+        /// Summary:
+        ///     Takes a value read from the host. The first value is the baseline and raises no event.
+        /// Returns:
+        ///     true if the value differs from the previous one. The change event is raised by Raise.
+        virtual bool Update(const VariableValue& value, clock_t::time_point now) = 0;
+
+        // Raises the change event for the last value taken by Update
+        virtual void Raise() = 0;
+
+        // Takes a read that failed. The value is kept and the next read is delayed.
+        void ReadFailed(clock_t::time_point now)
+        {
+            ++failures;
+            Lengthen(now);
+        }
+
+        IVariable& Target() const { return *target; }
+        bool IsDue(clock_t::time_point now) const { return now >= due; }
+        clock_t::duration Interval() const { return interval; }
+        clock_t::duration MinInterval() const { return minInterval; }
+        clock_t::duration MaxInterval() const { return maxInterval; }
+        uint64_t Samples() const { return samples; }
+        uint64_t Changes() const { return changes; }
+        uint64_t Failures() const { return failures; }
+        bool HasValue() const { return hasValue; }
+
+        // Samples the variable on the next poll and restarts from the minimum interval
+        void Reset()
+        {
+            interval = minInterval;
+            due = clock_t::time_point();
+        }
+    };
+
+    /// Summary:
+    ///     A variable sampled by a VariableWatcher. The delegates are called on the host thread with a
+    ///     VariableChange<T> each time a sample finds a value different from the previous sample.
+    template<typename T>
+    class VariableWatch : public IVariableWatch
+    {
+    public:
+        typedef VariableChange<T> arg_type;
+
+    private:
+        MulticastEventDelegate<arg_type> changed;
+        arg_type change;
+
+    public:
+        VariableWatch(Variable<T>& variable, clock_t::duration minimum, clock_t::duration maximum) :
+            IVariableWatch(variable, minimum, maximum)
+        {
+            change.Source = &variable;
+        }
+
+        virtual bool Update(const VariableValue& value, clock_t::time_point now)
+        {
+            T current;
+            internal::_WatchedValue(value, current);
+            bool isChange = hasValue && !(current == change.Value);
+            if (isChange)
+                change.PreviousValue = std::move(change.Value);
+            if (!hasValue || isChange)
+                change.Value = std::move(current);
+            Adapt(isChange, now);
+            hasValue = true;
+            return isChange;
+        }
+
+        virtual void Raise()
+        {
+            auto arg = change;
+            changed(arg);
+        }
+
+        Variable<T>& TypedTarget() const { return *change.Source; }
+
+        // The value of the last sample
+        const T& Value() const { return change.Value; }
+
+        void AddDelegate(std::shared_ptr<EventDelegate<arg_type>> d)
+        {
+            changed.AddDelegate(d);
+        }
+
+        void RemoveDelegate(std::shared_ptr<EventDelegate<arg_type>> d)
+        {
+            changed.RemoveDelegate(d);
+        }
+
+        void RemoveDelegate(const EventDelegate<arg_type>* d)
+        {
+            changed.RemoveDelegate(d);
+        }
+    };
+
+    struct VariableWatcherStats
+    {
+        VariableWatcherStats() : Polls(0), HostActions(0), Samples(0), Failures(0), Changes(0)
+        { }
+
+        uint64_t Polls;                 // Calls to Poll, usually one per Idle event
+        uint64_t HostActions;           // Polls that read at least one variable, each with a single host action
+        uint64_t Samples;               // Variable values read
+        uint64_t Failures;              // Variable reads that failed
+        uint64_t Changes;               // Change events raised
+    };
+
+    /// Summary:
+    ///     Samples a set of variables while the host is idle and raises a typed event for each variable
+    ///     whose value changed, so Idle handlers do not have to read and compare values themselves.
+    ///     Each variable is sampled at its own interval that follows its change rate (see IVariableWatch).
+    ///     All variables that are due on a poll are read with a single host action.
+    ///     Start binds Poll to HostEvents::Idle(). All methods must be called on the host thread.
+    class VariableWatcher
+    {
+    public:
+        typedef IVariableWatch::clock_t clock_t;
+
+    private:
+        typedef std::function<void(HostEvents::idle_event_t::arg_type)> idle_func_t;
+
+        const VariableManager* manager;
+        std::vector<std::shared_ptr<IVariableWatch>> watches;
+        std::shared_ptr<EventDelegate<HostEvents::idle_event_t::arg_type>> idleDelegate;
+        VariableWatcherStats stats;
+
+        // no copies allowed. The Idle delegate refers to this object
+        VariableWatcher(const VariableWatcher&);
+        VariableWatcher& operator = (const VariableWatcher&);
+
+    public:
+        /// Arguments:
+        ///     variableManager - Reads the variables. Its cache is updated with the values read.
+        explicit VariableWatcher(const VariableManager& variableManager = VariableManager::StandardVars()) :
+            manager(&variableManager)
+        {
+        }
+
+        ~VariableWatcher()
+        {
+            Stop();
+        }
+
+        /// Summary:
+        ///     Starts sampling a variable. Watching a variable again returns the existing watch.
+        /// Arguments:
+        ///     minInterval - The shortest time between samples, used while the variable changes on every sample
+        ///     maxInterval - The longest time between samples, used while the variable does not change
+        /// Throws:
+        ///     invalid_argument if the variable is already watched with a different type
+        template<typename T>
+        VariableWatch<T>& Watch(Variable<T>& variable,
+            clock_t::duration minInterval = std::chrono::milliseconds(100),
+            clock_t::duration maxInterval = std::chrono::seconds(10))
+        {
+            for (auto& item : watches)
+            {
+                if (&item->Target() != &variable)
+                    continue;
+                auto existing = dynamic_cast<VariableWatch<T>*>(item.get());
+                if (nullptr == existing)
+                    throw std::invalid_argument(std::string("The variable (").append(variable.Name()).append(") is already watched with a different type"));
+                return *existing;
+            }
+            auto watch = std::make_shared<VariableWatch<T>>(variable, minInterval, maxInterval);
+            watches.push_back(watch);
+            return *watch;
+        }
+
+        // Stops sampling a variable. Safe to call from a change delegate.
+        void Unwatch(const IVariable& variable)
+        {
+            watches.erase(std::remove_if(watches.begin(), watches.end(), [&variable] (const std::shared_ptr<IVariableWatch>& item) { return &item->Target() == &variable; }), watches.end());
+        }
+
+        size_t Size() const { return watches.size(); }
+
+        const VariableWatcherStats& Stats() const { return stats; }
+
+        /// Summary:
+        ///     Reads the variables that are due with a single host action and raises the change events.
+        /// Returns:
+        ///     The number of change events raised
+        size_t Poll(clock_t::time_point now)
+        {
+            ++stats.Polls;
+            std::vector<std::shared_ptr<IVariableWatch>> due;
+            for (auto& item : watches)
+            {
+                if (item->IsDue(now))
+                    due.push_back(item);
+            }
+            if (due.empty())
+                return 0;
+
+            std::vector<IVariable*> variables;
+            variables.reserve(due.size());
+            for (auto& item : due)
+                variables.push_back(&item->Target());
+            auto values = manager->Fetch(variables);
+            ++stats.HostActions;
+
+            // All values are taken before any delegate runs, so a delegate sees the new value of every variable
+            std::vector<IVariableWatch*> changed;
+            for (size_t i = 0; i < due.size(); ++i)
+            {
+                if (!values[i].IsValid())
+                {
+                    due[i]->ReadFailed(now);
+                    ++stats.Failures;
+                    continue;
+                }
+                ++stats.Samples;
+                if (due[i]->Update(values[i], now))
+                    changed.push_back(due[i].get());
+            }
+            for (auto item : changed)
+                item->Raise();
+            stats.Changes += changed.size();
+            return changed.size();
+        }
+
+        size_t Poll()
+        {
+            return Poll(clock_t::now());
+        }
+
+        // Polls on every HostEvents::Idle() event
+        void Start()
+        {
+            if (idleDelegate)
+                return;
+            idle_func_t onIdle = [this] (HostEvents::idle_event_t::arg_type) { Poll(); };
+            idleDelegate = make_event_delegate(onIdle);
+            HostEvents::Idle().AddDelegate(idleDelegate);
+        }
+
+        void Stop()
+        {
+            if (!idleDelegate)
+                return;
+            HostEvents::Idle().RemoveDelegate(idleDelegate);
+            idleDelegate.reset();
+        }
+
+        bool IsStarted() const { return nullptr != idleDelegate; }
+    };
+}